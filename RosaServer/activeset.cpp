@@ -0,0 +1,27 @@
+#include "activeset.h"
+#include "engine.h"
+
+namespace ActiveSets {
+ActiveSet<maxNumberOfPlayers> players;
+ActiveSet<maxNumberOfHumans> humans;
+ActiveSet<maxNumberOfItems> items;
+ActiveSet<maxNumberOfVehicles> vehicles;
+ActiveSet<maxNumberOfRigidBodies> bodies;
+ActiveSet<maxNumberOfBonds> bonds;
+
+static bool isPlayerActive(int id) { return Engine::players[id].active; }
+static bool isHumanActive(int id) { return Engine::humans[id].active; }
+static bool isItemActive(int id) { return Engine::items[id].active; }
+static bool isVehicleActive(int id) { return Engine::vehicles[id].active; }
+static bool isBodyActive(int id) { return Engine::bodies[id].active; }
+static bool isBondActive(int id) { return Engine::bonds[id].active; }
+
+void rebuild() {
+	players.rebuild(isPlayerActive);
+	humans.rebuild(isHumanActive);
+	items.rebuild(isItemActive);
+	vehicles.rebuild(isVehicleActive);
+	bodies.rebuild(isBodyActive);
+	bonds.rebuild(isBondActive);
+}
+};  // namespace ActiveSets
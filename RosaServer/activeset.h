@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "structs.h"
+
+// Which slots of a fixed-size engine array are in use, so that they can be
+// counted and walked without touching every slot. Updated from the create and
+// delete hooks, and rebuilt from the engine's own active flags once per tick
+// to catch slots it creates or frees without going through them.
+template <int capacity>
+class ActiveSet {
+	static constexpr int wordCount = (capacity + 63) / 64;
+
+	uint64_t words[wordCount] = {};
+	int count = 0;
+
+ public:
+	bool contains(int id) const { return words[id / 64] >> (id % 64) & 1; }
+	int size() const { return count; }
+
+	void insert(int id) {
+		if (!contains(id)) {
+			words[id / 64] |= uint64_t(1) << (id % 64);
+			count++;
+		}
+	}
+
+	void erase(int id) {
+		if (contains(id)) {
+			words[id / 64] &= ~(uint64_t(1) << (id % 64));
+			count--;
+		}
+	}
+
+	// The first slot in the set after id, or -1 if there is none. Pass -1 to
+	// start from the beginning. id has to be from -1 to capacity - 1.
+	int next(int id) const {
+		int start = id + 1;
+		if (start >= capacity) {
+			return -1;
+		}
+
+		int word = start / 64;
+		uint64_t bits = words[word] & (~uint64_t(0) << (start % 64));
+		while (!bits) {
+			if (++word == wordCount) {
+				return -1;
+			}
+			bits = words[word];
+		}
+		return word * 64 + __builtin_ctzll(bits);
+	}
+
+	// Calls callback(id) for every slot in the set, in ascending order.
+	template <typename Callback>
+	void forEach(Callback&& callback) const {
+		for (int word = 0; word < wordCount; word++) {
+			uint64_t bits = words[word];
+			while (bits) {
+				callback(word * 64 + __builtin_ctzll(bits));
+				bits &= bits - 1;
+			}
+		}
+	}
+
+	// Scans the whole array.
+	template <typename IsActive>
+	void rebuild(IsActive&& isActive) {
+		count = 0;
+		for (int word = 0; word < wordCount; word++) {
+			uint64_t bits = 0;
+			int first = word * 64;
+			int end = capacity - first < 64 ? capacity - first : 64;
+			for (int bit = 0; bit < end; bit++) {
+				if (isActive(first + bit)) {
+					bits |= uint64_t(1) << bit;
+				}
+			}
+			words[word] = bits;
+			count += __builtin_popcountll(bits);
+		}
+	}
+};
+
+namespace ActiveSets {
+extern ActiveSet<maxNumberOfPlayers> players;
+extern ActiveSet<maxNumberOfHumans> humans;
+extern ActiveSet<maxNumberOfItems> items;
+extern ActiveSet<maxNumberOfVehicles> vehicles;
+extern ActiveSet<maxNumberOfRigidBodies> bodies;
+// Bonds have no hooks, this only changes when it is rebuilt and when a bond is
+// made from Lua
+extern ActiveSet<maxNumberOfBonds> bonds;
+
+// Called once per tick, and after anything which may reset the engine arrays.
+// Even the largest arrays are cheap enough to check in full.
+void rebuild();
+};  // namespace ActiveSets
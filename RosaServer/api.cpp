@@ -2,8 +2,17 @@
 #include <algorithm>
 #include <chrono>
 #include <filesystem>
+#include <iomanip>
 #include <limits>
+#include <string>
+#include <unordered_map>
+#include "activeset.h"
+#include "changefeed.h"
 #include "console.h"
+#include "snapshot.h"
+#include "spatialgrid.h"
+#include "workerpool.h"
+#include "ticktimer.h"
 
 bool initialized = false;
 bool shouldReset = false;
@@ -11,12 +20,12 @@ bool shouldReset = false;
 sol::state* lua;
 std::string hookMode;
 
-sol::table* accountDataTables[maxNumberOfAccounts] = {0};
-sol::table* playerDataTables[maxNumberOfPlayers] = {0};
-sol::table* humanDataTables[maxNumberOfHumans] = {0};
-sol::table* itemDataTables[maxNumberOfItems] = {0};
-sol::table* vehicleDataTables[maxNumberOfVehicles] = {0};
-sol::table* bodyDataTables[maxNumberOfRigidBodies] = {0};
+DataTables<maxNumberOfAccounts> accountDataTables;
+DataTables<maxNumberOfPlayers> playerDataTables;
+DataTables<maxNumberOfHumans> humanDataTables;
+DataTables<maxNumberOfItems> itemDataTables;
+DataTables<maxNumberOfVehicles> vehicleDataTables;
+DataTables<maxNumberOfRigidBodies> bodyDataTables;
 
 std::mutex stateResetMutex;
 
@@ -49,24 +58,19 @@ bool noLuaCallError(sol::load_result* res) {
 
 void hookAndReset(int reason) {
 	if (Hooks::enabledKeys[Hooks::EnableKeys::ResetGame]) {
-		bool noParent = false;
-		if (Hooks::run != sol::nil) {
-			auto res = Hooks::run("ResetGame", reason);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = Hooks::dispatch(Hooks::EnableKeys::ResetGame, Hooks::Pre,
+		                                "ResetGame", reason);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&Hooks::resetGameHook);
-				Engine::resetGame();
-			}
-			if (Hooks::run != sol::nil) {
-				auto res = Hooks::run("PostResetGame", reason);
-				noLuaCallError(&res);
-			}
+			Hooks::callOriginal(Hooks::resetGameHook, Engine::resetGame);
+			ActiveSets::rebuild();
+			Lua::accounts::clearPhoneIndex();
+			Hooks::dispatch(Hooks::EnableKeys::ResetGame, Hooks::Post,
+			                "PostResetGame", reason);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&Hooks::resetGameHook);
-		Engine::resetGame();
+		Hooks::callOriginal(Hooks::resetGameHook, Engine::resetGame);
+		ActiveSets::rebuild();
+		Lua::accounts::clearPhoneIndex();
 	}
 }
 
@@ -179,10 +183,15 @@ static inline std::string withoutPostPrefix(std::string name) {
 	return name;
 }
 
+// Keys turned on with hook.enable, which stay on for hook.run after their
+// last handler is removed
+static bool explicitlyEnabled[Hooks::EnableKeys::SIZE];
+
 bool hook::enable(std::string name) {
 	auto search = Hooks::enableNames.find(withoutPostPrefix(name));
 	if (search != Hooks::enableNames.end()) {
-		Hooks::enabledKeys[search->second] = true;
+		explicitlyEnabled[search->second] = true;
+		Hooks::setEnabled(search->second, true);
 		return true;
 	}
 	return false;
@@ -191,7 +200,43 @@ bool hook::enable(std::string name) {
 bool hook::disable(std::string name) {
 	auto search = Hooks::enableNames.find(withoutPostPrefix(name));
 	if (search != Hooks::enableNames.end()) {
-		Hooks::enabledKeys[search->second] = false;
+		explicitlyEnabled[search->second] = false;
+		Hooks::setEnabled(search->second, false);
+		return true;
+	}
+	return false;
+}
+
+bool hook::add(std::string name, sol::protected_function function) {
+	return addPriority(name, function, 0);
+}
+
+bool hook::addPriority(std::string name, sol::protected_function function,
+                       int priority) {
+	auto search = Hooks::enableNames.find(withoutPostPrefix(name));
+	if (search != Hooks::enableNames.end()) {
+		auto phase = name.rfind("Post", 0) == 0 ? Hooks::Post : Hooks::Pre;
+		Hooks::addHandler(search->second, phase, function, priority);
+		Hooks::setEnabled(search->second, true);
+		return true;
+	}
+	return false;
+}
+
+bool hook::remove(std::string name, sol::protected_function function) {
+	auto search = Hooks::enableNames.find(withoutPostPrefix(name));
+	if (search != Hooks::enableNames.end()) {
+		auto key = search->second;
+		auto phase = name.rfind("Post", 0) == 0 ? Hooks::Post : Hooks::Pre;
+		if (!Hooks::removeHandler(key, phase, function)) {
+			return false;
+		}
+
+		// Takes the detour out again once nothing is listening
+		if (!Hooks::handlers[Hooks::Pre][key] &&
+		    !Hooks::handlers[Hooks::Post][key] && !explicitlyEnabled[key]) {
+			Hooks::setEnabled(key, false);
+		}
 		return true;
 	}
 	return false;
@@ -199,15 +244,111 @@ bool hook::disable(std::string name) {
 
 void hook::clear() {
 	for (size_t i = 0; i < Hooks::EnableKeys::SIZE; i++) {
-		Hooks::enabledKeys[i] = false;
+		explicitlyEnabled[i] = false;
+		Hooks::setEnabled(static_cast<Hooks::EnableKeys>(i), false);
+	}
+	Hooks::clearHandlers();
+}
+
+static inline std::string eventName(const std::string& name,
+                                    Hooks::Phase phase) {
+	return phase == Hooks::Post ? "Post" + name : name;
+}
+
+sol::table hook::getStats() {
+	sol::table table = lua->create_table();
+
+	for (const auto& [name, key] : Hooks::enableNames) {
+		for (auto phase : {Hooks::Pre, Hooks::Post}) {
+			const auto& entry = Hooks::stats[phase][key];
+			if (!entry.calls) continue;
+
+			sol::table histogram = lua->create_table();
+			for (int i = 0; i < Hooks::statsHistogramSize; i++) {
+				histogram.add(entry.histogram[i]);
+			}
+
+			sol::table stat = lua->create_table();
+			stat["calls"] = entry.calls;
+			stat["totalMicroseconds"] = entry.totalNanoseconds / 1000.;
+			stat["maxMicroseconds"] = entry.maxNanoseconds / 1000.;
+			stat["histogram"] = histogram;
+			table[eventName(name, phase)] = stat;
+		}
+	}
+
+	return table;
+}
+
+void hook::resetStats() { Hooks::resetStats(); }
+
+static inline sol::table percentilesTable(
+    const TickTimer::Percentiles& percentiles) {
+	sol::table table = lua->create_table();
+	table["p50"] = percentiles.p50;
+	table["p95"] = percentiles.p95;
+	table["p99"] = percentiles.p99;
+	return table;
+}
+
+sol::table tickTimer::getPercentiles() {
+	TickTimer::Percentiles sections[TickTimer::Section::SIZE];
+	TickTimer::Percentiles total;
+	TickTimer::getPercentiles(sections, total);
+
+	sol::table table = lua->create_table();
+	for (int i = 0; i < TickTimer::Section::SIZE; i++) {
+		table[TickTimer::sectionNames[i]] = percentilesTable(sections[i]);
 	}
+	table["Total"] = percentilesTable(total);
+	return table;
+}
+
+unsigned long long tickTimer::getTickCount() { return TickTimer::tickCount; }
+
+unsigned long long tickTimer::getOverrunCount() {
+	return TickTimer::overrunCount;
 }
 
+void hook::printStats() {
+	struct Row {
+		std::string name;
+		const Hooks::Stats* entry;
+	};
+	std::vector<Row> rows;
+
+	for (const auto& [name, key] : Hooks::enableNames) {
+		for (auto phase : {Hooks::Pre, Hooks::Post}) {
+			const auto& entry = Hooks::stats[phase][key];
+			if (entry.calls) rows.push_back({eventName(name, phase), &entry});
+		}
+	}
+
+	std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+		return a.entry->totalNanoseconds > b.entry->totalNanoseconds;
+	});
+
+	std::ostringstream stream;
+	stream << RS_PREFIX "Hook stats (calls, total ms, avg us, max us):\n";
+	stream << std::fixed << std::setprecision(1);
+	for (const auto& row : rows) {
+		stream << "  " << std::left << std::setw(32) << row.name << std::right
+		       << std::setw(10) << row.entry->calls << std::setw(12)
+		       << row.entry->totalNanoseconds / 1'000'000. << std::setw(10)
+		       << row.entry->totalNanoseconds / 1000. / row.entry->calls
+		       << std::setw(10) << row.entry->maxNanoseconds / 1000. << '\n';
+	}
+	Console::log(stream.str());
+}
+
+void hook::setUseTrampolines(bool enabled) { Hooks::useTrampolines = enabled; }
+
 sol::table physics::lineIntersectLevel(Vector* posA, Vector* posB,
                                        bool onlyCity) {
 	sol::table table = lua->create_table();
-	subhook::ScopedHookRemove remove(&Hooks::lineIntersectLevelHook);
-	int res = Engine::lineIntersectLevel(posA, posB, !onlyCity);
+	int res = Hooks::callOriginal(Hooks::lineIntersectLevelHook,
+	                              Engine::lineIntersectLevel, posA, posB,
+	                              !onlyCity);
 	if (res && (!onlyCity || Engine::lineIntersectResult->areaId != -1)) {
 		table["pos"] = Engine::lineIntersectResult->pos;
 		table["normal"] = Engine::lineIntersectResult->normal;
@@ -220,8 +361,9 @@ sol::table physics::lineIntersectLevel(Vector* posA, Vector* posB,
 sol::table physics::lineIntersectHuman(Human* man, Vector* posA, Vector* posB,
                                        float padding) {
 	sol::table table = lua->create_table();
-	subhook::ScopedHookRemove remove(&Hooks::lineIntersectHumanHook);
-	int res = Engine::lineIntersectHuman(man->getIndex(), posA, posB, padding);
+	int res = Hooks::callOriginal(Hooks::lineIntersectHumanHook,
+	                              Engine::lineIntersectHuman, man->getIndex(),
+	                              posA, posB, padding);
 	if (res) {
 		table["pos"] = Engine::lineIntersectResult->pos;
 		table["normal"] = Engine::lineIntersectResult->normal;
@@ -255,8 +397,9 @@ sol::object physics::lineIntersectLevelQuick(Vector* posA, Vector* posB,
                                              bool onlyCity, sol::this_state s) {
 	sol::state_view lua(s);
 
-	subhook::ScopedHookRemove remove(&Hooks::lineIntersectLevelHook);
-	int res = Engine::lineIntersectLevel(posA, posB, !onlyCity);
+	int res = Hooks::callOriginal(Hooks::lineIntersectLevelHook,
+	                              Engine::lineIntersectLevel, posA, posB,
+	                              !onlyCity);
 	if (res && (!onlyCity || Engine::lineIntersectResult->areaId != -1)) {
 		return sol::make_object(lua, Engine::lineIntersectResult->fraction);
 	}
@@ -268,8 +411,9 @@ sol::object physics::lineIntersectHumanQuick(Human* man, Vector* posA,
                                              sol::this_state s) {
 	sol::state_view lua(s);
 
-	subhook::ScopedHookRemove remove(&Hooks::lineIntersectHumanHook);
-	int res = Engine::lineIntersectHuman(man->getIndex(), posA, posB, padding);
+	int res = Hooks::callOriginal(Hooks::lineIntersectHumanHook,
+	                              Engine::lineIntersectHuman, man->getIndex(),
+	                              posA, posB, padding);
 	if (res) {
 		return sol::make_object(lua, Engine::lineIntersectResult->fraction);
 	}
@@ -289,6 +433,161 @@ sol::object physics::lineIntersectVehicleQuick(Vehicle* vehicle, Vector* posA,
 	return sol::make_object(lua, sol::nil);
 }
 
+// Bounding spheres around the object origin, generous enough to contain
+// every limb of a ragdolling human and the longest vehicle
+static constexpr float spatialCellSize = 16.f;
+static constexpr float humanBoundsRadius = 2.f;
+static constexpr float itemBoundsRadius = 0.f;
+static constexpr float vehicleBoundsRadius = 20.f;
+// Past this getNearest stops growing its search and checks everything
+static constexpr float maxNearestRadius = 512.f;
+
+static SpatialGrid humanGrid(spatialCellSize, maxNumberOfHumans);
+static SpatialGrid itemGrid(spatialCellSize, maxNumberOfItems);
+static SpatialGrid vehicleGrid(spatialCellSize, maxNumberOfVehicles);
+static bool isSpatialIndexStale = true;
+
+void physics::markSpatialIndexStale() { isSpatialIndexStale = true; }
+
+static void rebuildSpatialIndex() {
+	humanGrid.clear();
+	ActiveSets::humans.forEach([](int i) {
+		Human* human = &Engine::humans[i];
+		if (human->active) {
+			humanGrid.insert(i, human->pos, humanBoundsRadius);
+		}
+	});
+
+	itemGrid.clear();
+	ActiveSets::items.forEach([](int i) {
+		Item* item = &Engine::items[i];
+		if (item->active) {
+			itemGrid.insert(i, item->pos, itemBoundsRadius);
+		}
+	});
+
+	vehicleGrid.clear();
+	ActiveSets::vehicles.forEach([](int i) {
+		Vehicle* vehicle = &Engine::vehicles[i];
+		if (vehicle->active) {
+			vehicleGrid.insert(i, vehicle->pos, vehicleBoundsRadius);
+		}
+	});
+
+	isSpatialIndexStale = false;
+}
+
+// Squared distances and indices of objects found by a query
+using DistanceList = std::vector<std::pair<double, int>>;
+
+template <typename T>
+static sol::table sortedByDistance(DistanceList& found, T* array) {
+	std::sort(found.begin(), found.end());
+
+	auto arr = lua->create_table(found.size(), 0);
+	for (const auto& entry : found) {
+		arr.add(&array[entry.second]);
+	}
+	return arr;
+}
+
+template <typename T>
+static void collectInRadius(SpatialGrid& grid, T* array, Vector* pos,
+                            float radius, DistanceList& found) {
+	double radiusSquare = static_cast<double>(radius) * radius;
+	grid.forEachNear(*pos, radius, [&](int i) {
+		T* object = &array[i];
+		if (!object->active) return;
+
+		double distSquare = object->pos.distSquare(pos);
+		if (distSquare <= radiusSquare) {
+			found.emplace_back(distSquare, i);
+		}
+	});
+}
+
+template <typename T>
+static sol::table findInRadius(SpatialGrid& grid, T* array, Vector* pos,
+                               float radius) {
+	if (isSpatialIndexStale) {
+		rebuildSpatialIndex();
+	}
+
+	DistanceList found;
+	collectInRadius(grid, array, pos, radius, found);
+	return sortedByDistance(found, array);
+}
+
+template <typename T>
+static sol::table findInBox(SpatialGrid& grid, T* array, Vector* cornerA,
+                            Vector* cornerB) {
+	if (isSpatialIndexStale) {
+		rebuildSpatialIndex();
+	}
+
+	Vector min = {std::min(cornerA->x, cornerB->x),
+	              std::min(cornerA->y, cornerB->y),
+	              std::min(cornerA->z, cornerB->z)};
+	Vector max = {std::max(cornerA->x, cornerB->x),
+	              std::max(cornerA->y, cornerB->y),
+	              std::max(cornerA->z, cornerB->z)};
+	Vector center = {(min.x + max.x) / 2, (min.y + max.y) / 2,
+	                 (min.z + max.z) / 2};
+
+	DistanceList found;
+	grid.forEachInBox(min, max, [&](int i) {
+		T* object = &array[i];
+		if (!object->active) return;
+
+		const Vector& pos = object->pos;
+		if (pos.x >= min.x && pos.x <= max.x && pos.y >= min.y &&
+		    pos.y <= max.y && pos.z >= min.z && pos.z <= max.z) {
+			found.emplace_back(object->pos.distSquare(&center), i);
+		}
+	});
+	return sortedByDistance(found, array);
+}
+
+template <typename T, int capacity>
+static sol::table findNearest(SpatialGrid& grid,
+                              const ActiveSet<capacity>& set, T* array,
+                              Vector* pos, int count) {
+	if (isSpatialIndexStale) {
+		rebuildSpatialIndex();
+	}
+
+	DistanceList found;
+	if (count <= 0) {
+		return sortedByDistance(found, array);
+	}
+	size_t wanted = count;
+
+	// Once a radius holds enough objects, nothing outside it can be nearer
+	if (static_cast<size_t>(set.size()) > wanted) {
+		for (float radius = spatialCellSize;
+		     radius <= maxNearestRadius && found.size() < wanted; radius *= 2) {
+			found.clear();
+			collectInRadius(grid, array, pos, radius, found);
+		}
+	}
+
+	if (found.size() < wanted) {
+		found.clear();
+		set.forEach([&](int i) {
+			T* object = &array[i];
+			if (object->active) {
+				found.emplace_back(object->pos.distSquare(pos), i);
+			}
+		});
+	}
+
+	if (found.size() > wanted) {
+		std::nth_element(found.begin(), found.begin() + wanted, found.end());
+		found.resize(wanted);
+	}
+	return sortedByDistance(found, array);
+}
+
 std::tuple<sol::object, sol::object> physics::lineIntersectAnyQuick(
     Vector* posA, Vector* posB, Human* ignoreHuman, float humanPadding,
     bool includeWheels, sol::this_state s) {
@@ -300,30 +599,32 @@ std::tuple<sol::object, sol::object> physics::lineIntersectAnyQuick(
 	int ignoreHumanId = ignoreHuman ? ignoreHuman->getIndex() : -1;
 	bool didHitLevel = false;
 
-	{
-		subhook::ScopedHookRemove remove(&Hooks::lineIntersectLevelHook);
-		if (Engine::lineIntersectLevel(posA, posB, 1)) {
-			nearestFraction = Engine::lineIntersectResult->fraction;
-			didHitLevel = true;
-		}
+	if (Hooks::callOriginal(Hooks::lineIntersectLevelHook,
+	                        Engine::lineIntersectLevel, posA, posB, 1)) {
+		nearestFraction = Engine::lineIntersectResult->fraction;
+		didHitLevel = true;
 	}
 
-	{
-		subhook::ScopedHookRemove remove(&Hooks::lineIntersectHumanHook);
-		for (int i = 0; i < maxNumberOfHumans; i++) {
-			Human* human = &Engine::humans[i];
-			if (i != ignoreHumanId && human->active &&
-			    Engine::lineIntersectHuman(i, posA, posB, humanPadding)) {
-				float fraction = Engine::lineIntersectResult->fraction;
-				if (fraction < nearestFraction) {
-					nearestFraction = fraction;
-					nearestObject = human;
-				}
+	if (isSpatialIndexStale) {
+		rebuildSpatialIndex();
+	}
+
+	humanGrid.forEachAlongSegment(*posA, *posB, humanPadding, [&](int i) {
+		Human* human = &Engine::humans[i];
+		if (i != ignoreHumanId && human->active &&
+		    Hooks::callOriginal(Hooks::lineIntersectHumanHook,
+		                        Engine::lineIntersectHuman, i, posA, posB,
+		                        humanPadding)) {
+			float fraction = Engine::lineIntersectResult->fraction;
+			if (fraction < nearestFraction) {
+				nearestFraction = fraction;
+				nearestObject = human;
+				nearestIsVehicle = false;
 			}
 		}
-	}
+	});
 
-	for (int i = 0; i < maxNumberOfVehicles; i++) {
+	vehicleGrid.forEachAlongSegment(*posA, *posB, 0.f, [&](int i) {
 		Vehicle* vehicle = &Engine::vehicles[i];
 		if (vehicle->active &&
 		    Engine::lineIntersectVehicle(i, posA, posB, includeWheels)) {
@@ -334,7 +635,7 @@ std::tuple<sol::object, sol::object> physics::lineIntersectAnyQuick(
 				nearestIsVehicle = true;
 			}
 		}
-	}
+	});
 
 	if (nearestObject) {
 		if (nearestIsVehicle) {
@@ -354,6 +655,108 @@ std::tuple<sol::object, sol::object> physics::lineIntersectAnyQuick(
 	return std::make_tuple(sol::nil, sol::nil);
 }
 
+sol::table physics::lineIntersectBatch(sol::table rays) {
+	return lineIntersectBatchOptions(rays, lua->create_table());
+}
+
+sol::table physics::lineIntersectBatchOptions(sol::table rays,
+                                              sol::table options) {
+	size_t size = rays.size();
+	if (size % 6 != 0) {
+		throw std::invalid_argument("Rays must be packed as 6 numbers each");
+	}
+	int count = size / 6;
+
+	bool testLevel = options.get_or("level", true);
+	bool onlyCity = options.get_or("onlyCity", false);
+	bool testHumans = options.get_or("humans", true);
+	float humanPadding = options.get_or("humanPadding", 0.f);
+	bool testVehicles = options.get_or("vehicles", true);
+	bool includeWheels = options.get_or("includeWheels", false);
+
+	int ignoreHumanId = -1;
+	sol::object ignoreHuman = options["ignoreHuman"];
+	if (ignoreHuman.is<Human*>()) {
+		ignoreHumanId = ignoreHuman.as<Human*>()->getIndex();
+	}
+
+	if ((testHumans || testVehicles) && isSpatialIndexStale) {
+		rebuildSpatialIndex();
+	}
+
+	sol::table fractions = lua->create_table(count, 0);
+	sol::table types = lua->create_table(count, 0);
+	sol::table indices = lua->create_table(count, 0);
+	sol::table normals = lua->create_table(count * 3, 0);
+
+	for (int ray = 0; ray < count; ray++) {
+		int offset = ray * 6;
+		Vector posA = {rays.raw_get<float>(offset + 1),
+		               rays.raw_get<float>(offset + 2),
+		               rays.raw_get<float>(offset + 3)};
+		Vector posB = {rays.raw_get<float>(offset + 4),
+		               rays.raw_get<float>(offset + 5),
+		               rays.raw_get<float>(offset + 6)};
+
+		float nearestFraction = 1.f;
+		int nearestType = HitNone;
+		int nearestIndex = -1;
+		Vector nearestNormal = {0.f, 0.f, 0.f};
+
+		auto consider = [&](int type, int index) {
+			float fraction = Engine::lineIntersectResult->fraction;
+			if (nearestType == HitNone || fraction < nearestFraction) {
+				nearestFraction = fraction;
+				nearestType = type;
+				nearestIndex = index;
+				nearestNormal = Engine::lineIntersectResult->normal;
+			}
+		};
+
+		if (testLevel && Hooks::callOriginal(Hooks::lineIntersectLevelHook,
+		                                     Engine::lineIntersectLevel, &posA,
+		                                     &posB, !onlyCity)) {
+			if (!onlyCity || Engine::lineIntersectResult->areaId != -1) {
+				consider(HitLevel, -1);
+			}
+		}
+
+		if (testHumans) {
+			humanGrid.forEachAlongSegment(posA, posB, humanPadding, [&](int i) {
+				if (i != ignoreHumanId && Engine::humans[i].active &&
+				    Hooks::callOriginal(Hooks::lineIntersectHumanHook,
+				                        Engine::lineIntersectHuman, i, &posA,
+				                        &posB, humanPadding)) {
+					consider(HitHuman, i);
+				}
+			});
+		}
+
+		if (testVehicles) {
+			vehicleGrid.forEachAlongSegment(posA, posB, 0.f, [&](int i) {
+				if (Engine::vehicles[i].active &&
+				    Engine::lineIntersectVehicle(i, &posA, &posB, includeWheels)) {
+					consider(HitVehicle, i);
+				}
+			});
+		}
+
+		fractions.raw_set(ray + 1, nearestFraction);
+		types.raw_set(ray + 1, nearestType);
+		indices.raw_set(ray + 1, nearestIndex);
+		normals.raw_set(ray * 3 + 1, nearestNormal.x, ray * 3 + 2,
+		                nearestNormal.y, ray * 3 + 3, nearestNormal.z);
+	}
+
+	sol::table table = lua->create_table();
+	table["count"] = count;
+	table["fraction"] = fractions;
+	table["type"] = types;
+	table["index"] = indices;
+	table["normal"] = normals;
+	return table;
+}
+
 sol::object physics::lineIntersectTriangle(Vector* outPos, Vector* normal,
                                            Vector* posA, Vector* posB,
                                            Vector* triA, Vector* triB,
@@ -373,13 +776,328 @@ void physics::garbageCollectBullets() { Engine::bulletTimeToLive(); }
 void physics::createBlock(int blockX, int blockY, int blockZ,
                           unsigned int flags) {
 	short unk[8] = {15, 15, 15, 15, 15, 15, 15, 15};
-	subhook::ScopedHookRemove remove(&Hooks::areaCreateBlockHook);
-	Engine::areaCreateBlock(0, blockX, blockY, blockZ, flags, unk);
+	Hooks::callOriginal(Hooks::areaCreateBlockHook, Engine::areaCreateBlock, 0,
+	                    blockX, blockY, blockZ, flags, unk);
 }
 
 void physics::deleteBlock(int blockX, int blockY, int blockZ) {
-	subhook::ScopedHookRemove remove(&Hooks::areaDeleteBlockHook);
-	Engine::areaDeleteBlock(0, blockX, blockY, blockZ);
+	Hooks::callOriginal(Hooks::areaDeleteBlockHook, Engine::areaDeleteBlock, 0,
+	                    blockX, blockY, blockZ);
+}
+
+// Userdata for every slot of an engine array, made the first time the slot is
+// iterated over and pushed again after that, so that loops over entities
+// don't leave garbage behind
+template <typename T, int capacity>
+class ProxyCache {
+	sol::object* proxies[capacity] = {};
+	sol::object* iterator = nullptr;
+
+ public:
+	const sol::object& get(T* array, int index) {
+		if (!proxies[index]) {
+			proxies[index] = new sol::object(sol::make_object(*lua, &array[index]));
+		}
+		return *proxies[index];
+	}
+
+	template <typename Next>
+	const sol::object& getIterator(Next next) {
+		if (!iterator) {
+			iterator = new sol::object(sol::make_object(*lua, next));
+		}
+		return *iterator;
+	}
+
+	void clear() {
+		for (int i = 0; i < capacity; i++) {
+			delete proxies[i];
+			proxies[i] = nullptr;
+		}
+		delete iterator;
+		iterator = nullptr;
+	}
+};
+
+static ProxyCache<Player, maxNumberOfPlayers> playerProxies;
+static ProxyCache<Human, maxNumberOfHumans> humanProxies;
+static ProxyCache<Item, maxNumberOfItems> itemProxies;
+static ProxyCache<Vehicle, maxNumberOfVehicles> vehicleProxies;
+static ProxyCache<RigidBody, maxNumberOfRigidBodies> bodyProxies;
+
+void clearProxyCaches() {
+	playerProxies.clear();
+	humanProxies.clear();
+	itemProxies.clear();
+	vehicleProxies.clear();
+	bodyProxies.clear();
+}
+
+// Index and proxy of the next active slot, or nil to end a for loop
+using ProxyIteration = std::tuple<sol::optional<int>, sol::object>;
+
+template <typename T, int capacity>
+static ProxyIteration nextActive(const ActiveSet<capacity>& set,
+                                 ProxyCache<T, capacity>& cache, T* array,
+                                 int index) {
+	// The control value comes back from Lua, so it can be anything
+	if (index < -1 || index >= capacity) {
+		throw std::invalid_argument(errorOutOfRange);
+	}
+
+	for (int i = set.next(index); i != -1; i = set.next(i)) {
+		if (array[i].active) {
+			return std::make_tuple(i, cache.get(array, i));
+		}
+	}
+	return std::make_tuple(sol::nullopt, sol::object(sol::lua_nil));
+}
+
+static const ChangeFeed::Field* findChangeField(const char* kindName,
+                                                const char* fieldName,
+                                                ChangeFeed::Kind& kind) {
+	for (int i = 0; i < ChangeFeed::Kind::SIZE; i++) {
+		if (!std::strcmp(kindName, ChangeFeed::kindNames[i])) {
+			kind = static_cast<ChangeFeed::Kind>(i);
+			auto field = ChangeFeed::findField(kind, fieldName);
+			if (!field) {
+				throw std::invalid_argument("Unknown field");
+			}
+			return field;
+		}
+	}
+	throw std::invalid_argument("Unknown entity kind");
+}
+
+void changes::watch(const char* kindName, const char* fieldName) {
+	ChangeFeed::Kind kind;
+	auto field = findChangeField(kindName, fieldName, kind);
+	ChangeFeed::watch(kind, field);
+}
+
+void changes::unwatch(const char* kindName, const char* fieldName) {
+	ChangeFeed::Kind kind;
+	auto field = findChangeField(kindName, fieldName, kind);
+	ChangeFeed::unwatch(kind, field);
+}
+
+static sol::object changeValue(ChangeFeed::FieldType type,
+                               const ChangeFeed::Value& value) {
+	switch (type) {
+		case ChangeFeed::Int:
+			return sol::make_object(*lua, value.i);
+		case ChangeFeed::UnsignedInt:
+			return sol::make_object(*lua, value.u);
+		case ChangeFeed::Float:
+			return sol::make_object(*lua, value.f);
+		default:
+			return sol::make_object(*lua, value.v);
+	}
+}
+
+static sol::object changeEntity(ChangeFeed::Kind kind, int index) {
+	switch (kind) {
+		case ChangeFeed::Players:
+			return playerProxies.get(Engine::players, index);
+		case ChangeFeed::Humans:
+			return humanProxies.get(Engine::humans, index);
+		case ChangeFeed::Items:
+			return itemProxies.get(Engine::items, index);
+		default:
+			return vehicleProxies.get(Engine::vehicles, index);
+	}
+}
+
+sol::table changes::poll() {
+	auto& list = ChangeFeed::getChanges();
+
+	auto arr = lua->create_table(list.size(), 0);
+	for (const auto& change : list) {
+		auto record = lua->create_table(0, 4);
+		record["entity"] = changeEntity(change.kind, change.index);
+		record["field"] = change.field->name;
+		record["old"] = changeValue(change.field->type, change.oldValue);
+		record["new"] = changeValue(change.field->type, change.newValue);
+		arr.add(record);
+	}
+
+	list.clear();
+	return arr;
+}
+
+void changes::clear() { ChangeFeed::reset(); }
+
+const char* const async::awaitSource = R"(
+return function (future)
+	if not future:isReady() then
+		local co, isMain = coroutine.running()
+		if not co or isMain then
+			error('async.await must be called from a coroutine', 2)
+		end
+
+		future:resumeWhenReady(co)
+		repeat
+			coroutine.yield()
+		until future:isReady()
+	end
+
+	return future:get()
+end
+)";
+
+// Started on the first async.run
+static WorkerPool* asyncPool = nullptr;
+static std::unordered_map<unsigned int, std::shared_ptr<Future::State>>
+    pendingFutures;
+
+Future async::run(const char* moduleName, const char* functionName,
+                  sol::variadic_args args) {
+	if (!asyncPool) {
+		int numThreads = std::max(1u, std::thread::hardware_concurrency() / 2);
+		asyncPool = new WorkerPool(numThreads);
+	}
+
+	unsigned int id = asyncPool->submit(moduleName, functionName, args);
+
+	Future future;
+	pendingFutures[id] = future.state;
+	return future;
+}
+
+void async::update() {
+	if (!asyncPool) {
+		return;
+	}
+
+	unsigned int id;
+	bool success;
+	std::vector<sol::object> values;
+	while (asyncPool->takeResult(*lua, id, success, values)) {
+		auto search = pendingFutures.find(id);
+		if (search == pendingFutures.end()) {
+			continue;
+		}
+
+		auto state = search->second;
+		pendingFutures.erase(search);
+
+		state->isReady = true;
+		state->success = success;
+		state->values = std::move(values);
+		values.clear();
+
+		auto waiting = std::move(state->waiting);
+		state->waiting.clear();
+
+		sol::protected_function resume = (*lua)["coroutine"]["resume"];
+		for (const auto& coroutine : waiting) {
+			auto res = resume(coroutine);
+			if (noLuaCallError(&res) && !res.get<bool>(0)) {
+				sol::error err(res.get<std::string>(1));
+				printLuaError(&err);
+			}
+		}
+	}
+}
+
+void async::reset() {
+	delete asyncPool;
+	asyncPool = nullptr;
+	pendingFutures.clear();
+}
+
+// Reused by every gather call, Lua copies it into the returned string
+static std::string gatherBuffer;
+
+template <typename Find>
+static Snapshot::Layout toLayout(sol::table fields, Find find) {
+	Snapshot::Layout layout;
+	layout.reserve(fields.size());
+	for (size_t i = 1; i <= fields.size(); i++) {
+		std::string name = fields[i];
+		auto field = find(name.c_str());
+		if (!field) {
+			throw std::invalid_argument("Unknown field");
+		}
+		layout.push_back(field);
+	}
+	return layout;
+}
+
+static GatherResult gatherKind(ChangeFeed::Kind kind, sol::table fields) {
+	auto layout = toLayout(fields, [kind](const char* name) {
+		return ChangeFeed::findField(kind, name);
+	});
+	int count = Snapshot::gather(kind, layout, gatherBuffer);
+	return std::make_tuple(std::string_view(gatherBuffer), count);
+}
+
+GatherResult players::gather(sol::table fields) {
+	return gatherKind(ChangeFeed::Players, fields);
+}
+
+GatherResult humans::gather(sol::table fields) {
+	return gatherKind(ChangeFeed::Humans, fields);
+}
+
+GatherResult humans::gatherBones(sol::table fields) {
+	auto layout = toLayout(fields, Snapshot::findBoneField);
+	int count = Snapshot::gatherBones(layout, gatherBuffer);
+	return std::make_tuple(std::string_view(gatherBuffer), count);
+}
+
+GatherResult items::gather(sol::table fields) {
+	return gatherKind(ChangeFeed::Items, fields);
+}
+
+GatherResult vehicles::gather(sol::table fields) {
+	return gatherKind(ChangeFeed::Vehicles, fields);
+}
+
+GatherResult bullets::gather(sol::table fields) {
+	auto layout = toLayout(fields, Snapshot::findBulletField);
+	int count = Snapshot::gatherBullets(layout, gatherBuffer);
+	return std::make_tuple(std::string_view(gatherBuffer), count);
+}
+
+// Name to index, built on the first lookup and rebuilt only once a type turns
+// out to have been renamed
+static std::unordered_map<std::string, int> itemTypeNames;
+static std::unordered_map<std::string, int> vehicleTypeNames;
+
+template <typename T>
+static void indexTypeNames(std::unordered_map<std::string, int>& index,
+                           T* types, int count) {
+	index.clear();
+	for (int i = 0; i < count; i++) {
+		index.emplace(types[i].name, i);
+	}
+}
+
+template <typename T>
+static T* findTypeByName(std::unordered_map<std::string, int>& index,
+                         T* types, int count, const char* name) {
+	if (index.empty()) {
+		indexTypeNames(index, types, count);
+	}
+
+	auto search = index.find(name);
+	if (search != index.end() &&
+	    !std::strcmp(name, types[search->second].name)) {
+		return &types[search->second];
+	}
+
+	// Unknown names cost a plain scan, and only a rename rebuilds the index
+	for (int i = 0; i < count; i++) {
+		if (!std::strcmp(name, types[i].name)) {
+			indexTypeNames(index, types, count);
+			return &types[i];
+		}
+	}
+	if (search != index.end()) {
+		indexTypeNames(index, types, count);
+	}
+	return nullptr;
 }
 
 int itemTypes::getCount() { return maxNumberOfItemTypes; }
@@ -398,33 +1116,48 @@ ItemType* itemTypes::getByIndex(sol::table self, unsigned int idx) {
 }
 
 ItemType* itemTypes::getByName(const char* name) {
-	for (int i = 0; i < maxNumberOfItemTypes; i++) {
-		ItemType* type = &Engine::itemTypes[i];
-		if (!std::strcmp(name, type->name)) {
-			return type;
-		}
-	}
-	return nullptr;
+	return findTypeByName(itemTypeNames, Engine::itemTypes, maxNumberOfItemTypes,
+	                      name);
 }
 
 int items::getCount() {
 	int count = 0;
-	for (int i = 0; i < maxNumberOfItems; i++) {
-		if ((&Engine::items[i])->active) count++;
-	}
+	ActiveSets::items.forEach([&](int i) {
+		if (Engine::items[i].active) count++;
+	});
 	return count;
 }
 
 sol::table items::getAll() {
-	auto arr = lua->create_table();
-	for (int i = 0; i < maxNumberOfItems; i++) {
+	auto arr = lua->create_table(ActiveSets::items.size(), 0);
+	ActiveSets::items.forEach([&](int i) {
 		auto item = &Engine::items[i];
-		if (!item->active) continue;
-		arr.add(item);
-	}
+		if (item->active) arr.add(item);
+	});
 	return arr;
 }
 
+static ProxyIteration nextItem(sol::object, int index) {
+	return nextActive(ActiveSets::items, itemProxies, Engine::items, index);
+}
+
+std::tuple<sol::object, sol::object, int> items::iterActive() {
+	return std::make_tuple(itemProxies.getIterator(nextItem),
+	                       sol::object(sol::lua_nil), -1);
+}
+
+sol::table items::getInRadius(Vector* pos, float radius) {
+	return findInRadius(itemGrid, Engine::items, pos, radius);
+}
+
+sol::table items::getInBox(Vector* cornerA, Vector* cornerB) {
+	return findInBox(itemGrid, Engine::items, cornerA, cornerB);
+}
+
+sol::table items::getNearest(Vector* pos, int count) {
+	return findNearest(itemGrid, ActiveSets::items, Engine::items, pos, count);
+}
+
 Item* items::getByIndex(sol::table self, unsigned int idx) {
 	if (idx >= maxNumberOfItems) throw std::invalid_argument(errorOutOfRange);
 	return &Engine::items[idx];
@@ -440,12 +1173,13 @@ Item* items::createVel(ItemType* type, Vector* pos, Vector* vel,
 		throw std::invalid_argument("Cannot create item with nil type");
 	}
 
-	subhook::ScopedHookRemove remove(&Hooks::createItemHook);
-	int id = Engine::createItem(type->getIndex(), pos, vel, rot);
-
-	if (id != -1 && itemDataTables[id]) {
-		delete itemDataTables[id];
-		itemDataTables[id] = nullptr;
+	int id = Hooks::callOriginal(Hooks::createItemHook, Engine::createItem,
+	                             type->getIndex(), pos, vel, rot);
+	if (id != -1) {
+		ActiveSets::items.insert(id);
+		physics::markSpatialIndexStale();
+		itemDataTables.clear(id);
+		ChangeFeed::forget(ChangeFeed::Items, id);
 	}
 
 	return id == -1 ? nullptr : &Engine::items[id];
@@ -453,6 +1187,11 @@ Item* items::createVel(ItemType* type, Vector* pos, Vector* vel,
 
 Item* items::createRope(Vector* pos, RotMatrix* rot) {
 	int id = Engine::createRope(pos, rot);
+	if (id != -1) {
+		ActiveSets::items.insert(id);
+		physics::markSpatialIndexStale();
+		ChangeFeed::forget(ChangeFeed::Items, id);
+	}
 	return id == -1 ? nullptr : &Engine::items[id];
 }
 
@@ -473,33 +1212,50 @@ VehicleType* vehicleTypes::getByIndex(sol::table self, unsigned int idx) {
 }
 
 VehicleType* vehicleTypes::getByName(const char* name) {
-	for (int i = 0; i < maxNumberOfVehicleTypes; i++) {
-		VehicleType* type = &Engine::vehicleTypes[i];
-		if (!std::strcmp(name, type->name)) {
-			return type;
-		}
-	}
-	return nullptr;
+	return findTypeByName(vehicleTypeNames, Engine::vehicleTypes,
+	                      maxNumberOfVehicleTypes, name);
 }
 
 int vehicles::getCount() {
 	int count = 0;
-	for (int i = 0; i < maxNumberOfVehicles; i++) {
-		if ((&Engine::vehicles[i])->active) count++;
-	}
+	ActiveSets::vehicles.forEach([&](int i) {
+		if (Engine::vehicles[i].active) count++;
+	});
 	return count;
 }
 
 sol::table vehicles::getAll() {
-	auto arr = lua->create_table();
-	for (int i = 0; i < maxNumberOfVehicles; i++) {
+	auto arr = lua->create_table(ActiveSets::vehicles.size(), 0);
+	ActiveSets::vehicles.forEach([&](int i) {
 		auto vcl = &Engine::vehicles[i];
-		if (!vcl->active) continue;
-		arr.add(vcl);
-	}
+		if (vcl->active) arr.add(vcl);
+	});
 	return arr;
 }
 
+static ProxyIteration nextVehicle(sol::object, int index) {
+	return nextActive(ActiveSets::vehicles, vehicleProxies, Engine::vehicles,
+	                  index);
+}
+
+std::tuple<sol::object, sol::object, int> vehicles::iterActive() {
+	return std::make_tuple(vehicleProxies.getIterator(nextVehicle),
+	                       sol::object(sol::lua_nil), -1);
+}
+
+sol::table vehicles::getInRadius(Vector* pos, float radius) {
+	return findInRadius(vehicleGrid, Engine::vehicles, pos, radius);
+}
+
+sol::table vehicles::getInBox(Vector* cornerA, Vector* cornerB) {
+	return findInBox(vehicleGrid, Engine::vehicles, cornerA, cornerB);
+}
+
+sol::table vehicles::getNearest(Vector* pos, int count) {
+	return findNearest(vehicleGrid, ActiveSets::vehicles, Engine::vehicles, pos,
+	                   count);
+}
+
 Vehicle* vehicles::getByIndex(sol::table self, unsigned int idx) {
 	if (idx >= maxNumberOfVehicles) throw std::invalid_argument(errorOutOfRange);
 	return &Engine::vehicles[idx];
@@ -516,12 +1272,13 @@ Vehicle* vehicles::createVel(VehicleType* type, Vector* pos, Vector* vel,
 		throw std::invalid_argument("Cannot create vehicle with nil type");
 	}
 
-	subhook::ScopedHookRemove remove(&Hooks::createVehicleHook);
-	int id = Engine::createVehicle(type->getIndex(), pos, vel, rot, color);
-
-	if (id != -1 && vehicleDataTables[id]) {
-		delete vehicleDataTables[id];
-		vehicleDataTables[id] = nullptr;
+	int id = Hooks::callOriginal(Hooks::createVehicleHook, Engine::createVehicle,
+	                             type->getIndex(), pos, vel, rot, color);
+	if (id != -1) {
+		ActiveSets::vehicles.insert(id);
+		physics::markSpatialIndexStale();
+		vehicleDataTables.clear(id);
+		ChangeFeed::forget(ChangeFeed::Vehicles, id);
 	}
 
 	return id == -1 ? nullptr : &Engine::vehicles[id];
@@ -536,8 +1293,8 @@ Event* chat::tellAdmins(const char* message) {
 }
 
 void accounts::save() {
-	subhook::ScopedHookRemove remove(&Hooks::saveAccountsServerHook);
-	Engine::saveAccountsServer();
+	Hooks::callOriginal(Hooks::saveAccountsServerHook,
+	                    Engine::saveAccountsServer);
 }
 
 int accounts::getCount() {
@@ -560,13 +1317,41 @@ sol::table accounts::getAll() {
 	return arr;
 }
 
-Account* accounts::getByPhone(int phone) {
-	for (int i = 0;; i++) {
-		Account* acc = &Engine::accounts[i];
+// Accounts are only ever appended, so the index catches up with new ones
+// from where it left off. Misses and stale hits rebuild it, since phone
+// numbers can be changed underneath it.
+static std::unordered_map<int, int> accountPhones;
+static int indexedAccounts = 0;
+
+static void indexNewAccounts() {
+	for (; indexedAccounts < maxNumberOfAccounts; indexedAccounts++) {
+		Account* acc = &Engine::accounts[indexedAccounts];
 		if (!acc->subRosaID) break;
-		if (acc->phoneNumber == phone) return acc;
+		accountPhones.emplace(acc->phoneNumber, indexedAccounts);
 	}
-	return nullptr;
+}
+
+void accounts::clearPhoneIndex() {
+	accountPhones.clear();
+	indexedAccounts = 0;
+}
+
+Account* accounts::getByPhone(int phone) {
+	indexNewAccounts();
+
+	auto search = accountPhones.find(phone);
+	if (search != accountPhones.end()) {
+		Account* acc = &Engine::accounts[search->second];
+		if (acc->subRosaID && acc->phoneNumber == phone) return acc;
+	}
+
+	// A miss may be a number written through ffi or memory since indexing
+	clearPhoneIndex();
+	indexNewAccounts();
+
+	search = accountPhones.find(phone);
+	return search == accountPhones.end() ? nullptr
+	                                     : &Engine::accounts[search->second];
 }
 
 Account* accounts::getByIndex(sol::table self, unsigned int idx) {
@@ -576,65 +1361,83 @@ Account* accounts::getByIndex(sol::table self, unsigned int idx) {
 
 int players::getCount() {
 	int count = 0;
-	for (int i = 0; i < maxNumberOfPlayers; i++) {
-		if ((&Engine::players[i])->active) count++;
-	}
+	ActiveSets::players.forEach([&](int i) {
+		if (Engine::players[i].active) count++;
+	});
 	return count;
 }
 
 sol::table players::getAll() {
-	auto arr = lua->create_table();
-	for (int i = 0; i < maxNumberOfPlayers; i++) {
+	auto arr = lua->create_table(ActiveSets::players.size(), 0);
+	ActiveSets::players.forEach([&](int i) {
 		auto ply = &Engine::players[i];
-		if (!ply->active) continue;
-		arr.add(ply);
-	}
+		if (ply->active) arr.add(ply);
+	});
 	return arr;
 }
 
+// Phone numbers are given to players by the engine after they are created,
+// so this is rebuilt whenever a lookup misses or finds a stale slot
+static std::unordered_map<unsigned int, int> playerPhones;
+
 Player* players::getByPhone(int phone) {
-	for (int i = 0; i < maxNumberOfPlayers; i++) {
-		auto ply = &Engine::players[i];
-		if (!ply->active) continue;
-		if (ply->phoneNumber == phone) return ply;
+	auto search = playerPhones.find(phone);
+	if (search != playerPhones.end()) {
+		auto ply = &Engine::players[search->second];
+		if (ply->active && ply->phoneNumber == phone) return ply;
 	}
-	return nullptr;
+
+	playerPhones.clear();
+	Player* found = nullptr;
+	ActiveSets::players.forEach([&](int i) {
+		auto ply = &Engine::players[i];
+		if (!ply->active) return;
+		playerPhones.emplace(ply->phoneNumber, i);
+		if (!found && ply->phoneNumber == phone) found = ply;
+	});
+	return found;
 }
 
 sol::table players::getNonBots() {
 	auto arr = lua->create_table();
-	for (int i = 0; i < maxNumberOfPlayers; i++) {
+	ActiveSets::players.forEach([&](int i) {
 		auto ply = &Engine::players[i];
-		if (!ply->active || !ply->subRosaID || ply->isBot) continue;
-		arr.add(ply);
-	}
+		if (ply->active && ply->subRosaID && !ply->isBot) arr.add(ply);
+	});
 	return arr;
 }
 
 sol::table players::getBots() {
 	auto arr = lua->create_table();
-	for (int i = 0; i < maxNumberOfPlayers; i++) {
+	ActiveSets::players.forEach([&](int i) {
 		auto ply = &Engine::players[i];
-		if (!ply->active || !ply->isBot) continue;
-		arr.add(ply);
-	}
+		if (ply->active && ply->isBot) arr.add(ply);
+	});
 	return arr;
 }
 
+static ProxyIteration nextPlayer(sol::object, int index) {
+	return nextActive(ActiveSets::players, playerProxies, Engine::players, index);
+}
+
+std::tuple<sol::object, sol::object, int> players::iterActive() {
+	return std::make_tuple(playerProxies.getIterator(nextPlayer),
+	                       sol::object(sol::lua_nil), -1);
+}
+
 Player* players::getByIndex(sol::table self, unsigned int idx) {
 	if (idx >= maxNumberOfPlayers) throw std::invalid_argument(errorOutOfRange);
 	return &Engine::players[idx];
 }
 
 Player* players::createBot() {
-	subhook::ScopedHookRemove remove(&Hooks::createPlayerHook);
-	int playerID = Engine::createPlayer();
+	int playerID = Hooks::callOriginal(Hooks::createPlayerHook,
+	                                   Engine::createPlayer);
 	if (playerID == -1) return nullptr;
+	ActiveSets::players.insert(playerID);
 
-	if (playerDataTables[playerID]) {
-		delete playerDataTables[playerID];
-		playerDataTables[playerID] = nullptr;
-	}
+	playerDataTables.clear(playerID);
+	ChangeFeed::forget(ChangeFeed::Players, playerID);
 
 	auto ply = &Engine::players[playerID];
 	ply->subRosaID = 0;
@@ -646,22 +1449,42 @@ Player* players::createBot() {
 
 int humans::getCount() {
 	int count = 0;
-	for (int i = 0; i < maxNumberOfHumans; i++) {
-		if ((&Engine::humans[i])->active) count++;
-	}
+	ActiveSets::humans.forEach([&](int i) {
+		if (Engine::humans[i].active) count++;
+	});
 	return count;
 }
 
 sol::table humans::getAll() {
-	auto arr = lua->create_table();
-	for (int i = 0; i < maxNumberOfHumans; i++) {
+	auto arr = lua->create_table(ActiveSets::humans.size(), 0);
+	ActiveSets::humans.forEach([&](int i) {
 		auto man = &Engine::humans[i];
-		if (!man->active) continue;
-		arr.add(man);
-	}
+		if (man->active) arr.add(man);
+	});
 	return arr;
 }
 
+static ProxyIteration nextHuman(sol::object, int index) {
+	return nextActive(ActiveSets::humans, humanProxies, Engine::humans, index);
+}
+
+std::tuple<sol::object, sol::object, int> humans::iterActive() {
+	return std::make_tuple(humanProxies.getIterator(nextHuman),
+	                       sol::object(sol::lua_nil), -1);
+}
+
+sol::table humans::getInRadius(Vector* pos, float radius) {
+	return findInRadius(humanGrid, Engine::humans, pos, radius);
+}
+
+sol::table humans::getInBox(Vector* cornerA, Vector* cornerB) {
+	return findInBox(humanGrid, Engine::humans, cornerA, cornerB);
+}
+
+sol::table humans::getNearest(Vector* pos, int count) {
+	return findNearest(humanGrid, ActiveSets::humans, Engine::humans, pos, count);
+}
+
 Human* humans::getByIndex(sol::table self, unsigned int idx) {
 	if (idx >= maxNumberOfHumans) throw std::invalid_argument(errorOutOfRange);
 	return &Engine::humans[idx];
@@ -670,20 +1493,18 @@ Human* humans::getByIndex(sol::table self, unsigned int idx) {
 Human* humans::create(Vector* pos, RotMatrix* rot, Player* ply) {
 	int playerID = ply->getIndex();
 	if (ply->humanID != -1) {
-		subhook::ScopedHookRemove remove(&Hooks::deleteHumanHook);
-		Engine::deleteHuman(ply->humanID);
-	}
-	int humanID;
-	{
-		subhook::ScopedHookRemove remove(&Hooks::createHumanHook);
-		humanID = Engine::createHuman(pos, rot, playerID);
+		Hooks::callOriginal(Hooks::deleteHumanHook, Engine::deleteHuman,
+		                    ply->humanID);
+		ActiveSets::humans.erase(ply->humanID);
 	}
+	int humanID = Hooks::callOriginal(Hooks::createHumanHook,
+	                                  Engine::createHuman, pos, rot, playerID);
 	if (humanID == -1) return nullptr;
+	ActiveSets::humans.insert(humanID);
+	physics::markSpatialIndexStale();
 
-	if (humanDataTables[humanID]) {
-		delete humanDataTables[humanID];
-		humanDataTables[humanID] = nullptr;
-	}
+	humanDataTables.clear(humanID);
+	ChangeFeed::forget(ChangeFeed::Humans, humanID);
 
 	auto man = &Engine::humans[humanID];
 	man->playerID = playerID;
@@ -703,30 +1524,38 @@ sol::table bullets::getAll() {
 }
 
 Bullet* bullets::create(int type, Vector* pos, Vector* vel, Player* ply) {
-	subhook::ScopedHookRemove remove(&Hooks::createBulletHook);
-	int bulletID = Engine::createBullet(type, pos, vel,
-	                                    ply == nullptr ? -1 : ply->getIndex());
+	int bulletID = Hooks::callOriginal(Hooks::createBulletHook,
+	                                   Engine::createBullet, type, pos, vel,
+	                                   ply == nullptr ? -1 : ply->getIndex());
 	return bulletID == -1 ? nullptr : &Engine::bullets[bulletID];
 }
 
 int rigidBodies::getCount() {
 	int count = 0;
-	for (int i = 0; i < maxNumberOfRigidBodies; i++) {
-		if ((&Engine::bodies[i])->active) count++;
-	}
+	ActiveSets::bodies.forEach([&](int i) {
+		if (Engine::bodies[i].active) count++;
+	});
 	return count;
 }
 
 sol::table rigidBodies::getAll() {
-	auto arr = lua->create_table();
-	for (int i = 0; i < maxNumberOfRigidBodies; i++) {
+	auto arr = lua->create_table(ActiveSets::bodies.size(), 0);
+	ActiveSets::bodies.forEach([&](int i) {
 		auto body = &Engine::bodies[i];
-		if (!body->active) continue;
-		arr.add(body);
-	}
+		if (body->active) arr.add(body);
+	});
 	return arr;
 }
 
+static ProxyIteration nextBody(sol::object, int index) {
+	return nextActive(ActiveSets::bodies, bodyProxies, Engine::bodies, index);
+}
+
+std::tuple<sol::object, sol::object, int> rigidBodies::iterActive() {
+	return std::make_tuple(bodyProxies.getIterator(nextBody),
+	                       sol::object(sol::lua_nil), -1);
+}
+
 RigidBody* rigidBodies::getByIndex(sol::table self, unsigned int idx) {
 	if (idx >= maxNumberOfRigidBodies)
 		throw std::invalid_argument(errorOutOfRange);
@@ -735,19 +1564,18 @@ RigidBody* rigidBodies::getByIndex(sol::table self, unsigned int idx) {
 
 int bonds::getCount() {
 	int count = 0;
-	for (int i = 0; i < maxNumberOfBonds; i++) {
-		if ((&Engine::bonds[i])->active) count++;
-	}
+	ActiveSets::bonds.forEach([&](int i) {
+		if (Engine::bonds[i].active) count++;
+	});
 	return count;
 }
 
 sol::table bonds::getAll() {
-	auto arr = lua->create_table();
-	for (int i = 0; i < maxNumberOfBonds; i++) {
+	auto arr = lua->create_table(ActiveSets::bonds.size(), 0);
+	ActiveSets::bonds.forEach([&](int i) {
 		auto bond = &Engine::bonds[i];
-		if (!bond->active) continue;
-		arr.add(bond);
-	}
+		if (bond->active) arr.add(bond);
+	});
 	return arr;
 }
 
@@ -805,8 +1633,7 @@ TrafficCar* trafficCars::getByIndex(sol::table self, unsigned int idx) {
 }
 
 void trafficCars::createMany(int amount) {
-	subhook::ScopedHookRemove remove(&Hooks::createTrafficHook);
-	Engine::createTraffic(amount);
+	Hooks::callOriginal(Hooks::createTrafficHook, Engine::createTraffic, amount);
 }
 
 int buildings::getCount() { return *Engine::numBuildings; }
@@ -842,36 +1669,35 @@ Event* events::getByIndex(sol::table self, unsigned int idx) {
 
 Event* events::createBullet(int bulletType, Vector* pos, Vector* vel,
                             Item* item) {
-	subhook::ScopedHookRemove remove(&Hooks::createEventBulletHook);
-	Engine::createEventBullet(bulletType, pos, vel,
-	                          item == nullptr ? -1 : item->getIndex());
+	Hooks::callOriginal(Hooks::createEventBulletHook, Engine::createEventBullet,
+	                    bulletType, pos, vel,
+	                    item == nullptr ? -1 : item->getIndex());
 	return &Engine::events[*Engine::numEvents - 1];
 }
 
 Event* events::createBulletHit(int hitType, Vector* pos, Vector* normal) {
-	subhook::ScopedHookRemove remove(&Hooks::createEventBulletHitHook);
-	Engine::createEventBulletHit(0, hitType, pos, normal);
+	Hooks::callOriginal(Hooks::createEventBulletHitHook,
+	                    Engine::createEventBulletHit, 0, hitType, pos, normal);
 	return &Engine::events[*Engine::numEvents - 1];
 }
 
 Event* events::createMessage(int messageType, const char* message,
                              int speakerID, int volumeLevel) {
-	subhook::ScopedHookRemove remove(&Hooks::createEventMessageHook);
-	Engine::createEventMessage(messageType, (char*)message, speakerID,
-	                           volumeLevel);
+	Hooks::callOriginal(Hooks::createEventMessageHook, Engine::createEventMessage,
+	                    messageType, (char*)message, speakerID, volumeLevel);
 	return &Engine::events[*Engine::numEvents - 1];
 }
 
 Event* events::createSound(int soundType, Vector* pos, float volume,
                            float pitch) {
-	subhook::ScopedHookRemove remove(&Hooks::createEventSoundHook);
-	Engine::createEventSound(soundType, pos, volume, pitch);
+	Hooks::callOriginal(Hooks::createEventSoundHook, Engine::createEventSound,
+	                    soundType, pos, volume, pitch);
 	return &Engine::events[*Engine::numEvents - 1];
 }
 
 Event* events::createSoundSimple(int soundType, Vector* pos) {
-	subhook::ScopedHookRemove remove(&Hooks::createEventSoundHook);
-	Engine::createEventSound(soundType, pos, 1.0f, 1.0f);
+	Hooks::callOriginal(Hooks::createEventSoundHook, Engine::createEventSound,
+	                    soundType, pos, 1.0f, 1.0f);
 	return &Engine::events[*Engine::numEvents - 1];
 }
 
@@ -1139,14 +1965,13 @@ int Account::getIndex() const {
 	return ((uintptr_t)this - (uintptr_t)Engine::accounts) / sizeof(*this);
 }
 
-sol::table Account::getDataTable() const {
-	int index = getIndex();
-
-	if (!accountDataTables[index]) {
-		accountDataTables[index] = new sol::table(lua->lua_state(), sol::create);
-	}
+void Account::setPhoneNumber(int phone) {
+	phoneNumber = phone;
+	Lua::accounts::clearPhoneIndex();
+}
 
-	return *accountDataTables[index];
+sol::stack_table Account::getDataTable(sol::this_state s) const {
+	return accountDataTables.get(s, getIndex());
 }
 
 std::string Vector::__tostring() const {
@@ -1317,19 +2142,13 @@ int Player::getIndex() const {
 	return ((uintptr_t)this - (uintptr_t)Engine::players) / sizeof(*this);
 }
 
-sol::table Player::getDataTable() const {
-	int index = getIndex();
-
-	if (!playerDataTables[index]) {
-		playerDataTables[index] = new sol::table(lua->lua_state(), sol::create);
-	}
-
-	return *playerDataTables[index];
+sol::stack_table Player::getDataTable(sol::this_state s) const {
+	return playerDataTables.get(s, getIndex());
 }
 
 Event* Player::update() const {
-	subhook::ScopedHookRemove remove(&Hooks::createEventUpdatePlayerHook);
-	Engine::createEventUpdatePlayer(getIndex());
+	Hooks::callOriginal(Hooks::createEventUpdatePlayerHook,
+	                    Engine::createEventUpdatePlayer, getIndex());
 	return &Engine::events[*Engine::numEvents - 1];
 }
 
@@ -1341,18 +2160,15 @@ Event* Player::updateFinance() const {
 void Player::remove() const {
 	int index = getIndex();
 
-	subhook::ScopedHookRemove remove(&Hooks::deletePlayerHook);
-	Engine::deletePlayer(index);
+	Hooks::callOriginal(Hooks::deletePlayerHook, Engine::deletePlayer, index);
+	ActiveSets::players.erase(index);
 
-	if (playerDataTables[index]) {
-		delete playerDataTables[index];
-		playerDataTables[index] = nullptr;
-	}
+	playerDataTables.clear(index);
 }
 
 void Player::sendMessage(const char* message) const {
-	subhook::ScopedHookRemove remove(&Hooks::createEventMessageHook);
-	Engine::createEventMessage(6, (char*)message, getIndex(), 0);
+	Hooks::callOriginal(Hooks::createEventMessageHook, Engine::createEventMessage,
+	                    6, (char*)message, getIndex(), 0);
 }
 
 Human* Player::getHuman() const {
@@ -1420,26 +2236,22 @@ int Human::getIndex() const {
 	return ((uintptr_t)this - (uintptr_t)Engine::humans) / sizeof(*this);
 }
 
-sol::table Human::getDataTable() const {
-	int index = getIndex();
-
-	if (!humanDataTables[index]) {
-		humanDataTables[index] = new sol::table(lua->lua_state(), sol::create);
-	}
+sol::stack_table Human::getDataTable(sol::this_state s) const {
+	return humanDataTables.get(s, getIndex());
+}
 
-	return *humanDataTables[index];
+void Human::setPos(Vector* vec) {
+	pos = *vec;
+	Lua::physics::markSpatialIndexStale();
 }
 
 void Human::remove() const {
 	int index = getIndex();
 
-	subhook::ScopedHookRemove remove(&Hooks::deleteHumanHook);
-	Engine::deleteHuman(index);
+	Hooks::callOriginal(Hooks::deleteHumanHook, Engine::deleteHuman, index);
+	ActiveSets::humans.erase(index);
 
-	if (humanDataTables[index]) {
-		delete humanDataTables[index];
-		humanDataTables[index] = nullptr;
-	}
+	humanDataTables.clear(index);
 }
 
 Player* Human::getPlayer() const {
@@ -1467,6 +2279,8 @@ void Human::setVehicle(Vehicle* vehicle) {
 }
 
 void Human::teleport(Vector* vec) {
+	Lua::physics::markSpatialIndexStale();
+
 	float offX = vec->x - pos.x;
 	float offY = vec->y - pos.y;
 	float offZ = vec->z - pos.z;
@@ -1490,8 +2304,8 @@ void Human::teleport(Vector* vec) {
 };
 
 void Human::speak(const char* message, int distance) const {
-	subhook::ScopedHookRemove remove(&Hooks::createEventMessageHook);
-	Engine::createEventMessage(1, (char*)message, getIndex(), distance);
+	Hooks::callOriginal(Hooks::createEventMessageHook, Engine::createEventMessage,
+	                    1, (char*)message, getIndex(), distance);
 }
 
 void Human::arm(int weapon, int magCount) const {
@@ -1531,13 +2345,13 @@ void Human::addVelocity(Vector* vel) const {
 }
 
 bool Human::mountItem(Item* childItem, unsigned int slot) const {
-	subhook::ScopedHookRemove remove(&Hooks::linkItemHook);
-	return Engine::linkItem(childItem->getIndex(), -1, getIndex(), slot);
+	return Hooks::callOriginal(Hooks::linkItemHook, Engine::linkItem,
+	                           childItem->getIndex(), -1, getIndex(), slot);
 }
 
 void Human::applyDamage(int bone, int damage) const {
-	subhook::ScopedHookRemove remove(&Hooks::humanApplyDamageHook);
-	Engine::humanApplyDamage(getIndex(), bone, 0, damage);
+	Hooks::callOriginal(Hooks::humanApplyDamageHook, Engine::humanApplyDamage,
+	                    getIndex(), bone, 0, damage);
 }
 
 std::string ItemType::__tostring() const {
@@ -1576,14 +2390,13 @@ int Item::getIndex() const {
 	return ((uintptr_t)this - (uintptr_t)Engine::items) / sizeof(*this);
 }
 
-sol::table Item::getDataTable() const {
-	int index = getIndex();
-
-	if (!itemDataTables[index]) {
-		itemDataTables[index] = new sol::table(lua->lua_state(), sol::create);
-	}
+sol::stack_table Item::getDataTable(sol::this_state s) const {
+	return itemDataTables.get(s, getIndex());
+}
 
-	return *itemDataTables[index];
+void Item::setPos(Vector* vec) {
+	pos = *vec;
+	Lua::physics::markSpatialIndexStale();
 }
 
 ItemType* Item::getType() { return &Engine::itemTypes[type]; }
@@ -1599,13 +2412,10 @@ void Item::setType(ItemType* itemType) {
 void Item::remove() const {
 	int index = getIndex();
 
-	subhook::ScopedHookRemove remove(&Hooks::deleteItemHook);
-	Engine::deleteItem(index);
+	Hooks::callOriginal(Hooks::deleteItemHook, Engine::deleteItem, index);
+	ActiveSets::items.erase(index);
 
-	if (itemDataTables[index]) {
-		delete itemDataTables[index];
-		itemDataTables[index] = nullptr;
-	}
+	itemDataTables.clear(index);
 }
 
 Player* Item::getGrenadePrimer() const {
@@ -1643,23 +2453,23 @@ void Item::setVehicle(Vehicle* vehicle) {
 }
 
 bool Item::mountItem(Item* childItem, unsigned int slot) const {
-	subhook::ScopedHookRemove remove(&Hooks::linkItemHook);
-	return Engine::linkItem(getIndex(), childItem->getIndex(), -1, slot);
+	return Hooks::callOriginal(Hooks::linkItemHook, Engine::linkItem, getIndex(),
+	                           childItem->getIndex(), -1, slot);
 }
 
 bool Item::unmount() const {
-	subhook::ScopedHookRemove remove(&Hooks::linkItemHook);
-	return Engine::linkItem(getIndex(), -1, -1, 0);
+	return Hooks::callOriginal(Hooks::linkItemHook, Engine::linkItem, getIndex(),
+	                           -1, -1, 0);
 }
 
 void Item::speak(const char* message, int distance) const {
-	subhook::ScopedHookRemove remove(&Hooks::createEventMessageHook);
-	Engine::createEventMessage(2, (char*)message, getIndex(), distance);
+	Hooks::callOriginal(Hooks::createEventMessageHook, Engine::createEventMessage,
+	                    2, (char*)message, getIndex(), distance);
 }
 
 void Item::explode() const {
-	subhook::ScopedHookRemove remove(&Hooks::grenadeExplosionHook);
-	Engine::grenadeExplosion(getIndex());
+	Hooks::callOriginal(Hooks::grenadeExplosionHook, Engine::grenadeExplosion,
+	                    getIndex());
 }
 
 void Item::setMemo(const char* memo) const {
@@ -1724,6 +2534,11 @@ int Vehicle::getIndex() const {
 	return ((uintptr_t)this - (uintptr_t)Engine::vehicles) / sizeof(*this);
 }
 
+void Vehicle::setPos(Vector* vec) {
+	pos = *vec;
+	Lua::physics::markSpatialIndexStale();
+}
+
 VehicleType* Vehicle::getType() { return &Engine::vehicleTypes[type]; }
 
 void Vehicle::setType(VehicleType* vehicleType) {
@@ -1734,14 +2549,8 @@ void Vehicle::setType(VehicleType* vehicleType) {
 	type = vehicleType->getIndex();
 }
 
-sol::table Vehicle::getDataTable() const {
-	int index = getIndex();
-
-	if (!vehicleDataTables[index]) {
-		vehicleDataTables[index] = new sol::table(lua->lua_state(), sol::create);
-	}
-
-	return *vehicleDataTables[index];
+sol::stack_table Vehicle::getDataTable(sol::this_state s) const {
+	return vehicleDataTables.get(s, getIndex());
 }
 
 Event* Vehicle::updateType() const {
@@ -1751,21 +2560,19 @@ Event* Vehicle::updateType() const {
 
 Event* Vehicle::updateDestruction(int updateType, int partID, Vector* pos,
                                   Vector* normal) const {
-	subhook::ScopedHookRemove remove(&Hooks::createEventUpdateVehicleHook);
-	Engine::createEventUpdateVehicle(getIndex(), updateType, partID, pos, normal);
+	Hooks::callOriginal(Hooks::createEventUpdateVehicleHook,
+	                    Engine::createEventUpdateVehicle, getIndex(), updateType,
+	                    partID, pos, normal);
 	return &Engine::events[*Engine::numEvents - 1];
 }
 
 void Vehicle::remove() const {
 	int index = getIndex();
 
-	subhook::ScopedHookRemove remove(&Hooks::deleteVehicleHook);
-	Engine::deleteVehicle(index);
+	Hooks::callOriginal(Hooks::deleteVehicleHook, Engine::deleteVehicle, index);
+	ActiveSets::vehicles.erase(index);
 
-	if (vehicleDataTables[index]) {
-		delete vehicleDataTables[index];
-		vehicleDataTables[index] = nullptr;
-	}
+	vehicleDataTables.clear(index);
 }
 
 Player* Vehicle::getLastDriver() const {
@@ -1809,31 +2616,28 @@ int RigidBody::getIndex() const {
 	return ((uintptr_t)this - (uintptr_t)Engine::bodies) / sizeof(*this);
 }
 
-sol::table RigidBody::getDataTable() const {
-	int index = getIndex();
-
-	if (!bodyDataTables[index]) {
-		bodyDataTables[index] = new sol::table(lua->lua_state(), sol::create);
-	}
-
-	return *bodyDataTables[index];
+sol::stack_table RigidBody::getDataTable(sol::this_state s) const {
+	return bodyDataTables.get(s, getIndex());
 }
 
 Bond* RigidBody::bondTo(RigidBody* other, Vector* thisLocalPos,
                         Vector* otherLocalPos) const {
 	int id = Engine::createBondRigidBodyToRigidBody(getIndex(), other->getIndex(),
 	                                                thisLocalPos, otherLocalPos);
+	if (id != -1) ActiveSets::bonds.insert(id);
 	return id == -1 ? nullptr : &Engine::bonds[id];
 }
 
 Bond* RigidBody::bondRotTo(RigidBody* other) const {
 	int id =
 	    Engine::createBondRigidBodyRotRigidBody(getIndex(), other->getIndex());
+	if (id != -1) ActiveSets::bonds.insert(id);
 	return id == -1 ? nullptr : &Engine::bonds[id];
 }
 
 Bond* RigidBody::bondToLevel(Vector* localPos, Vector* globalPos) const {
 	int id = Engine::createBondRigidBodyToLevel(getIndex(), localPos, globalPos);
+	if (id != -1) ActiveSets::bonds.insert(id);
 	return id == -1 ? nullptr : &Engine::bonds[id];
 }
 
@@ -1,6 +1,9 @@
 #pragma once
+#include "datatables.h"
 #include "engine.h"
+#include "future.h"
 #include "hooks.h"
+#include "serializer.h"
 #include "sol/sol.hpp"
 
 #include <memory>
@@ -27,12 +30,12 @@ extern bool shouldReset;
 extern sol::state* lua;
 extern std::string hookMode;
 
-extern sol::table* accountDataTables[maxNumberOfAccounts];
-extern sol::table* playerDataTables[maxNumberOfPlayers];
-extern sol::table* humanDataTables[maxNumberOfHumans];
-extern sol::table* itemDataTables[maxNumberOfItems];
-extern sol::table* vehicleDataTables[maxNumberOfVehicles];
-extern sol::table* bodyDataTables[maxNumberOfRigidBodies];
+extern DataTables<maxNumberOfAccounts> accountDataTables;
+extern DataTables<maxNumberOfPlayers> playerDataTables;
+extern DataTables<maxNumberOfHumans> humanDataTables;
+extern DataTables<maxNumberOfItems> itemDataTables;
+extern DataTables<maxNumberOfVehicles> vehicleDataTables;
+extern DataTables<maxNumberOfRigidBodies> bodyDataTables;
 
 enum LuaRequestType { get, post };
 
@@ -62,11 +65,17 @@ bool noLuaCallError(sol::load_result* res);
 void hookAndReset(int reason);
 
 void defineThreadSafeAPIs(sol::state* state);
+// Sends Vector and RotMatrix between states as raw floats
+extern const Serializer::Codec vectorCodec;
 void luaInit(bool redo = false);
 
 namespace Lua {
 void print(sol::variadic_args va, sol::this_state s);
 void flagStateForReset(const char* mode);
+// Drops the userdata kept for entity iterators, before the state is closed.
+void clearProxyCaches();
+// Packed records and how many there are, see Snapshot
+using GatherResult = std::tuple<std::string_view, int>;
 
 Vector Vector_();
 Vector Vector_3f(float x, float y, float z);
@@ -84,9 +93,45 @@ sol::object postSync(const char* scheme, const char* path, sol::table headers,
 namespace hook {
 bool enable(std::string name);
 bool disable(std::string name);
+bool add(std::string name, sol::protected_function function);
+bool addPriority(std::string name, sol::protected_function function,
+                 int priority);
+bool remove(std::string name, sol::protected_function function);
 void clear();
+sol::table getStats();
+void resetStats();
+void printStats();
+// Makes calls past hooks remove and reinstall them instead of using their
+// trampolines, to measure what the trampolines save.
+void setUseTrampolines(bool enabled);
 };  // namespace hook
 
+namespace tickTimer {
+sol::table getPercentiles();
+unsigned long long getTickCount();
+unsigned long long getOverrunCount();
+};  // namespace tickTimer
+
+namespace changes {
+void watch(const char* kindName, const char* fieldName);
+void unwatch(const char* kindName, const char* fieldName);
+// Changes from the end of the last tick, each polled once.
+sol::table poll();
+void clear();
+};  // namespace changes
+
+namespace async {
+// Lua source of async.await, which yields the running coroutine until a
+// future is ready and then returns its values.
+extern const char* const awaitSource;
+Future run(const char* moduleName, const char* functionName,
+           sol::variadic_args args);
+// Called once per tick to hand finished results to their futures.
+void update();
+// Stops the workers and forgets pending futures, before the state is closed.
+void reset();
+};  // namespace async
+
 namespace physics {
 sol::table lineIntersectLevel(Vector* posA, Vector* posB, bool onlyCity);
 sol::table lineIntersectHuman(Human* man, Vector* posA, Vector* posB,
@@ -102,6 +147,16 @@ sol::object lineIntersectVehicleQuick(Vehicle* vcl, Vector* posA, Vector* posB,
 std::tuple<sol::object, sol::object> lineIntersectAnyQuick(
     Vector* posA, Vector* posB, Human* ignoreHuman, float humanPadding,
     bool includeWheels, sol::this_state s);
+// Rebuilds the index used by lineIntersectAnyQuick on its next call. Setting
+// pos on a human, item or vehicle does this, but writing its fields (pos.x)
+// or writing through the FFI arrays doesn't.
+void markSpatialIndexStale();
+// What each ray of lineIntersectBatch hit first, 0 to 3 in Lua.
+enum BatchHitType { HitNone, HitLevel, HitHuman, HitVehicle };
+// Casts every ray in {ax, ay, az, bx, by, bz, ...}, returning {count, fraction,
+// type, index, normal} where normal holds 3 numbers per ray.
+sol::table lineIntersectBatch(sol::table rays);
+sol::table lineIntersectBatchOptions(sol::table rays, sol::table options);
 sol::object lineIntersectTriangle(Vector* outPos, Vector* normal, Vector* posA,
                                   Vector* posB, Vector* triA, Vector* triB,
                                   Vector* triC, sol::this_state s);
@@ -120,6 +175,11 @@ ItemType* getByName(const char* name);
 namespace items {
 int getCount();
 sol::table getAll();
+std::tuple<sol::object, sol::object, int> iterActive();
+sol::table getInRadius(Vector* pos, float radius);
+sol::table getInBox(Vector* cornerA, Vector* cornerB);
+sol::table getNearest(Vector* pos, int count);
+GatherResult gather(sol::table fields);
 Item* getByIndex(sol::table self, unsigned int idx);
 Item* create(ItemType* type, Vector* pos, RotMatrix* rot);
 Item* createVel(ItemType* typee, Vector* pos, Vector* vel, RotMatrix* rot);
@@ -136,6 +196,11 @@ VehicleType* getByName(const char* name);
 namespace vehicles {
 int getCount();
 sol::table getAll();
+std::tuple<sol::object, sol::object, int> iterActive();
+sol::table getInRadius(Vector* pos, float radius);
+sol::table getInBox(Vector* cornerA, Vector* cornerB);
+sol::table getNearest(Vector* pos, int count);
+GatherResult gather(sol::table fields);
 Vehicle* getByIndex(sol::table self, unsigned int idx);
 Vehicle* create(VehicleType* type, Vector* pos, RotMatrix* rot, int color);
 Vehicle* createVel(VehicleType* type, Vector* pos, Vector* vel, RotMatrix* rot,
@@ -152,13 +217,17 @@ void save();
 int getCount();
 sol::table getAll();
 Account* getByPhone(int phone);
+// Called when an account's phone number changes or accounts are reloaded.
+void clearPhoneIndex();
 Account* getByIndex(sol::table self, unsigned int idx);
 };  // namespace accounts
 
 namespace players {
 int getCount();
 sol::table getAll();
+std::tuple<sol::object, sol::object, int> iterActive();
 Player* getByPhone(int phone);
+GatherResult gather(sol::table fields);
 sol::table getNonBots();
 sol::table getBots();
 Player* getByIndex(sol::table self, unsigned int idx);
@@ -168,6 +237,12 @@ Player* createBot();
 namespace humans {
 int getCount();
 sol::table getAll();
+std::tuple<sol::object, sol::object, int> iterActive();
+sol::table getInRadius(Vector* pos, float radius);
+sol::table getInBox(Vector* cornerA, Vector* cornerB);
+sol::table getNearest(Vector* pos, int count);
+GatherResult gather(sol::table fields);
+GatherResult gatherBones(sol::table fields);
 Human* getByIndex(sol::table self, unsigned int idx);
 Human* create(Vector* pos, RotMatrix* rot, Player* ply);
 };  // namespace humans
@@ -175,12 +250,14 @@ Human* create(Vector* pos, RotMatrix* rot, Player* ply);
 namespace bullets {
 unsigned int getCount();
 sol::table getAll();
+GatherResult gather(sol::table fields);
 Bullet* create(int type, Vector* pos, Vector* vel, Player* ply);
 };  // namespace bullets
 
 namespace rigidBodies {
 int getCount();
 sol::table getAll();
+std::tuple<sol::object, sol::object, int> iterActive();
 RigidBody* getByIndex(sol::table self, unsigned int idx);
 };  // namespace rigidBodies
 
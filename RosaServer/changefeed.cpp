@@ -0,0 +1,209 @@
+#include "changefeed.h"
+
+#include <algorithm>
+#include <cstring>
+#include "activeset.h"
+#include "engine.h"
+
+namespace ChangeFeed {
+const char* const kindNames[Kind::SIZE] = {"Player", "Human", "Item",
+                                           "Vehicle"};
+
+#define FIELD(type, name, fieldType) \
+	{ #name, offsetof(type, name), fieldType }
+
+static const std::vector<Field> fields[Kind::SIZE] = {
+    {
+        FIELD(Player, money, Int),
+        FIELD(Player, teamMoney, Int),
+        FIELD(Player, budget, Int),
+        FIELD(Player, corporateRating, Int),
+        FIELD(Player, criminalRating, Int),
+        FIELD(Player, team, UnsignedInt),
+        FIELD(Player, stocks, Int),
+        FIELD(Player, spawnTimer, Int),
+        FIELD(Player, humanID, Int),
+        FIELD(Player, isReady, Int),
+        FIELD(Player, inputFlags, UnsignedInt),
+        FIELD(Player, inputType, Int),
+        FIELD(Player, menuTab, Int),
+        FIELD(Player, zoomLevel, Int),
+    },
+    {
+        FIELD(Human, pos, VectorValue),
+        FIELD(Human, health, Int),
+        FIELD(Human, bloodLevel, Int),
+        FIELD(Human, isBleeding, Int),
+        FIELD(Human, chestHP, Int),
+        FIELD(Human, headHP, Int),
+        FIELD(Human, leftArmHP, Int),
+        FIELD(Human, rightArmHP, Int),
+        FIELD(Human, leftLegHP, Int),
+        FIELD(Human, rightLegHP, Int),
+        FIELD(Human, stamina, Int),
+        FIELD(Human, playerID, Int),
+        FIELD(Human, accountID, Int),
+        FIELD(Human, vehicleID, Int),
+        FIELD(Human, vehicleSeat, Int),
+        FIELD(Human, movementState, Int),
+        FIELD(Human, isOnGround, Int),
+        FIELD(Human, inputFlags, UnsignedInt),
+    },
+    {
+        FIELD(Item, pos, VectorValue),
+        FIELD(Item, vel, VectorValue),
+        FIELD(Item, type, Int),
+        FIELD(Item, despawnTime, Int),
+        FIELD(Item, parentHumanID, Int),
+        FIELD(Item, parentItemID, Int),
+        FIELD(Item, parentSlot, Int),
+        FIELD(Item, bullets, Int),
+        FIELD(Item, cooldown, Int),
+        FIELD(Item, vehicleID, Int),
+        FIELD(Item, computerCurrentLine, UnsignedInt),
+    },
+    {
+        FIELD(Vehicle, pos, VectorValue),
+        FIELD(Vehicle, vel, VectorValue),
+        FIELD(Vehicle, type, UnsignedInt),
+        FIELD(Vehicle, health, Int),
+        FIELD(Vehicle, isLocked, Int),
+        FIELD(Vehicle, color, UnsignedInt),
+        FIELD(Vehicle, lastDriverPlayerID, Int),
+        FIELD(Vehicle, trafficCarID, Int),
+        FIELD(Vehicle, engineRPM, Int),
+    },
+};
+
+#undef FIELD
+
+static size_t valueSize(FieldType type) {
+	return type == VectorValue ? sizeof(Vector) : sizeof(int);
+}
+
+struct Tracker {
+	std::vector<const Field*> watched;
+	// Values of the watched fields per slot, as of the last update
+	std::vector<Value> shadow;
+	// The update each slot was last seen active in
+	std::vector<unsigned int> lastSeen;
+};
+
+static Tracker trackers[Kind::SIZE];
+static unsigned int updateCount = 1;
+static std::vector<Change> changes;
+
+const Field* findField(Kind kind, const char* name) {
+	for (const Field& field : fields[kind]) {
+		if (!std::strcmp(field.name, name)) {
+			return &field;
+		}
+	}
+	return nullptr;
+}
+
+static void resize(Tracker& tracker, int capacity) {
+	tracker.shadow.assign(capacity * tracker.watched.size(), Value{});
+	// Every slot takes a fresh copy next update instead of reporting
+	tracker.lastSeen.assign(capacity, 0);
+}
+
+static int getCapacity(Kind kind) {
+	switch (kind) {
+		case Players:
+			return maxNumberOfPlayers;
+		case Humans:
+			return maxNumberOfHumans;
+		case Items:
+			return maxNumberOfItems;
+		default:
+			return maxNumberOfVehicles;
+	}
+}
+
+void watch(Kind kind, const Field* field) {
+	Tracker& tracker = trackers[kind];
+	if (std::find(tracker.watched.begin(), tracker.watched.end(), field) !=
+	    tracker.watched.end()) {
+		return;
+	}
+
+	tracker.watched.push_back(field);
+	resize(tracker, getCapacity(kind));
+}
+
+void forget(Kind kind, int index) {
+	Tracker& tracker = trackers[kind];
+	if (!tracker.lastSeen.empty()) {
+		tracker.lastSeen[index] = 0;
+	}
+}
+
+void unwatch(Kind kind, const Field* field) {
+	Tracker& tracker = trackers[kind];
+	auto position =
+	    std::find(tracker.watched.begin(), tracker.watched.end(), field);
+	if (position == tracker.watched.end()) {
+		return;
+	}
+
+	tracker.watched.erase(position);
+	resize(tracker, getCapacity(kind));
+}
+
+void reset() {
+	for (Tracker& tracker : trackers) {
+		tracker.watched.clear();
+		tracker.shadow.clear();
+		tracker.lastSeen.clear();
+	}
+	changes.clear();
+}
+
+template <typename T, int capacity>
+static void diff(Kind kind, const ActiveSet<capacity>& set, T* array) {
+	Tracker& tracker = trackers[kind];
+	size_t numWatched = tracker.watched.size();
+	if (!numWatched) {
+		return;
+	}
+
+	set.forEach([&](int index) {
+		if (!array[index].active) {
+			return;
+		}
+		const char* object = reinterpret_cast<const char*>(&array[index]);
+
+		// Slots which just became active have nothing to compare against
+		bool hasShadow = tracker.lastSeen[index] == updateCount - 1;
+		tracker.lastSeen[index] = updateCount;
+
+		Value* shadow = &tracker.shadow[index * numWatched];
+		for (size_t i = 0; i < numWatched; i++) {
+			const Field* field = tracker.watched[i];
+			size_t size = valueSize(field->type);
+			const char* current = object + field->offset;
+
+			if (hasShadow && std::memcmp(&shadow[i], current, size)) {
+				Change change{kind, index, field};
+				std::memcpy(&change.oldValue, &shadow[i], size);
+				std::memcpy(&change.newValue, current, size);
+				changes.push_back(change);
+			}
+			std::memcpy(&shadow[i], current, size);
+		}
+	});
+}
+
+void update() {
+	changes.clear();
+	updateCount++;
+
+	diff(Players, ActiveSets::players, Engine::players);
+	diff(Humans, ActiveSets::humans, Engine::humans);
+	diff(Items, ActiveSets::items, Engine::items);
+	diff(Vehicles, ActiveSets::vehicles, Engine::vehicles);
+}
+
+std::vector<Change>& getChanges() { return changes; }
+};  // namespace ChangeFeed
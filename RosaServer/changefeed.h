@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "structs.h"
+
+// Tracks chosen fields of active entities, diffing them against a copy taken
+// at the end of the previous tick.
+namespace ChangeFeed {
+enum Kind { Players, Humans, Items, Vehicles, SIZE };
+
+extern const char* const kindNames[Kind::SIZE];
+
+enum FieldType { Int, UnsignedInt, Float, VectorValue };
+
+struct Field {
+	const char* name;
+	size_t offset;
+	FieldType type;
+};
+
+union Value {
+	int i;
+	unsigned int u;
+	float f;
+	Vector v;
+};
+
+struct Change {
+	Kind kind;
+	int index;
+	const Field* field;
+	Value oldValue;
+	Value newValue;
+};
+
+// nullptr if the kind has no field by that name
+const Field* findField(Kind kind, const char* name);
+
+void watch(Kind kind, const Field* field);
+// Makes the next update take a fresh copy of a slot instead of diffing it,
+// for a slot just taken by a new entity.
+void forget(Kind kind, int index);
+void unwatch(Kind kind, const Field* field);
+// Stops watching everything.
+void reset();
+
+// Called once at the end of every tick.
+void update();
+// What changed in the last update.
+std::vector<Change>& getChanges();
+};  // namespace ChangeFeed
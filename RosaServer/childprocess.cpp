@@ -1,16 +1,29 @@
 #include "childprocess.h"
+#include "api.h"
 
 #include <fcntl.h>
 #include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #include <thread>
 
 static constexpr int pipeBufferSize = 1024 * 1024;
+// Past this much waiting for a child which isn't reading, sends are dropped
+static constexpr size_t maxQueuedBytes = 16 * 1024 * 1024;
+
+ChildProcess::ChildProcess(const char* fileName)
+    : ChildProcess(fileName, 0) {}
+
+ChildProcess::ChildProcess(const char* fileName, size_t ringCapacity) {
+	if (ringCapacity) {
+		setUpSharedMemory(ringCapacity);
+	}
 
-ChildProcess::ChildProcess(const char* fileName) {
 	if (pipe(fdParentToChild) == -1) {
+		closeSharedMemory();
 		throw std::runtime_error(strerror(errno));
 	}
 
@@ -19,6 +32,7 @@ ChildProcess::ChildProcess(const char* fileName) {
 	    fcntl(fdChildToParent[1], F_SETPIPE_SZ, pipeBufferSize) == -1) {
 		close(fdParentToChild[0]);
 		close(fdParentToChild[1]);
+		closeSharedMemory();
 
 		throw std::runtime_error(strerror(errno));
 	}
@@ -30,6 +44,7 @@ ChildProcess::ChildProcess(const char* fileName) {
 		close(fdParentToChild[1]);
 		close(fdChildToParent[0]);
 		close(fdChildToParent[1]);
+		closeSharedMemory();
 
 		throw std::runtime_error(strerror(errno));
 	}
@@ -39,6 +54,18 @@ ChildProcess::ChildProcess(const char* fileName) {
 		close(fdChildToParent[1]);
 
 		fcntl(fdChildToParent[0], F_SETFL, O_NONBLOCK);
+		// Whatever the pipe can't take yet stays queued in the writer
+		fcntl(fdParentToChild[1], F_SETFL, O_NONBLOCK);
+
+		reader = std::make_unique<FrameReader>(fdChildToParent[0]);
+		writer =
+		    std::make_unique<FrameWriter>(fdParentToChild[1], maxQueuedBytes);
+
+		// The mapping stays valid without the descriptor
+		if (memoryFD != -1) {
+			close(memoryFD);
+			memoryFD = -1;
+		}
 	} else {
 		close(fdParentToChild[1]);
 		close(fdChildToParent[0]);
@@ -52,8 +79,33 @@ ChildProcess::ChildProcess(const char* fileName) {
 		sprintf(strFromParentFD, "%i", fdParentToChild[0]);
 		sprintf(strToParentFD, "%i", fdChildToParent[1]);
 
-		char* args[] = {(char*)"./rosaserversatellite", strFromParentFD,
-		                strToParentFD, (char*)fileName, nullptr};
+		char strMemoryFD[10];
+		char strRingCapacity[24];
+		char strEventToChild[10];
+		char strEventToParent[10];
+
+		char* args[] = {(char*)"./rosaserversatellite",
+		                strFromParentFD,
+		                strToParentFD,
+		                (char*)fileName,
+		                nullptr,
+		                nullptr,
+		                nullptr,
+		                nullptr,
+		                nullptr};
+
+		// The satellite maps the same memory from the inherited descriptors
+		if (memoryFD != -1) {
+			sprintf(strMemoryFD, "%i", memoryFD);
+			sprintf(strRingCapacity, "%zu", ringCapacity);
+			sprintf(strEventToChild, "%i", eventToChild);
+			sprintf(strEventToParent, "%i", eventToParent);
+
+			args[4] = strMemoryFD;
+			args[5] = strRingCapacity;
+			args[6] = strEventToChild;
+			args[7] = strEventToParent;
+		}
 
 		char workingDirectory[PATH_MAX];
 
@@ -76,6 +128,113 @@ ChildProcess::ChildProcess(const char* fileName) {
 
 ChildProcess::~ChildProcess() { terminate(); }
 
+void ChildProcess::setUpSharedMemory(size_t ringCapacity) {
+	size_t ringSize = SharedRing::getMappingSize(ringCapacity);
+	sharedMemorySize = ringSize * 2;
+
+	// Not close-on-exec, the satellite inherits all three
+	memoryFD = memfd_create("rosaserversatellite", 0);
+	if (memoryFD == -1) {
+		throw std::runtime_error(strerror(errno));
+	}
+
+	// Truncating zero fills, which is the empty state of both rings
+	if (ftruncate(memoryFD, sharedMemorySize) == -1) {
+		closeSharedMemory();
+		throw std::runtime_error(strerror(errno));
+	}
+
+	void* memory = mmap(nullptr, sharedMemorySize, PROT_READ | PROT_WRITE,
+	                    MAP_SHARED, memoryFD, 0);
+	if (memory == MAP_FAILED) {
+		closeSharedMemory();
+		throw std::runtime_error(strerror(errno));
+	}
+	sharedMemory = memory;
+
+	eventToChild = eventfd(0, EFD_NONBLOCK);
+	eventToParent = eventfd(0, EFD_NONBLOCK);
+	if (eventToChild == -1 || eventToParent == -1) {
+		closeSharedMemory();
+		throw std::runtime_error(strerror(errno));
+	}
+
+	// Whichever ring it is sleeping on, each side is woken by its own eventfd
+	ringToChild = std::make_unique<SharedRing>(sharedMemory, ringCapacity,
+	                                           eventToChild, eventToParent);
+	ringToParent =
+	    std::make_unique<SharedRing>(static_cast<char*>(sharedMemory) + ringSize,
+	                                 ringCapacity, eventToParent, eventToChild);
+}
+
+void ChildProcess::closeSharedMemory() {
+	ringToChild.reset();
+	ringToParent.reset();
+	pendingToChild.clear();
+	pendingToChildBytes = 0;
+
+	if (sharedMemory) {
+		munmap(sharedMemory, sharedMemorySize);
+		sharedMemory = nullptr;
+	}
+
+	for (int* fd : {&memoryFD, &eventToChild, &eventToParent}) {
+		if (*fd != -1) {
+			close(*fd);
+			*fd = -1;
+		}
+	}
+}
+
+void ChildProcess::flushToChild() {
+	if (ringToChild) {
+		try {
+			while (!pendingToChild.empty() &&
+			       ringToChild->write(pendingToChild.front())) {
+				pendingToChildBytes -= pendingToChild.front().size();
+				pendingToChild.pop_front();
+			}
+		} catch (const std::runtime_error&) {
+			// The child moved the ring's positions out of range
+			terminate();
+			throw;
+		}
+	} else {
+		writer->flush();
+	}
+}
+
+bool ChildProcess::readMessage(std::string& message) {
+	if (ringToParent) {
+		std::string_view view;
+		if (!peekRing(view)) {
+			return false;
+		}
+
+		message.assign(view);
+		ringToParent->skip();
+		return true;
+	}
+
+	try {
+		return reader->read(message);
+	} catch (const std::runtime_error&) {
+		// Includes a frame too large to be anything but garbage
+		terminate();
+		throw;
+	}
+}
+
+bool ChildProcess::peekRing(std::string_view& message) {
+	try {
+		return ringToParent->peek(message);
+	} catch (const std::runtime_error&) {
+		// A child writing frames outside the ring can't be trusted any further
+		terminate();
+		throw;
+	}
+}
+
 bool ChildProcess::isRunning() {
 	if (gotExitCode || pid == -1) {
 		return false;
@@ -118,6 +277,9 @@ void ChildProcess::terminate() {
 		// Close file handles
 		close(fdParentToChild[1]);
 		close(fdChildToParent[0]);
+		reader.reset();
+		writer.reset();
+		closeSharedMemory();
 
 		pid = -1;
 	}
@@ -138,46 +300,105 @@ sol::object ChildProcess::getExitCode(sol::this_state s) {
 sol::object ChildProcess::receiveMessage(sol::this_state s) {
 	sol::state_view lua(s);
 
-	unsigned int length;
+	if (reader) {
+		// Messages still queued from earlier sends go out as well
+		flushToChild();
 
-	auto bytesRead = read(fdChildToParent[0], &length, sizeof(length));
-	if (bytesRead == -1) {
-		if (errno != EAGAIN) {
-			throw std::runtime_error(strerror(errno));
-		}
-	} else if (bytesRead == sizeof(length)) {
-		std::string message(length, ' ');
-		bytesRead = read(fdChildToParent[0], message.data(), length);
-		if (bytesRead == -1) {
-			if (errno != EAGAIN) {
-				throw std::runtime_error(strerror(errno));
-			}
-		} else if (bytesRead == length) {
-			return sol::make_object(lua, message);
+		std::string message;
+		if (readMessage(message)) {
+			return Serializer::deserialize(lua, message, &vectorCodec);
 		}
 	}
 
 	return sol::make_object(lua, sol::nil);
 }
 
-void ChildProcess::sendMessage(std::string_view message) {
-	if (!isRunning()) return;
+sol::table ChildProcess::receiveMessages(unsigned int max, sol::this_state s) {
+	sol::state_view lua(s);
 
-	unsigned int length = static_cast<unsigned int>(message.length());
+	auto messages = lua.create_table();
+	if (reader) {
+		flushToChild();
 
-	auto bytesWritten = write(fdParentToChild[1], &length, sizeof(length));
-	if (bytesWritten == -1) {
-		throw std::runtime_error(strerror(errno));
-	} else if (bytesWritten != sizeof(length)) {
-		throw std::runtime_error("Couldn't write full message to pipe");
-	} else {
-		bytesWritten = write(fdParentToChild[1], message.data(), length);
-		if (bytesWritten == -1) {
-			throw std::runtime_error(strerror(errno));
-		} else if (bytesWritten != length) {
-			throw std::runtime_error("Couldn't write full message to pipe");
+		std::string message;
+		for (unsigned int i = 0; i < max && readMessage(message); i++) {
+			messages.add(Serializer::deserialize(lua, message, &vectorCodec));
+		}
+	}
+
+	return messages;
+}
+
+std::tuple<sol::object, sol::object> ChildProcess::peekString(
+    sol::this_state s) {
+	sol::state_view lua(s);
+
+	if (!ringToParent) {
+		throw std::runtime_error("Child process has no shared memory");
+	}
+
+	flushToChild();
+
+	std::string_view message;
+	std::string_view string;
+	if (peekRing(message) && Serializer::viewString(message, string)) {
+		return std::make_tuple(
+		    sol::make_object(lua, reinterpret_cast<uintptr_t>(string.data())),
+		    sol::make_object(lua, string.size()));
+	}
+
+	return std::make_tuple(sol::make_object(lua, sol::nil),
+	                       sol::make_object(lua, sol::nil));
+}
+
+void ChildProcess::skipMessage() {
+	if (!ringToParent) {
+		throw std::runtime_error("Child process has no shared memory");
+	}
+
+	ringToParent->skip();
+}
+
+bool ChildProcess::sendMessage(sol::object value) {
+	if (!isRunning()) return false;
+
+	std::string message;
+	Serializer::serialize(value, message, &vectorCodec);
+
+	bool queued;
+	if (ringToChild) {
+		if (message.size() > ringToChild->getMaxMessageSize()) {
+			throw std::length_error("Message is larger than the shared ring");
+		}
+
+		queued = pendingToChildBytes + message.size() <= maxQueuedBytes;
+		if (queued) {
+			pendingToChildBytes += message.size();
+			pendingToChild.push_back(std::move(message));
 		}
+	} else {
+		queued = writer->queue(std::move(message));
+	}
+
+	if (!queued) {
+		numDropped++;
+	}
+
+	flushToChild();
+	return queued;
+}
+
+sol::table ChildProcess::getQueueStats(sol::this_state s) {
+	sol::state_view lua(s);
+
+	auto stats = lua.create_table();
+	if (ringToChild) {
+		stats["sendQueued"] = pendingToChild.size();
+	} else {
+		stats["sendQueued"] = writer ? writer->getNumQueued() : 0;
 	}
+	stats["sendDropped"] = numDropped;
+	return stats;
 }
 
 void ChildProcess::setLimit(__rlimit_resource resource, rlim_t softLimit,
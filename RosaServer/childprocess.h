@@ -2,13 +2,41 @@
 #include "sol/sol.hpp"
 
 #include <sys/resource.h>
+#include <deque>
+#include <memory>
 #include <string>
+#include "pipeframes.h"
+#include "sharedring.h"
 
 class ChildProcess {
 	int fdParentToChild[2];
 	int fdChildToParent[2];
 	int pid;
 
+	std::unique_ptr<FrameReader> reader;
+	std::unique_ptr<FrameWriter> writer;
+
+	// Set when the child was started with shared memory, which then carries
+	// every message instead of the pipes
+	int memoryFD = -1;
+	void* sharedMemory = nullptr;
+	size_t sharedMemorySize = 0;
+	int eventToChild = -1;
+	int eventToParent = -1;
+	std::unique_ptr<SharedRing> ringToChild;
+	std::unique_ptr<SharedRing> ringToParent;
+	// Messages the ring to the child had no room for yet
+	std::deque<std::string> pendingToChild;
+	size_t pendingToChildBytes = 0;
+	// Messages left out because too much was waiting for the child already
+	uint64_t numDropped = 0;
+
+	void setUpSharedMemory(size_t ringCapacity);
+	void closeSharedMemory();
+	void flushToChild();
+	bool readMessage(std::string& message);
+	bool peekRing(std::string_view& message);
+
 	bool gotExitCode = false;
 	int exitCode;
 
@@ -16,12 +44,19 @@ class ChildProcess {
 
  public:
 	ChildProcess(const char* fileName);
+	// Messages go through two rings of ringCapacity bytes each in shared
+	// memory rather than the pipes
+	ChildProcess(const char* fileName, size_t ringCapacity);
 	~ChildProcess();
 	bool isRunning();
 	void terminate();
 	sol::object getExitCode(sol::this_state s);
 	sol::object receiveMessage(sol::this_state s);
-	void sendMessage(std::string_view message);
+	sol::table receiveMessages(unsigned int max, sol::this_state s);
+	std::tuple<sol::object, sol::object> peekString(sol::this_state s);
+	void skipMessage();
+	bool sendMessage(sol::object message);
+	sol::table getQueueStats(sol::this_state s);
 	void setCPULimit(rlim_t softLimit, rlim_t hardLimit);
 	void setMemoryLimit(rlim_t softLimit, rlim_t hardLimit);
 	void setFileSizeLimit(rlim_t softLimit, rlim_t hardLimit);
@@ -0,0 +1,82 @@
+#pragma once
+#include <vector>
+#include "sol/sol.hpp"
+
+extern sol::state* lua;
+
+// Lua tables scripts attach to the slots of an engine array, kept in a single
+// table in the registry. The slots which have one are listed, so that clearing
+// a slot which never had a table is free and resetting only touches the ones
+// which did.
+template <int capacity>
+class DataTables {
+	int storeReference = LUA_NOREF;
+	// Position of each slot in usedSlots, or -1
+	int positions[capacity];
+	std::vector<int> usedSlots;
+
+	void pushStore(lua_State* L) {
+		if (storeReference == LUA_NOREF) {
+			lua_createtable(L, 0, 0);
+			storeReference = luaL_ref(L, LUA_REGISTRYINDEX);
+		}
+		lua_rawgeti(L, LUA_REGISTRYINDEX, storeReference);
+	}
+
+ public:
+	DataTables() {
+		for (int i = 0; i < capacity; i++) {
+			positions[i] = -1;
+		}
+	}
+
+	// Pushes the table for a slot, making it first if needed.
+	sol::stack_table get(lua_State* L, int index) {
+		pushStore(L);
+		lua_rawgeti(L, -1, index + 1);
+
+		if (lua_isnil(L, -1)) {
+			lua_pop(L, 1);
+			lua_createtable(L, 0, 0);
+			lua_pushvalue(L, -1);
+			lua_rawseti(L, -3, index + 1);
+
+			positions[index] = usedSlots.size();
+			usedSlots.push_back(index);
+		}
+
+		lua_remove(L, -2);
+		return sol::stack_table(L, -1);
+	}
+
+	// Drops the table of a slot which has been reused by the engine.
+	void clear(int index) {
+		int position = positions[index];
+		if (position == -1) {
+			return;
+		}
+
+		// Called from engine hooks, so this can't use whichever coroutine last
+		// touched a table: it may have been collected since
+		lua_State* state = lua->lua_state();
+		pushStore(state);
+		lua_pushnil(state);
+		lua_rawseti(state, -2, index + 1);
+		lua_pop(state, 1);
+
+		int last = usedSlots.back();
+		usedSlots[position] = last;
+		positions[last] = position;
+		usedSlots.pop_back();
+		positions[index] = -1;
+	}
+
+	// Forgets every table, when the state they live in is about to be closed.
+	void reset() {
+		for (int index : usedSlots) {
+			positions[index] = -1;
+		}
+		usedSlots.clear();
+		storeReference = LUA_NOREF;
+	}
+};
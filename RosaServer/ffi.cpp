@@ -0,0 +1,1403 @@
+#include "ffi.h"
+#include <cstddef>
+#include "api.h"
+#include "console.h"
+
+namespace FFI {
+// Data members of the structs in structs.h, in the same order. Padding sizes
+// are kept as expressions so both copies read the same. defineTypes checks
+// every struct's size and every named field's offset against the compiler's.
+const char* const definitions = R"(
+typedef uint8_t padding;
+
+enum {
+	maxNumberOfAccounts = 32768,
+	maxNumberOfPlayers = 256,
+	maxNumberOfHumans = 256,
+	maxNumberOfItemTypes = 46,
+	maxNumberOfItems = 1024,
+	maxNumberOfVehicleTypes = 17,
+	maxNumberOfVehicles = 512,
+	maxNumberOfRigidBodies = 8192,
+	maxNumberOfBonds = 16384
+};
+
+typedef struct EarShot EarShot;
+typedef struct Connection Connection;
+typedef struct Account Account;
+typedef struct Vector Vector;
+typedef struct RotMatrix RotMatrix;
+typedef struct LineIntersectResult LineIntersectResult;
+typedef struct Action Action;
+typedef struct MenuButton MenuButton;
+typedef struct Voice Voice;
+typedef struct Player Player;
+typedef struct Bone Bone;
+typedef struct InventorySlot InventorySlot;
+typedef struct Human Human;
+typedef struct ItemType ItemType;
+typedef struct Item Item;
+typedef struct VehicleType VehicleType;
+typedef struct Vehicle Vehicle;
+typedef struct Bullet Bullet;
+typedef struct RigidBody RigidBody;
+typedef struct Bond Bond;
+typedef struct StreetLane StreetLane;
+typedef struct Street Street;
+typedef struct StreetIntersection StreetIntersection;
+typedef struct TrafficCar TrafficCar;
+typedef struct ShopCar ShopCar;
+typedef struct Building Building;
+typedef struct Event Event;
+
+struct EarShot {
+	int active;
+	int playerID;
+	int humanID;
+	int receivingItemID;
+	int transmittingItemID;
+	int unk2;
+	int unk3;
+	int unk4;
+	float distance;
+	float volume;
+};
+
+struct Connection {
+	unsigned int address;
+	unsigned int port;
+	int unk0[3];
+	int adminVisible;
+	int playerID;
+	int unk1;
+	int bandwidth;
+	int timeoutTime;
+	padding unk2[0x4c - 0x24 - 4];
+	int numReceivedEvents;
+	padding unk3[0x5c - 0x4c - 4];
+	EarShot earShots[8];
+	padding unk4[0x19c - (0x5c + (sizeof(EarShot) * 8))];
+	int spectatingHumanID;
+	padding unk5[0x2E1E0 - 0x19c - 4];
+};
+
+struct Account {
+	int subRosaID;
+	int phoneNumber;
+	long long steamID;
+	char name[32];
+	int unk0;
+	int money;
+	int corporateRating;
+	int criminalRating;
+	int spawnTimer;
+	int playTime;
+	padding unk1[0x60 - 0x44 - 4];
+	int banTime;
+	padding unk2[112 - 104];
+};
+
+struct Vector {
+	float x, y, z;
+};
+
+struct RotMatrix {
+	float x1, y1, z1;
+	float x2, y2, z2;
+	float x3, y3, z3;
+};
+
+struct LineIntersectResult {
+	Vector pos;
+	Vector normal;
+	float fraction;
+	float unk0;
+	int unk1;
+	int unk2;
+	int unk3;
+	int unk4;
+	int vehicleFace;
+	int humanBone;
+	int unk6;
+	int unk7;
+	int unk8;
+	int unk9;
+	int unk10;
+	int unk11;
+	int unk12;
+	int areaId;
+	int blockX;
+	int blockY;
+	int blockZ;
+	int unk17;
+	int unk18;
+	int matMaybe;
+	int unk20;
+	int unk21;
+	int unk22;
+	int unk23;
+	int unk24;
+	int unk25;
+	int unk26;
+	int unk27;
+};
+
+struct Action {
+	int type;
+	int a;
+	int b;
+	int c;
+	int d;
+	char text[64];
+};
+
+struct MenuButton {
+	int id;
+	char text[64];
+	int unk;
+};
+
+struct Voice {
+	int isSilenced;
+	int unk0;
+	int volumeLevel;
+	int currentFrame;
+	int unk1;
+	int frameVolumeLevels[64];
+	int frameSizes[64];
+	unsigned char frames[64][2048];
+};
+
+struct Player {
+	int active;
+	char name[32];
+	int unk0;
+	int unk1;
+	unsigned int subRosaID;
+	unsigned int phoneNumber;
+	int isAdmin;
+	unsigned int adminAttempts;
+	unsigned int accountID;
+	padding unk2[0x48 - 0x3C - 4];
+	int isReady;
+	int money;
+	int teamMoney;
+	int budget;
+	int corporateRating;
+	int criminalRating;
+	padding unk5[0x84 - 0x5c - 4];
+	unsigned int team;
+	unsigned int teamSwitchTimer;
+	int stocks;
+	int unk6[2];
+	int spawnTimer;
+	int humanID;
+	padding unk7[0xa0 - 0x9c - 4];
+	float gearX;
+	float leftRightInput;
+	float gearY;
+	float forwardBackInput;
+	float viewYawDelta;
+	float viewPitch;
+	float freeLookYaw;
+	float freeLookPitch;
+	float viewYaw;
+	padding unk8[0xe4 - 0xc0 - 4];
+	float viewPitchDelta;
+	padding unk9[0x120 - 0xe4 - 4];
+	unsigned int inputFlags;
+	unsigned int lastInputFlags;
+	padding unk10[0x134 - 0x124 - 4];
+	int zoomLevel;
+	padding unk11[0x158 - 0x134 - 4];
+	int inputType;
+	padding unk12[0x164 - 0x158 - 4];
+	int menuTab;
+	padding unk13[0x1b4 - 0x164 - 4];
+	int numActions;
+	int lastNumActions;
+	padding unk14[0x1c8 - 0x1b8 - 4];
+	Action actions[64];
+	padding unk15[0x1b14 - (0x1c8 + (sizeof(Action) * 64))];
+	int numMenuButtons;
+	MenuButton menuButtons[32];
+	padding unk16[0x2d18 - (0x1b18 + (sizeof(MenuButton) * 32))];
+	int isBot;
+	int isZombie;
+	padding unk17[0x2d38 - 0x2d1c - 4];
+	int botHasDestination;
+	Vector botDestination;
+	padding unk18[0x37ac - 0x2d3c - 12];
+	int gender;
+	int skinColor;
+	int hairColor;
+	int hair;
+	int eyeColor;
+	int model;
+	int suitColor;
+	int tieColor;
+	int unk19;
+	int head;
+	int necklace;
+	padding unk20[0x3834 - 0x37d4 - 4];
+};
+
+struct Bone {
+	int bodyID;
+	Vector pos;
+	Vector pos2;
+	Vector vel;
+	int unk0;
+	int unk1;
+	int unk2;
+	RotMatrix rot;
+	padding unk3[0x138 - 0x34 - sizeof(RotMatrix)];
+};
+
+struct InventorySlot {
+	int count;
+	int primaryItemID;
+	int secondaryItemID;
+	padding unk01[0x1c];
+};
+
+struct Human {
+	int active;
+	int physicsSim;
+	int playerID;
+	int accountID;
+	int unk1;
+	int unk2;
+	int unk3;
+	int stamina;
+	int maxStamina;
+	int unk4;
+	int vehicleID;
+	int vehicleSeat;
+	int lastVehicleID;
+	int lastVehicleCooldown;
+	unsigned int despawnTime;
+	int oldHealth;
+	int isImmortal;
+	int unk10;
+	int unk11;
+	int unk12;
+	unsigned int spawnProtection;
+	int isOnGround;
+	int movementState;
+	int unk13;
+	int zoomLevel;
+	int unk14;
+	int unk15;
+	int unk16;
+	int unk17;
+	int unk18;
+	int damage;
+	int isStanding;
+	Vector pos;
+	Vector pos2;
+	float viewYaw;
+	float viewPitch;
+	padding unk19[0xd8 - 0x9c - 4];
+	float viewYaw2;
+	padding unk20[0x12c - 0xd8 - 4];
+	float strafeInput;
+	float unk21;
+	float walkInput;
+	int unk22;
+	float viewPitch2;
+	padding unk23[0x214 - 0x13c - 4];
+	unsigned int inputFlags;
+	unsigned int lastInputFlags;
+	padding unk24[0x220 - 0x218 - 4];
+	Bone bones[16];
+	padding unk25[0x6ad0 - (0x220 + (sizeof(Bone) * 16))];
+	InventorySlot inventorySlots[6];
+	padding unk26[0x6d50 - (0x6ad0 + (sizeof(InventorySlot) * 6))];
+	int health;
+	int bloodLevel;
+	int isBleeding;
+	int chestHP;
+	int unk27;
+	int headHP;
+	int unk28;
+	int leftArmHP;
+	int unk29;
+	int rightArmHP;
+	int unk30;
+	int leftLegHP;
+	int unk31;
+	int rightLegHP;
+	padding unk32[0x6ddc - 0x6d84 - 4];
+	int progressBar;
+	int inventoryAnimationFlags;
+	float inventoryAnimationProgress;
+	int inventoryAnimationDuration;
+	int inventoryAnimationHand;
+	int inventoryAnimationSlot;
+	int inventoryAnimationCounterFinished;
+	int inventoryAnimationCounter;
+	padding unk33[0x6f80 - 0x6df8 - 4];
+	int gender;
+	int head;
+	int skinColor;
+	int hairColor;
+	int hair;
+	int eyeColor;
+	int model;
+	int suitColor;
+	int tieColor;
+	int unk34;
+	int necklace;
+	int lastUpdatedWantedGroup;
+	padding unk35[0x6FF8 - 0x6fac - 4];
+};
+
+struct ItemType {
+	int unk0;
+	int price;
+	float mass;
+	int unk1;
+	int isGun;
+	int messedUpAiming;
+	int fireRate;
+	int bulletType;
+	int unk2;
+	int magazineAmmo;
+	float bulletVelocity;
+	float bulletSpread;
+	char name[64];
+	padding unk3[0x7c - 0x30 - 64];
+	int numHands;
+	Vector rightHandPos;
+	Vector leftHandPos;
+	padding unk4[0xb0 - 0x8c - 12];
+	float primaryGripStiffness;
+	padding unk5[0xbc - 0xb0 - 4];
+	float primaryGripRotation;
+	float secondaryGripStiffness;
+	padding unk6[0xcc - 0xc0 - 4];
+	float secondaryGripRotation;
+	padding unk7[0x104 - 0xcc - 4];
+	Vector boundsCenter;
+	padding unk8[0x11c - 0x104 - 12];
+	int canMountTo[maxNumberOfItemTypes];
+	padding unk9[0x1394 - 0x11c - (4 * maxNumberOfItemTypes)];
+	Vector gunHoldingPos;
+	padding unk10[0x13D0 - 0x1394 - 12];
+};
+
+struct Item {
+	int active;
+	int physicsSim;
+	int physicsSettled;
+	int physicsSettledTimer;
+	int isStatic;
+	int type;
+	int unk0;
+	int despawnTime;
+	int grenadePrimerID;
+	int parentHumanID;
+	int parentItemID;
+	int parentSlot;
+	padding unk1[0x58 - 0x2c - 4];
+	int bodyID;
+	Vector pos;
+	Vector pos2;
+	Vector vel;
+	Vector vel2;
+	Vector vel3;
+	Vector vel4;
+	RotMatrix rot;
+	padding unk2[0x13c - 0xa4 - 36];
+	int cooldown;
+	int unk3;
+	int bullets;
+	padding unk4[0x15C - 0x144 - 4];
+	int connectedPhoneID;
+	int phoneNumber;
+	int unk5;
+	int displayPhoneNumber;
+	int enteredPhoneNumber;
+	padding unk6[0x278 - 0x16C - 4];
+	int phoneTexture;
+	int unk7;
+	int vehicleID;
+	padding unk8[0x2a0 - 0x280 - 4];
+	int cashSpread;
+	int cashBillAmount;
+	int cashPureValue;
+	padding unk9[0x368 - 0x2a8 - 4];
+	unsigned int computerCurrentLine;
+	unsigned int computerTopLine;
+	int computerCursor;
+	char computerLines[32][64];
+	padding unk10[0xb74 - 0x374 - (64 * 32)];
+	unsigned char computerLineColors[32][64];
+	padding unk11[0x1658 - 0xb74 - (64 * 32)];
+	int computerTeam;
+	padding unk12[0x1B80 - 0x1658 - 4];
+};
+
+struct VehicleType {
+	int usesExternalModel;
+	int unk0;
+	int controllableState;
+	padding unk1[0x14 - 0x08 - 4];
+	char name[32];
+	int price;
+	float mass;
+	padding unk2[0x185C0 - 0x38 - 4];
+};
+
+struct Vehicle {
+	int active;
+	unsigned int type;
+	int controllableState;
+	int health;
+	int unk1;
+	int lastDriverPlayerID;
+	unsigned int color;
+	short despawnTime;
+	short spawnedState;
+	int isLocked;
+	int unk3;
+	int bodyID;
+	Vector pos;
+	Vector pos2;
+	RotMatrix rot;
+	int unk4;
+	Vector vel;
+	padding unk5[0x27fc - 0x6c - 12];
+	int windowStates[8];
+	padding unk6[0x3600 - 0x27fc - (4 * 8)];
+	float gearX;
+	float steerControl;
+	float gearY;
+	float gasControl;
+	padding unk7[0x3648 - 0x360c - 4];
+	int trafficCarID;
+	padding unk8[0x3930 - 0x3648 - 4];
+	int engineRPM;
+	padding unk9[0x4fa8 - 0x3930 - 4];
+	int bladeBodyID;
+	padding unk10[0x50dc - 0x4fa8 - 4];
+	int numSeats;
+	padding unk11[0x5168 - 0x50dc - 4];
+};
+
+struct Bullet {
+	unsigned int type;
+	int time;
+	int playerID;
+	float unk0;
+	float unk1;
+	Vector lastPos;
+	Vector pos;
+	Vector vel;
+	padding unk2[92 - 56];
+};
+
+struct RigidBody {
+	int active;
+	int type;
+	int settled;
+	int unk0;
+	int unk01;
+	float mass;
+	Vector pos;
+	Vector vel;
+	Vector startVel;
+	RotMatrix rot;
+	RotMatrix rotVel;
+	padding unk3[0xBC - 0x60 - sizeof(RotMatrix)];
+};
+
+struct Bond {
+	int active;
+	int type;
+	int unk0;
+	int despawnTime;
+	padding unk1[0x2c - 0x0c - 4];
+	Vector globalPos;
+	Vector localPos;
+	Vector otherLocalPos;
+	padding unk2[0x98 - 0x44 - 12];
+	int bodyID;
+	int otherBodyID;
+	padding unk3[0xF4 - 0x9c - 4];
+};
+
+struct StreetLane {
+	int direction;
+	Vector posA;
+	Vector posB;
+};
+
+struct Street {
+	char name[32];
+	int unk0;
+	int intersectionA;
+	int intersectionB;
+	int unk1[3];
+	int numLanes;
+	StreetLane lanes[16];
+	float unk2[6];
+	Vector trafficCuboidA;
+	Vector trafficCuboidB;
+	int numTraffic;
+	padding unk3[0x630 - 0x22c - 4];
+};
+
+struct StreetIntersection {
+	int unk0[3];
+	Vector pos;
+	int streetEast;
+	int streetSouth;
+	int streetWest;
+	int streetNorth;
+	padding unk1[0x44 - 0x24 - 4];
+	int lightsState;
+	int lightsTimer;
+	int lightsTimerMax;
+	int lightEast;
+	int lightSouth;
+	int lightWest;
+	int lightNorth;
+	padding unk2[0x88 - 0x5c - 4];
+};
+
+struct TrafficCar {
+	int type;
+	int humanID;
+	int vehicleID;
+	int state;
+	Vector pos;
+	Vector vel;
+	float yaw;
+	RotMatrix rot;
+	padding unk0[0x7c - 0x2c - sizeof(RotMatrix)];
+	int isBot;
+	int isAggressive;
+	padding unk1[0x5d8 - 0x80 - 4];
+	int color;
+	padding unk2[0x5fc - 0x5d8 - 4];
+};
+
+struct ShopCar {
+	int type;
+	int price;
+	int color;
+};
+
+struct Building {
+	int type;
+	int unk0[3];
+	Vector pos;
+	RotMatrix spawnRot;
+	Vector interiorCuboidA;
+	Vector interiorCuboidB;
+	padding unk1[0xC9F4 - 0x4c - 12];
+	int numShopCars;
+	ShopCar shopCars[16];
+	int shopCarSales;
+	padding unk2[0xDB0C - 0xCAB8 - 4];
+};
+
+struct Event {
+	int type;
+	int tickCreated;
+	Vector vectorA;
+	Vector vectorB;
+	int a;
+	int b;
+	int c;
+	int d;
+	float floatA;
+	float floatB;
+	int unk0;
+	int unk1;
+	char message[64];
+};
+)";
+
+static const struct {
+	const char* name;
+	size_t size;
+} typeSizes[] = {
+    {"EarShot", sizeof(EarShot)},
+    {"Connection", sizeof(Connection)},
+    {"Account", sizeof(Account)},
+    {"Vector", sizeof(Vector)},
+    {"RotMatrix", sizeof(RotMatrix)},
+    {"LineIntersectResult", sizeof(LineIntersectResult)},
+    {"Action", sizeof(Action)},
+    {"MenuButton", sizeof(MenuButton)},
+    {"Voice", sizeof(Voice)},
+    {"Player", sizeof(Player)},
+    {"Bone", sizeof(Bone)},
+    {"InventorySlot", sizeof(InventorySlot)},
+    {"Human", sizeof(Human)},
+    {"ItemType", sizeof(ItemType)},
+    {"Item", sizeof(Item)},
+    {"VehicleType", sizeof(VehicleType)},
+    {"Vehicle", sizeof(Vehicle)},
+    {"Bullet", sizeof(Bullet)},
+    {"RigidBody", sizeof(RigidBody)},
+    {"Bond", sizeof(Bond)},
+    {"StreetLane", sizeof(StreetLane)},
+    {"Street", sizeof(Street)},
+    {"StreetIntersection", sizeof(StreetIntersection)},
+    {"TrafficCar", sizeof(TrafficCar)},
+    {"ShopCar", sizeof(ShopCar)},
+    {"Building", sizeof(Building)},
+    {"Event", sizeof(Event)},
+};
+
+#define FIELD(type, field) {#type, #field, offsetof(type, field)}
+
+// Every field of the definitions but padding
+static const struct {
+	const char* type;
+	const char* field;
+	size_t offset;
+} fieldOffsets[] = {
+    FIELD(EarShot, active),
+    FIELD(EarShot, playerID),
+    FIELD(EarShot, humanID),
+    FIELD(EarShot, receivingItemID),
+    FIELD(EarShot, transmittingItemID),
+    FIELD(EarShot, unk2),
+    FIELD(EarShot, unk3),
+    FIELD(EarShot, unk4),
+    FIELD(EarShot, distance),
+    FIELD(EarShot, volume),
+    FIELD(Connection, address),
+    FIELD(Connection, port),
+    FIELD(Connection, unk0),
+    FIELD(Connection, adminVisible),
+    FIELD(Connection, playerID),
+    FIELD(Connection, unk1),
+    FIELD(Connection, bandwidth),
+    FIELD(Connection, timeoutTime),
+    FIELD(Connection, numReceivedEvents),
+    FIELD(Connection, earShots),
+    FIELD(Connection, spectatingHumanID),
+    FIELD(Account, subRosaID),
+    FIELD(Account, phoneNumber),
+    FIELD(Account, steamID),
+    FIELD(Account, name),
+    FIELD(Account, unk0),
+    FIELD(Account, money),
+    FIELD(Account, corporateRating),
+    FIELD(Account, criminalRating),
+    FIELD(Account, spawnTimer),
+    FIELD(Account, playTime),
+    FIELD(Account, banTime),
+    FIELD(Vector, x),
+    FIELD(Vector, y),
+    FIELD(Vector, z),
+    FIELD(RotMatrix, x1),
+    FIELD(RotMatrix, y1),
+    FIELD(RotMatrix, z1),
+    FIELD(RotMatrix, x2),
+    FIELD(RotMatrix, y2),
+    FIELD(RotMatrix, z2),
+    FIELD(RotMatrix, x3),
+    FIELD(RotMatrix, y3),
+    FIELD(RotMatrix, z3),
+    FIELD(LineIntersectResult, pos),
+    FIELD(LineIntersectResult, normal),
+    FIELD(LineIntersectResult, fraction),
+    FIELD(LineIntersectResult, unk0),
+    FIELD(LineIntersectResult, unk1),
+    FIELD(LineIntersectResult, unk2),
+    FIELD(LineIntersectResult, unk3),
+    FIELD(LineIntersectResult, unk4),
+    FIELD(LineIntersectResult, vehicleFace),
+    FIELD(LineIntersectResult, humanBone),
+    FIELD(LineIntersectResult, unk6),
+    FIELD(LineIntersectResult, unk7),
+    FIELD(LineIntersectResult, unk8),
+    FIELD(LineIntersectResult, unk9),
+    FIELD(LineIntersectResult, unk10),
+    FIELD(LineIntersectResult, unk11),
+    FIELD(LineIntersectResult, unk12),
+    FIELD(LineIntersectResult, areaId),
+    FIELD(LineIntersectResult, blockX),
+    FIELD(LineIntersectResult, blockY),
+    FIELD(LineIntersectResult, blockZ),
+    FIELD(LineIntersectResult, unk17),
+    FIELD(LineIntersectResult, unk18),
+    FIELD(LineIntersectResult, matMaybe),
+    FIELD(LineIntersectResult, unk20),
+    FIELD(LineIntersectResult, unk21),
+    FIELD(LineIntersectResult, unk22),
+    FIELD(LineIntersectResult, unk23),
+    FIELD(LineIntersectResult, unk24),
+    FIELD(LineIntersectResult, unk25),
+    FIELD(LineIntersectResult, unk26),
+    FIELD(LineIntersectResult, unk27),
+    FIELD(Action, type),
+    FIELD(Action, a),
+    FIELD(Action, b),
+    FIELD(Action, c),
+    FIELD(Action, d),
+    FIELD(Action, text),
+    FIELD(MenuButton, id),
+    FIELD(MenuButton, text),
+    FIELD(MenuButton, unk),
+    FIELD(Voice, isSilenced),
+    FIELD(Voice, unk0),
+    FIELD(Voice, volumeLevel),
+    FIELD(Voice, currentFrame),
+    FIELD(Voice, unk1),
+    FIELD(Voice, frameVolumeLevels),
+    FIELD(Voice, frameSizes),
+    FIELD(Voice, frames),
+    FIELD(Player, active),
+    FIELD(Player, name),
+    FIELD(Player, unk0),
+    FIELD(Player, unk1),
+    FIELD(Player, subRosaID),
+    FIELD(Player, phoneNumber),
+    FIELD(Player, isAdmin),
+    FIELD(Player, adminAttempts),
+    FIELD(Player, accountID),
+    FIELD(Player, isReady),
+    FIELD(Player, money),
+    FIELD(Player, teamMoney),
+    FIELD(Player, budget),
+    FIELD(Player, corporateRating),
+    FIELD(Player, criminalRating),
+    FIELD(Player, team),
+    FIELD(Player, teamSwitchTimer),
+    FIELD(Player, stocks),
+    FIELD(Player, unk6),
+    FIELD(Player, spawnTimer),
+    FIELD(Player, humanID),
+    FIELD(Player, gearX),
+    FIELD(Player, leftRightInput),
+    FIELD(Player, gearY),
+    FIELD(Player, forwardBackInput),
+    FIELD(Player, viewYawDelta),
+    FIELD(Player, viewPitch),
+    FIELD(Player, freeLookYaw),
+    FIELD(Player, freeLookPitch),
+    FIELD(Player, viewYaw),
+    FIELD(Player, viewPitchDelta),
+    FIELD(Player, inputFlags),
+    FIELD(Player, lastInputFlags),
+    FIELD(Player, zoomLevel),
+    FIELD(Player, inputType),
+    FIELD(Player, menuTab),
+    FIELD(Player, numActions),
+    FIELD(Player, lastNumActions),
+    FIELD(Player, actions),
+    FIELD(Player, numMenuButtons),
+    FIELD(Player, menuButtons),
+    FIELD(Player, isBot),
+    FIELD(Player, isZombie),
+    FIELD(Player, botHasDestination),
+    FIELD(Player, botDestination),
+    FIELD(Player, gender),
+    FIELD(Player, skinColor),
+    FIELD(Player, hairColor),
+    FIELD(Player, hair),
+    FIELD(Player, eyeColor),
+    FIELD(Player, model),
+    FIELD(Player, suitColor),
+    FIELD(Player, tieColor),
+    FIELD(Player, unk19),
+    FIELD(Player, head),
+    FIELD(Player, necklace),
+    FIELD(Bone, bodyID),
+    FIELD(Bone, pos),
+    FIELD(Bone, pos2),
+    FIELD(Bone, vel),
+    FIELD(Bone, unk0),
+    FIELD(Bone, unk1),
+    FIELD(Bone, unk2),
+    FIELD(Bone, rot),
+    FIELD(InventorySlot, count),
+    FIELD(InventorySlot, primaryItemID),
+    FIELD(InventorySlot, secondaryItemID),
+    FIELD(Human, active),
+    FIELD(Human, physicsSim),
+    FIELD(Human, playerID),
+    FIELD(Human, accountID),
+    FIELD(Human, unk1),
+    FIELD(Human, unk2),
+    FIELD(Human, unk3),
+    FIELD(Human, stamina),
+    FIELD(Human, maxStamina),
+    FIELD(Human, unk4),
+    FIELD(Human, vehicleID),
+    FIELD(Human, vehicleSeat),
+    FIELD(Human, lastVehicleID),
+    FIELD(Human, lastVehicleCooldown),
+    FIELD(Human, despawnTime),
+    FIELD(Human, oldHealth),
+    FIELD(Human, isImmortal),
+    FIELD(Human, unk10),
+    FIELD(Human, unk11),
+    FIELD(Human, unk12),
+    FIELD(Human, spawnProtection),
+    FIELD(Human, isOnGround),
+    FIELD(Human, movementState),
+    FIELD(Human, unk13),
+    FIELD(Human, zoomLevel),
+    FIELD(Human, unk14),
+    FIELD(Human, unk15),
+    FIELD(Human, unk16),
+    FIELD(Human, unk17),
+    FIELD(Human, unk18),
+    FIELD(Human, damage),
+    FIELD(Human, isStanding),
+    FIELD(Human, pos),
+    FIELD(Human, pos2),
+    FIELD(Human, viewYaw),
+    FIELD(Human, viewPitch),
+    FIELD(Human, viewYaw2),
+    FIELD(Human, strafeInput),
+    FIELD(Human, unk21),
+    FIELD(Human, walkInput),
+    FIELD(Human, unk22),
+    FIELD(Human, viewPitch2),
+    FIELD(Human, inputFlags),
+    FIELD(Human, lastInputFlags),
+    FIELD(Human, bones),
+    FIELD(Human, inventorySlots),
+    FIELD(Human, health),
+    FIELD(Human, bloodLevel),
+    FIELD(Human, isBleeding),
+    FIELD(Human, chestHP),
+    FIELD(Human, unk27),
+    FIELD(Human, headHP),
+    FIELD(Human, unk28),
+    FIELD(Human, leftArmHP),
+    FIELD(Human, unk29),
+    FIELD(Human, rightArmHP),
+    FIELD(Human, unk30),
+    FIELD(Human, leftLegHP),
+    FIELD(Human, unk31),
+    FIELD(Human, rightLegHP),
+    FIELD(Human, progressBar),
+    FIELD(Human, inventoryAnimationFlags),
+    FIELD(Human, inventoryAnimationProgress),
+    FIELD(Human, inventoryAnimationDuration),
+    FIELD(Human, inventoryAnimationHand),
+    FIELD(Human, inventoryAnimationSlot),
+    FIELD(Human, inventoryAnimationCounterFinished),
+    FIELD(Human, inventoryAnimationCounter),
+    FIELD(Human, gender),
+    FIELD(Human, head),
+    FIELD(Human, skinColor),
+    FIELD(Human, hairColor),
+    FIELD(Human, hair),
+    FIELD(Human, eyeColor),
+    FIELD(Human, model),
+    FIELD(Human, suitColor),
+    FIELD(Human, tieColor),
+    FIELD(Human, unk34),
+    FIELD(Human, necklace),
+    FIELD(Human, lastUpdatedWantedGroup),
+    FIELD(ItemType, unk0),
+    FIELD(ItemType, price),
+    FIELD(ItemType, mass),
+    FIELD(ItemType, unk1),
+    FIELD(ItemType, isGun),
+    FIELD(ItemType, messedUpAiming),
+    FIELD(ItemType, fireRate),
+    FIELD(ItemType, bulletType),
+    FIELD(ItemType, unk2),
+    FIELD(ItemType, magazineAmmo),
+    FIELD(ItemType, bulletVelocity),
+    FIELD(ItemType, bulletSpread),
+    FIELD(ItemType, name),
+    FIELD(ItemType, numHands),
+    FIELD(ItemType, rightHandPos),
+    FIELD(ItemType, leftHandPos),
+    FIELD(ItemType, primaryGripStiffness),
+    FIELD(ItemType, primaryGripRotation),
+    FIELD(ItemType, secondaryGripStiffness),
+    FIELD(ItemType, secondaryGripRotation),
+    FIELD(ItemType, boundsCenter),
+    FIELD(ItemType, canMountTo),
+    FIELD(ItemType, gunHoldingPos),
+    FIELD(Item, active),
+    FIELD(Item, physicsSim),
+    FIELD(Item, physicsSettled),
+    FIELD(Item, physicsSettledTimer),
+    FIELD(Item, isStatic),
+    FIELD(Item, type),
+    FIELD(Item, unk0),
+    FIELD(Item, despawnTime),
+    FIELD(Item, grenadePrimerID),
+    FIELD(Item, parentHumanID),
+    FIELD(Item, parentItemID),
+    FIELD(Item, parentSlot),
+    FIELD(Item, bodyID),
+    FIELD(Item, pos),
+    FIELD(Item, pos2),
+    FIELD(Item, vel),
+    FIELD(Item, vel2),
+    FIELD(Item, vel3),
+    FIELD(Item, vel4),
+    FIELD(Item, rot),
+    FIELD(Item, cooldown),
+    FIELD(Item, unk3),
+    FIELD(Item, bullets),
+    FIELD(Item, connectedPhoneID),
+    FIELD(Item, phoneNumber),
+    FIELD(Item, unk5),
+    FIELD(Item, displayPhoneNumber),
+    FIELD(Item, enteredPhoneNumber),
+    FIELD(Item, phoneTexture),
+    FIELD(Item, unk7),
+    FIELD(Item, vehicleID),
+    FIELD(Item, cashSpread),
+    FIELD(Item, cashBillAmount),
+    FIELD(Item, cashPureValue),
+    FIELD(Item, computerCurrentLine),
+    FIELD(Item, computerTopLine),
+    FIELD(Item, computerCursor),
+    FIELD(Item, computerLines),
+    FIELD(Item, computerLineColors),
+    FIELD(Item, computerTeam),
+    FIELD(VehicleType, usesExternalModel),
+    FIELD(VehicleType, unk0),
+    FIELD(VehicleType, controllableState),
+    FIELD(VehicleType, name),
+    FIELD(VehicleType, price),
+    FIELD(VehicleType, mass),
+    FIELD(Vehicle, active),
+    FIELD(Vehicle, type),
+    FIELD(Vehicle, controllableState),
+    FIELD(Vehicle, health),
+    FIELD(Vehicle, unk1),
+    FIELD(Vehicle, lastDriverPlayerID),
+    FIELD(Vehicle, color),
+    FIELD(Vehicle, despawnTime),
+    FIELD(Vehicle, spawnedState),
+    FIELD(Vehicle, isLocked),
+    FIELD(Vehicle, unk3),
+    FIELD(Vehicle, bodyID),
+    FIELD(Vehicle, pos),
+    FIELD(Vehicle, pos2),
+    FIELD(Vehicle, rot),
+    FIELD(Vehicle, unk4),
+    FIELD(Vehicle, vel),
+    FIELD(Vehicle, windowStates),
+    FIELD(Vehicle, gearX),
+    FIELD(Vehicle, steerControl),
+    FIELD(Vehicle, gearY),
+    FIELD(Vehicle, gasControl),
+    FIELD(Vehicle, trafficCarID),
+    FIELD(Vehicle, engineRPM),
+    FIELD(Vehicle, bladeBodyID),
+    FIELD(Vehicle, numSeats),
+    FIELD(Bullet, type),
+    FIELD(Bullet, time),
+    FIELD(Bullet, playerID),
+    FIELD(Bullet, unk0),
+    FIELD(Bullet, unk1),
+    FIELD(Bullet, lastPos),
+    FIELD(Bullet, pos),
+    FIELD(Bullet, vel),
+    FIELD(RigidBody, active),
+    FIELD(RigidBody, type),
+    FIELD(RigidBody, settled),
+    FIELD(RigidBody, unk0),
+    FIELD(RigidBody, unk01),
+    FIELD(RigidBody, mass),
+    FIELD(RigidBody, pos),
+    FIELD(RigidBody, vel),
+    FIELD(RigidBody, startVel),
+    FIELD(RigidBody, rot),
+    FIELD(RigidBody, rotVel),
+    FIELD(Bond, active),
+    FIELD(Bond, type),
+    FIELD(Bond, unk0),
+    FIELD(Bond, despawnTime),
+    FIELD(Bond, globalPos),
+    FIELD(Bond, localPos),
+    FIELD(Bond, otherLocalPos),
+    FIELD(Bond, bodyID),
+    FIELD(Bond, otherBodyID),
+    FIELD(StreetLane, direction),
+    FIELD(StreetLane, posA),
+    FIELD(StreetLane, posB),
+    FIELD(Street, name),
+    FIELD(Street, unk0),
+    FIELD(Street, intersectionA),
+    FIELD(Street, intersectionB),
+    FIELD(Street, unk1),
+    FIELD(Street, numLanes),
+    FIELD(Street, lanes),
+    FIELD(Street, unk2),
+    FIELD(Street, trafficCuboidA),
+    FIELD(Street, trafficCuboidB),
+    FIELD(Street, numTraffic),
+    FIELD(StreetIntersection, unk0),
+    FIELD(StreetIntersection, pos),
+    FIELD(StreetIntersection, streetEast),
+    FIELD(StreetIntersection, streetSouth),
+    FIELD(StreetIntersection, streetWest),
+    FIELD(StreetIntersection, streetNorth),
+    FIELD(StreetIntersection, lightsState),
+    FIELD(StreetIntersection, lightsTimer),
+    FIELD(StreetIntersection, lightsTimerMax),
+    FIELD(StreetIntersection, lightEast),
+    FIELD(StreetIntersection, lightSouth),
+    FIELD(StreetIntersection, lightWest),
+    FIELD(StreetIntersection, lightNorth),
+    FIELD(TrafficCar, type),
+    FIELD(TrafficCar, humanID),
+    FIELD(TrafficCar, vehicleID),
+    FIELD(TrafficCar, state),
+    FIELD(TrafficCar, pos),
+    FIELD(TrafficCar, vel),
+    FIELD(TrafficCar, yaw),
+    FIELD(TrafficCar, rot),
+    FIELD(TrafficCar, isBot),
+    FIELD(TrafficCar, isAggressive),
+    FIELD(TrafficCar, color),
+    FIELD(ShopCar, type),
+    FIELD(ShopCar, price),
+    FIELD(ShopCar, color),
+    FIELD(Building, type),
+    FIELD(Building, unk0),
+    FIELD(Building, pos),
+    FIELD(Building, spawnRot),
+    FIELD(Building, interiorCuboidA),
+    FIELD(Building, interiorCuboidB),
+    FIELD(Building, numShopCars),
+    FIELD(Building, shopCars),
+    FIELD(Building, shopCarSales),
+    FIELD(Event, type),
+    FIELD(Event, tickCreated),
+    FIELD(Event, vectorA),
+    FIELD(Event, vectorB),
+    FIELD(Event, a),
+    FIELD(Event, b),
+    FIELD(Event, c),
+    FIELD(Event, d),
+    FIELD(Event, floatA),
+    FIELD(Event, floatB),
+    FIELD(Event, unk0),
+    FIELD(Event, unk1),
+    FIELD(Event, message),
+};
+
+#undef FIELD
+
+// Methods for Vector and RotMatrix cdata matching the usertypes
+static const char* const metatypes = R"(
+local ffi = require('ffi')
+local floor = math.floor
+local sqrt = math.sqrt
+
+local Vector = ffi.typeof('Vector')
+local RotMatrix = ffi.typeof('RotMatrix')
+
+-- Same as converting to int in C++
+local function truncate (n)
+	return n >= 0 and floor(n) or -floor(-n)
+end
+
+local vectorMethods = {class = 'Vector'}
+local vectorMeta = {__index = vectorMethods}
+
+function vectorMeta.__tostring (a)
+	return string.format('Vector(%f, %f, %f)', a.x, a.y, a.z)
+end
+
+function vectorMeta.__add (a, b)
+	return Vector(a.x + b.x, a.y + b.y, a.z + b.z)
+end
+
+function vectorMeta.__sub (a, b)
+	return Vector(a.x - b.x, a.y - b.y, a.z - b.z)
+end
+
+function vectorMeta.__mul (a, b)
+	if type(a) == 'number' then
+		a, b = b, a
+	end
+
+	if type(b) == 'number' then
+		return Vector(a.x * b, a.y * b, a.z * b)
+	end
+
+	return Vector(
+		b.x1 * a.x + b.y1 * a.y + b.z1 * a.z,
+		b.x2 * a.x + b.y2 * a.y + b.z2 * a.z,
+		b.x3 * a.x + b.y3 * a.y + b.z3 * a.z
+	)
+end
+
+function vectorMeta.__div (a, scalar)
+	return Vector(a.x / scalar, a.y / scalar, a.z / scalar)
+end
+
+function vectorMeta.__unm (a)
+	return Vector(-a.x, -a.y, -a.z)
+end
+
+function vectorMethods.add (self, other)
+	self.x = self.x + other.x
+	self.y = self.y + other.y
+	self.z = self.z + other.z
+end
+
+function vectorMethods.mult (self, scalar)
+	self.x = self.x * scalar
+	self.y = self.y * scalar
+	self.z = self.z * scalar
+end
+
+function vectorMethods.set (self, other)
+	self.x = other.x
+	self.y = other.y
+	self.z = other.z
+end
+
+function vectorMethods.clone (self)
+	return Vector(self.x, self.y, self.z)
+end
+
+function vectorMethods.distSquare (self, other)
+	local dx = self.x - other.x
+	local dy = self.y - other.y
+	local dz = self.z - other.z
+	return dx * dx + dy * dy + dz * dz
+end
+
+function vectorMethods.dist (self, other)
+	return sqrt(vectorMethods.distSquare(self, other))
+end
+
+function vectorMethods.lengthSquare (self)
+	return self.x * self.x + self.y * self.y + self.z * self.z
+end
+
+function vectorMethods.length (self)
+	return sqrt(vectorMethods.lengthSquare(self))
+end
+
+function vectorMethods.dot (self, other)
+	return self.x * other.x + self.y * other.y + self.z * other.z
+end
+
+function vectorMethods.getBlockPos (self)
+	return truncate(self.x / 4), truncate(self.y / 4), truncate(self.z / 4)
+end
+
+function vectorMethods.normalize (self)
+	local length = vectorMethods.length(self)
+	self.x = self.x / length
+	self.y = self.y / length
+	self.z = self.z / length
+end
+
+local rotMatrixMethods = {class = 'RotMatrix'}
+local rotMatrixMeta = {__index = rotMatrixMethods}
+
+function rotMatrixMeta.__tostring (a)
+	return string.format(
+		'RotMatrix(%f, %f, %f, %f, %f, %f, %f, %f, %f)',
+		a.x1, a.y1, a.z1, a.x2, a.y2, a.z2, a.x3, a.y3, a.z3
+	)
+end
+
+function rotMatrixMeta.__mul (a, b)
+	return RotMatrix(
+		a.x1 * b.x1 + a.y1 * b.x2 + a.z1 * b.x3,
+		a.x1 * b.y1 + a.y1 * b.y2 + a.z1 * b.y3,
+		a.x1 * b.z1 + a.y1 * b.z2 + a.z1 * b.z3,
+
+		a.x2 * b.x1 + a.y2 * b.x2 + a.z2 * b.x3,
+		a.x2 * b.y1 + a.y2 * b.y2 + a.z2 * b.y3,
+		a.x2 * b.z1 + a.y2 * b.z2 + a.z2 * b.z3,
+
+		a.x3 * b.x1 + a.y3 * b.x2 + a.z3 * b.x3,
+		a.x3 * b.y1 + a.y3 * b.y2 + a.z3 * b.y3,
+		a.x3 * b.z1 + a.y3 * b.z2 + a.z3 * b.z3
+	)
+end
+
+function rotMatrixMethods.set (self, other)
+	self.x1, self.y1, self.z1 = other.x1, other.y1, other.z1
+	self.x2, self.y2, self.z2 = other.x2, other.y2, other.z2
+	self.x3, self.y3, self.z3 = other.x3, other.y3, other.z3
+end
+
+function rotMatrixMethods.clone (self)
+	return RotMatrix(
+		self.x1, self.y1, self.z1,
+		self.x2, self.y2, self.z2,
+		self.x3, self.y3, self.z3
+	)
+end
+
+function rotMatrixMethods.getForward (self)
+	return Vector(self.x1, self.y1, self.z1)
+end
+
+function rotMatrixMethods.getUp (self)
+	return Vector(self.x2, self.y2, self.z2)
+end
+
+function rotMatrixMethods.getRight (self)
+	return Vector(self.x3, self.y3, self.z3)
+end
+
+ffi.metatype(Vector, vectorMeta)
+ffi.metatype(RotMatrix, rotMatrixMeta)
+
+ffi.Vector = Vector
+ffi.RotMatrix = RotMatrix
+
+-- Used by APIs taking a Vector* or RotMatrix* to find the address of a struct,
+-- a reference to one, or a pointer to one
+return function (value, typeName)
+	if ffi.istype(typeName, value) or ffi.istype(typeName .. '*', value) then
+		return tonumber(ffi.cast('uintptr_t', ffi.cast(typeName .. '*', value)))
+	end
+	return 0
+end
+)";
+
+static constexpr const char* pointerHelperKey = "RosaServer.ffiPointer";
+
+void defineTypes(sol::state* state) {
+	sol::table ffi = (*state)["ffi"];
+
+	sol::protected_function cdef = ffi["cdef"];
+	auto res = cdef(definitions);
+	if (!noLuaCallError(&res)) {
+		return;
+	}
+
+	// A field missing from either copy shows up as a size mismatch, in which
+	// case nothing else is defined rather than reading the wrong offsets
+	sol::protected_function sizeOf = ffi["sizeof"];
+	for (const auto& type : typeSizes) {
+		auto res = sizeOf(type.name);
+		if (!noLuaCallError(&res)) {
+			return;
+		}
+
+		size_t size = res.get<size_t>();
+		if (size != type.size) {
+			std::ostringstream stream;
+			stream << LUA_PREFIX "FFI definition of " << type.name << " is " << size
+			       << " bytes instead of " << type.size << "\n";
+			Console::log(stream.str());
+			return;
+		}
+	}
+
+	// Fields swapped or retyped without changing the size only show up here
+	sol::protected_function offsetOf = ffi["offsetof"];
+	for (const auto& field : fieldOffsets) {
+		auto res = offsetOf(field.type, field.field);
+		if (!noLuaCallError(&res)) {
+			return;
+		}
+
+		// nil if the definition has no such field
+		auto offset = res.get<sol::optional<size_t>>();
+		if (!offset || *offset != field.offset) {
+			std::ostringstream stream;
+			stream << LUA_PREFIX "FFI definition of " << field.type << "."
+			       << field.field << " is not at offset " << field.offset << "\n";
+			Console::log(stream.str());
+			return;
+		}
+	}
+
+	sol::load_result load = state->load(metatypes, "=ffi metatypes");
+	if (!noLuaCallError(&load)) {
+		return;
+	}
+
+	sol::protected_function_result helper = load();
+	if (!noLuaCallError(&helper)) {
+		return;
+	}
+
+	state->registry()[pointerHelperKey] = helper.get<sol::function>();
+}
+
+void exposeArrays(sol::state* state) {
+	if (state->registry()[pointerHelperKey] == sol::nil) {
+		return;
+	}
+
+	sol::table ffi = (*state)["ffi"];
+
+	const struct {
+		const char* name;
+		const char* type;
+		uintptr_t address;
+	} arrays[] = {
+	    {"connections", "Connection*",
+	     reinterpret_cast<uintptr_t>(Engine::connections)},
+	    {"accounts", "Account*", reinterpret_cast<uintptr_t>(Engine::accounts)},
+	    {"voices", "Voice*", reinterpret_cast<uintptr_t>(Engine::voices)},
+	    {"players", "Player*", reinterpret_cast<uintptr_t>(Engine::players)},
+	    {"humans", "Human*", reinterpret_cast<uintptr_t>(Engine::humans)},
+	    {"itemTypes", "ItemType*",
+	     reinterpret_cast<uintptr_t>(Engine::itemTypes)},
+	    {"items", "Item*", reinterpret_cast<uintptr_t>(Engine::items)},
+	    {"vehicleTypes", "VehicleType*",
+	     reinterpret_cast<uintptr_t>(Engine::vehicleTypes)},
+	    {"vehicles", "Vehicle*", reinterpret_cast<uintptr_t>(Engine::vehicles)},
+	    {"bullets", "Bullet*", reinterpret_cast<uintptr_t>(Engine::bullets)},
+	    {"bodies", "RigidBody*", reinterpret_cast<uintptr_t>(Engine::bodies)},
+	    {"bonds", "Bond*", reinterpret_cast<uintptr_t>(Engine::bonds)},
+	    {"streets", "Street*", reinterpret_cast<uintptr_t>(Engine::streets)},
+	    {"streetIntersections", "StreetIntersection*",
+	     reinterpret_cast<uintptr_t>(Engine::streetIntersections)},
+	    {"trafficCars", "TrafficCar*",
+	     reinterpret_cast<uintptr_t>(Engine::trafficCars)},
+	    {"buildings", "Building*",
+	     reinterpret_cast<uintptr_t>(Engine::buildings)},
+	    {"events", "Event*", reinterpret_cast<uintptr_t>(Engine::events)},
+	};
+
+	sol::protected_function cast = ffi["cast"];
+	for (const auto& array : arrays) {
+		auto res = cast(array.type, array.address);
+		if (!noLuaCallError(&res)) {
+			return;
+		}
+		ffi[array.name] = res.get<sol::object>();
+	}
+}
+
+void* toPointer(lua_State* L, int index, const char* type) {
+	if (index < 0 && index > LUA_REGISTRYINDEX) {
+		index = lua_gettop(L) + index + 1;
+	}
+
+	lua_getfield(L, LUA_REGISTRYINDEX, pointerHelperKey);
+	if (!lua_isfunction(L, -1)) {
+		lua_pop(L, 1);
+		return nullptr;
+	}
+
+	lua_pushvalue(L, index);
+	lua_pushstring(L, type);
+	if (lua_pcall(L, 2, 1, 0) != 0) {
+		lua_pop(L, 1);
+		return nullptr;
+	}
+
+	auto address = static_cast<uintptr_t>(lua_tonumber(L, -1));
+	lua_pop(L, 1);
+	return reinterpret_cast<void*>(address);
+}
+};  // namespace FFI
@@ -0,0 +1,15 @@
+#pragma once
+#include "sol/sol.hpp"
+
+namespace FFI {
+extern const char* const definitions;
+
+// Defines the engine structs for the FFI, with Vector and RotMatrix given the
+// same methods as their usertypes. ffi.Vector and ffi.RotMatrix construct
+// them.
+void defineTypes(sol::state* state);
+// Adds the entity arrays to the ffi module as typed pointers, e.g.
+// ffi.humans[0].pos.x. Moving humans, items or vehicles through these needs a
+// physics.markSpatialIndexStale() before the next spatial query.
+void exposeArrays(sol::state* state);
+};  // namespace FFI
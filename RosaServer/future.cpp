@@ -0,0 +1,29 @@
+#include "future.h"
+
+bool Future::isReady() const { return state->isReady; }
+
+sol::variadic_results Future::get() const {
+	if (!state->isReady) {
+		throw std::runtime_error("Future is not ready");
+	}
+	if (!state->success) {
+		throw std::runtime_error(state->values[0].as<std::string>());
+	}
+
+	sol::variadic_results results;
+	for (const auto& value : state->values) {
+		results.push_back(value);
+	}
+	return results;
+}
+
+void Future::resumeWhenReady(sol::object coroutine) {
+	if (coroutine.get_type() != sol::type::thread) {
+		throw std::invalid_argument("Expected a coroutine");
+	}
+	if (state->isReady) {
+		throw std::logic_error("Future is already ready");
+	}
+
+	state->waiting.push_back(coroutine);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "sol/sol.hpp"
+
+#include <memory>
+#include <vector>
+
+// Handle to the result of a job given to async.run. The result is filled in
+// by async::update once the job's worker returns it.
+class Future {
+ public:
+	struct State {
+		bool isReady = false;
+		bool success = false;
+		// What the job returned, or its error message
+		std::vector<sol::object> values;
+		// Coroutines to resume once the result is in
+		std::vector<sol::object> waiting;
+	};
+
+	std::shared_ptr<State> state = std::make_shared<State>();
+
+	const char* getClass() const { return "Future"; }
+	bool isReady() const;
+	sol::variadic_results get() const;
+	void resumeWhenReady(sol::object coroutine);
+};
@@ -1,9 +1,16 @@
 #include "hooks.h"
+#include "activeset.h"
 #include "api.h"
+#include "changefeed.h"
 #include "console.h"
+#include "ticktimer.h"
+#include "worldsnapshot.h"
+
+#include <algorithm>
 
 namespace Hooks {
 sol::protected_function run;
+bool useTrampolines = true;
 
 const std::unordered_map<std::string, EnableKeys> enableNames(
     {{"InterruptSignal", EnableKeys::InterruptSignal},
@@ -65,8 +72,61 @@ const std::unordered_map<std::string, EnableKeys> enableNames(
      {"EventSound", EnableKeys::EventSound},
      {"EventBullet", EnableKeys::EventBullet},
      {"EventBulletHit", EnableKeys::EventBulletHit},
-     {"LineIntersectHuman", EnableKeys::LineIntersectHuman}});
+     {"LineIntersectHuman", EnableKeys::LineIntersectHuman},
+     {"BulletMayHit", EnableKeys::BulletMayHit},
+     {"TickOverrun", EnableKeys::TickOverrun},
+     {"BulletCreateBatch", EnableKeys::BulletCreateBatch},
+     {"CollideBodiesBatch", EnableKeys::CollideBodiesBatch},
+     {"EventUpdateVehicleBatch", EnableKeys::EventUpdateVehicleBatch},
+     {"EventSoundBatch", EnableKeys::EventSoundBatch},
+     {"EventBulletBatch", EnableKeys::EventBulletBatch},
+     {"EventBulletHitBatch", EnableKeys::EventBulletHitBatch}});
 bool enabledKeys[EnableKeys::SIZE] = {0};
+std::shared_ptr<const std::vector<Handler>> handlers[2][EnableKeys::SIZE];
+Stats stats[2][EnableKeys::SIZE];
+
+static constexpr size_t batchReservedRows = 1024;
+
+static EventBatch bulletCreateBatch(
+    {"bullet", "type", "player", "posX", "posY", "posZ", "velX", "velY",
+     "velZ"},
+    batchReservedRows);
+static EventBatch collideBodiesBatch(
+    {"bodyA", "bodyB", "aLocalPosX", "aLocalPosY", "aLocalPosZ", "bLocalPosX",
+     "bLocalPosY", "bLocalPosZ", "normalX", "normalY", "normalZ", "a", "b", "c",
+     "d"},
+    batchReservedRows);
+static EventBatch eventUpdateVehicleBatch(
+    {"vehicle", "updateType", "partID", "posX", "posY", "posZ", "normalX",
+     "normalY", "normalZ"},
+    batchReservedRows);
+static EventBatch eventSoundBatch(
+    {"soundType", "posX", "posY", "posZ", "volume", "pitch"},
+    batchReservedRows);
+static EventBatch eventBulletBatch(
+    {"bulletType", "item", "posX", "posY", "posZ", "velX", "velY", "velZ"},
+    batchReservedRows);
+static EventBatch eventBulletHitBatch(
+    {"hitType", "posX", "posY", "posZ", "normalX", "normalY", "normalZ"},
+    batchReservedRows);
+
+static const struct {
+	EnableKeys key;
+	const char* name;
+	EventBatch* batch;
+} batches[] = {
+    {EnableKeys::BulletCreateBatch, "BulletCreateBatch", &bulletCreateBatch},
+    {EnableKeys::CollideBodiesBatch, "CollideBodiesBatch", &collideBodiesBatch},
+    {EnableKeys::EventUpdateVehicleBatch, "EventUpdateVehicleBatch",
+     &eventUpdateVehicleBatch},
+    {EnableKeys::EventSoundBatch, "EventSoundBatch", &eventSoundBatch},
+    {EnableKeys::EventBulletBatch, "EventBulletBatch", &eventBulletBatch},
+    {EnableKeys::EventBulletHitBatch, "EventBulletHitBatch",
+     &eventBulletHitBatch}};
+
+static inline Vector orZero(const Vector* vector) {
+	return vector ? *vector : Vector{};
+}
 
 subhook::Hook subRosaPutsHook;
 subhook::Hook subRosa__printf_chkHook;
@@ -128,6 +188,241 @@ subhook::Hook createEventBulletHitHook;
 subhook::Hook lineIntersectHumanHook;
 subhook::Hook lineIntersectLevelHook;
 
+// Detours which are only installed while one of their keys is enabled. Keys
+// without one share an always-installed detour, either because it keeps our
+// own state in sync with the engine (data tables, console input, resets),
+// because it times a phase of the tick, or because several keys are handled
+// in the same place.
+static subhook::Hook* getKeyedHook(EnableKeys key) {
+	switch (key) {
+		case EnableKeys::CreateTraffic:
+			return &createTrafficHook;
+		case EnableKeys::TrafficCarAI:
+			return &aiTrafficCarHook;
+		case EnableKeys::TrafficCarDestination:
+			return &aiTrafficCarDestinationHook;
+		case EnableKeys::AreaCreateBlock:
+			return &areaCreateBlockHook;
+		case EnableKeys::AreaDeleteBlock:
+			return &areaDeleteBlockHook;
+		case EnableKeys::PlayerActions:
+			return &logicPlayerActionsHook;
+		case EnableKeys::PacketBuilding:
+			return &packetWriteHook;
+		case EnableKeys::CalculateEarShots:
+			return &calculatePlayerVoiceHook;
+		case EnableKeys::SendPacket:
+			return &sendPacketHook;
+		case EnableKeys::EconomyCarMarket:
+			return &economyCarMarketHook;
+		case EnableKeys::AccountsSave:
+			return &saveAccountsServerHook;
+		case EnableKeys::AccountTicketBegin:
+		case EnableKeys::AccountTicketFound:
+		case EnableKeys::AccountTicket:
+			return &createAccountByJoinTicketHook;
+		case EnableKeys::SendConnectResponse:
+			return &serverSendConnectResponseHook;
+		case EnableKeys::ItemLink:
+			return &linkItemHook;
+		case EnableKeys::ItemComputerInput:
+			return &itemComputerInputHook;
+		case EnableKeys::HumanDamage:
+			return &humanApplyDamageHook;
+		case EnableKeys::HumanCollisionVehicle:
+			return &humanCollisionVehicleHook;
+		case EnableKeys::HumanLimbInverseKinematics:
+			return &humanLimbInverseKinematicsHook;
+		case EnableKeys::GrenadeExplode:
+			return &grenadeExplosionHook;
+		case EnableKeys::PlayerChat:
+			return &serverPlayerMessageHook;
+		case EnableKeys::PlayerAI:
+			return &playerAIHook;
+		case EnableKeys::PlayerDeathTax:
+			return &playerDeathTaxHook;
+		case EnableKeys::AccountDeathTax:
+			return &accountDeathTaxHook;
+		case EnableKeys::PlayerGiveWantedLevel:
+			return &playerGiveWantedLevelHook;
+		case EnableKeys::CollideBodies:
+		case EnableKeys::CollideBodiesBatch:
+			return &addCollisionRigidBodyOnRigidBodyHook;
+		case EnableKeys::BulletCreate:
+		case EnableKeys::BulletCreateBatch:
+			return &createBulletHook;
+		case EnableKeys::EventMessage:
+			return &createEventMessageHook;
+		case EnableKeys::EventUpdatePlayer:
+			return &createEventUpdatePlayerHook;
+		case EnableKeys::EventUpdateVehicle:
+		case EnableKeys::EventUpdateVehicleBatch:
+			return &createEventUpdateVehicleHook;
+		case EnableKeys::EventSound:
+		case EnableKeys::EventSoundBatch:
+			return &createEventSoundHook;
+		case EnableKeys::EventBullet:
+		case EnableKeys::EventBulletBatch:
+			return &createEventBulletHook;
+		case EnableKeys::EventBulletHit:
+		case EnableKeys::EventBulletHitBatch:
+			return &createEventBulletHitHook;
+		case EnableKeys::LineIntersectHuman:
+			return &lineIntersectHumanHook;
+		case EnableKeys::BulletMayHit:
+			return &lineIntersectLevelHook;
+		default:
+			return nullptr;
+	}
+}
+
+static void setInstalled(subhook::Hook* hook, bool installed) {
+	if (hook->IsInstalled() == installed) {
+		return;
+	}
+
+	if (installed ? !hook->Install() : !hook->Remove()) {
+		throw std::runtime_error(installed ? "Failed to install hook"
+		                                   : "Failed to remove hook");
+	}
+}
+
+static void updateKeyedHook(subhook::Hook* hook) {
+	bool anyEnabled = false;
+	for (int i = 0; i < EnableKeys::SIZE; i++) {
+		if (enabledKeys[i] && getKeyedHook(static_cast<EnableKeys>(i)) == hook) {
+			anyEnabled = true;
+			break;
+		}
+	}
+
+	setInstalled(hook, anyEnabled);
+}
+
+void setEnabled(EnableKeys key, bool enabled) {
+	enabledKeys[key] = enabled;
+
+	auto hook = getKeyedHook(key);
+	if (hook) {
+		updateKeyedHook(hook);
+	}
+}
+
+void removeDisabledHooks() {
+	for (int i = 0; i < EnableKeys::SIZE; i++) {
+		auto hook = getKeyedHook(static_cast<EnableKeys>(i));
+		if (hook) {
+			updateKeyedHook(hook);
+		}
+	}
+}
+
+void addHandler(EnableKeys key, Phase phase, sol::protected_function function,
+                int priority) {
+	auto& slot = handlers[phase][key];
+	auto list = slot ? std::make_shared<std::vector<Handler>>(*slot)
+	                 : std::make_shared<std::vector<Handler>>();
+
+	// Equal priorities keep the order they were added in
+	auto position = std::upper_bound(
+	    list->begin(), list->end(), priority,
+	    [](int value, const Handler& handler) {
+		    return value < handler.priority;
+	    });
+	list->insert(position, {std::move(function), priority});
+
+	slot = std::move(list);
+}
+
+bool removeHandler(EnableKeys key, Phase phase,
+                   const sol::protected_function& function) {
+	auto& slot = handlers[phase][key];
+	if (!slot) {
+		return false;
+	}
+
+	auto list = std::make_shared<std::vector<Handler>>(*slot);
+	auto position =
+	    std::find_if(list->begin(), list->end(), [&](const Handler& handler) {
+		    return handler.function == function;
+	    });
+	if (position == list->end()) {
+		return false;
+	}
+	list->erase(position);
+
+	if (list->empty()) {
+		slot = nullptr;
+	} else {
+		slot = std::move(list);
+	}
+	return true;
+}
+
+void clearHandlers() {
+	for (auto& phase : handlers) {
+		for (auto& slot : phase) {
+			slot = nullptr;
+		}
+	}
+}
+
+sol::table EventBatch::flush() {
+	size_t numColumns = columns.size();
+	size_t numRows = size();
+
+	sol::table table = lua->create_table(0, numColumns + 1);
+	table["count"] = numRows;
+
+	for (size_t column = 0; column < numColumns; column++) {
+		sol::table values = lua->create_table(numRows, 0);
+		for (size_t row = 0; row < numRows; row++) {
+			values.raw_set(row + 1, this->values[row * numColumns + column]);
+		}
+		table[columns[column]] = values;
+	}
+
+	clear();
+	return table;
+}
+
+void flushBatches() {
+	for (auto& entry : batches) {
+		if (!entry.batch->size()) {
+			continue;
+		}
+
+		if (enabledKeys[entry.key]) {
+			dispatch(entry.key, Pre, entry.name, entry.batch->flush());
+		} else {
+			entry.batch->clear();
+		}
+	}
+}
+
+void recordCall(EnableKeys key, Phase phase, std::chrono::nanoseconds time) {
+	auto& entry = stats[phase][key];
+	unsigned long long nanoseconds = time.count();
+
+	entry.calls++;
+	entry.totalNanoseconds += nanoseconds;
+	if (nanoseconds > entry.maxNanoseconds) {
+		entry.maxNanoseconds = nanoseconds;
+	}
+
+	unsigned long long microseconds = nanoseconds / 1000;
+	int bucket = microseconds == 0 ? 0 : 64 - __builtin_clzll(microseconds);
+	entry.histogram[std::min(bucket, statsHistogramSize - 1)]++;
+}
+
+void resetStats() {
+	for (auto& phase : stats) {
+		for (auto& entry : phase) {
+			entry = {};
+		}
+	}
+}
+
 int subRosaPuts(const char* str) {
 	std::ostringstream stream;
 
@@ -178,168 +473,117 @@ void resetGame() {
 
 void createTraffic(int amount) {
 	if (enabledKeys[EnableKeys::CreateTraffic]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			Integer wrappedAmount = {amount};
-
-			auto res = run("CreateTraffic", wrappedAmount);
+		Integer wrappedAmount = {amount};
 
-			if (noLuaCallError(&res)) noParent = (bool)res;
+		bool noParent = dispatch(EnableKeys::CreateTraffic, Pre, "CreateTraffic",
+		                         wrappedAmount);
 
-			amount = wrappedAmount.value;
-		}
+		amount = wrappedAmount.value;
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&createTrafficHook);
-				Engine::createTraffic(amount);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostCreateTraffic", amount);
-				noLuaCallError(&res);
-			}
+			callOriginal(createTrafficHook, Engine::createTraffic, amount);
+			dispatch(EnableKeys::CreateTraffic, Post, "PostCreateTraffic", amount);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&createTrafficHook);
-		Engine::createTraffic(amount);
+		callOriginal(createTrafficHook, Engine::createTraffic, amount);
 	}
 }
 
 void trafficSimulation() {
+	TickTimer::ScopedSection timer(TickTimer::Traffic);
 	if (enabledKeys[EnableKeys::TrafficSimulation]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("TrafficSimulation");
-
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::TrafficSimulation, Pre,
+		                         "TrafficSimulation");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&trafficSimulationHook);
-				Engine::trafficSimulation();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostTrafficSimulation");
-				noLuaCallError(&res);
-			}
+			callOriginal(trafficSimulationHook, Engine::trafficSimulation);
+			dispatch(EnableKeys::TrafficSimulation, Post, "PostTrafficSimulation");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&trafficSimulationHook);
-		Engine::trafficSimulation();
+		callOriginal(trafficSimulationHook, Engine::trafficSimulation);
 	}
 }
 
 void aiTrafficCar(int id) {
 	if (enabledKeys[EnableKeys::TrafficCarAI]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("TrafficCarAI", &Engine::trafficCars[id]);
-
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::TrafficCarAI, Pre, "TrafficCarAI",
+		                         &Engine::trafficCars[id]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&aiTrafficCarHook);
-				Engine::aiTrafficCar(id);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostTrafficCarAI", &Engine::trafficCars[id]);
-				noLuaCallError(&res);
-			}
+			callOriginal(aiTrafficCarHook, Engine::aiTrafficCar, id);
+			dispatch(EnableKeys::TrafficCarAI, Post, "PostTrafficCarAI",
+			         &Engine::trafficCars[id]);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&aiTrafficCarHook);
-		Engine::aiTrafficCar(id);
+		callOriginal(aiTrafficCarHook, Engine::aiTrafficCar, id);
 	}
 }
 
 void aiTrafficCarDestination(int id, int a, int b, int c, int d) {
 	if (enabledKeys[EnableKeys::TrafficCarDestination]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			Integer wrappedA = {a};
-			Integer wrappedB = {b};
-			Integer wrappedC = {c};
-			Integer wrappedD = {d};
-
-			auto res = run("TrafficCarDestination", &Engine::trafficCars[id],
-			               wrappedA, wrappedB, wrappedC, wrappedD);
-
-			if (noLuaCallError(&res)) noParent = (bool)res;
-
-			a = wrappedA.value;
-			b = wrappedB.value;
-			c = wrappedC.value;
-			d = wrappedD.value;
-		}
+		Integer wrappedA = {a};
+		Integer wrappedB = {b};
+		Integer wrappedC = {c};
+		Integer wrappedD = {d};
+
+		bool noParent = dispatch(EnableKeys::TrafficCarDestination, Pre,
+		                         "TrafficCarDestination", &Engine::trafficCars[id],
+		                         wrappedA, wrappedB, wrappedC, wrappedD);
+
+		a = wrappedA.value;
+		b = wrappedB.value;
+		c = wrappedC.value;
+		d = wrappedD.value;
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&aiTrafficCarDestinationHook);
-				Engine::aiTrafficCarDestination(id, a, b, c, d);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostTrafficCarDestination", &Engine::trafficCars[id], a,
-				               b, c, d);
-				noLuaCallError(&res);
-			}
+			callOriginal(aiTrafficCarDestinationHook, Engine::aiTrafficCarDestination,
+			             id, a, b, c, d);
+			dispatch(EnableKeys::TrafficCarDestination, Post,
+			         "PostTrafficCarDestination", &Engine::trafficCars[id], a, b, c,
+			         d);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&aiTrafficCarDestinationHook);
-		Engine::aiTrafficCarDestination(id, a, b, c, d);
+		callOriginal(aiTrafficCarDestinationHook, Engine::aiTrafficCarDestination,
+		             id, a, b, c, d);
 	}
 }
 
 void areaCreateBlock(int zero, int blockX, int blockY, int blockZ,
                      unsigned int flags, short unk[8]) {
 	if (enabledKeys[EnableKeys::AreaCreateBlock]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			UnsignedInteger wrappedFlags = {flags};
+		UnsignedInteger wrappedFlags = {flags};
 
-			auto res = run("AreaCreateBlock", blockX, blockY, blockZ, &wrappedFlags);
-			if (noLuaCallError(&res)) noParent = (bool)res;
+		bool noParent = dispatch(EnableKeys::AreaCreateBlock, Pre,
+		                         "AreaCreateBlock", blockX, blockY, blockZ,
+		                         &wrappedFlags);
 
-			flags = wrappedFlags.value;
-		}
+		flags = wrappedFlags.value;
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&areaCreateBlockHook);
-				Engine::areaCreateBlock(zero, blockX, blockY, blockZ, flags, unk);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostAreaCreateBlock", blockX, blockY, blockZ, flags);
-				noLuaCallError(&res);
-			}
+			callOriginal(areaCreateBlockHook, Engine::areaCreateBlock, zero, blockX,
+			             blockY, blockZ, flags, unk);
+			dispatch(EnableKeys::AreaCreateBlock, Post, "PostAreaCreateBlock", blockX,
+			         blockY, blockZ, flags);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&areaCreateBlockHook);
-		Engine::areaCreateBlock(zero, blockX, blockY, blockZ, flags, unk);
+		callOriginal(areaCreateBlockHook, Engine::areaCreateBlock, zero, blockX,
+		             blockY, blockZ, flags, unk);
 	}
 }
 
 void areaDeleteBlock(int zero, int blockX, int blockY, int blockZ) {
 	if (enabledKeys[EnableKeys::AreaDeleteBlock]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("AreaDeleteBlock", blockX, blockY, blockZ);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::AreaDeleteBlock, Pre,
+		                         "AreaDeleteBlock", blockX, blockY, blockZ);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&areaDeleteBlockHook);
-				Engine::areaDeleteBlock(zero, blockX, blockY, blockZ);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostAreaDeleteBlock", blockX, blockY, blockZ);
-				noLuaCallError(&res);
-			}
+			callOriginal(areaDeleteBlockHook, Engine::areaDeleteBlock, zero, blockX,
+			             blockY, blockZ);
+			dispatch(EnableKeys::AreaDeleteBlock, Post, "PostAreaDeleteBlock", blockX,
+			         blockY, blockZ);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&areaDeleteBlockHook);
-		Engine::areaDeleteBlock(zero, blockX, blockY, blockZ);
+		callOriginal(areaDeleteBlockHook, Engine::areaDeleteBlock, zero, blockX,
+		             blockY, blockZ);
 	}
 }
 
 void logicSimulation() {
+	TickTimer::ScopedSection timer(TickTimer::Logic);
 	if (shouldReset) {
 		shouldReset = false;
 		luaInit(true);
@@ -350,52 +594,45 @@ void logicSimulation() {
 	bool noParent = false;
 
 	if (Console::shouldExit) {
-		if (enabledKeys[EnableKeys::InterruptSignal] && run != sol::nil) {
-			auto res = run("InterruptSignal");
-			noLuaCallError(&res);
+		if (enabledKeys[EnableKeys::InterruptSignal]) {
+			dispatch(EnableKeys::InterruptSignal, Pre, "InterruptSignal");
 		}
 		Lua::os::exit();
 		return;
 	}
 
 	if (enabledKeys[EnableKeys::Logic]) {
-		if (run != sol::nil) {
-			auto res = run("Logic");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		noParent = dispatch(EnableKeys::Logic, Pre, "Logic");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&logicSimulationHook);
-				Engine::logicSimulation();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostLogic");
-				noLuaCallError(&res);
-			}
+			callOriginal(logicSimulationHook, Engine::logicSimulation);
+			dispatch(EnableKeys::Logic, Post, "PostLogic");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&logicSimulationHook);
-		Engine::logicSimulation();
+		callOriginal(logicSimulationHook, Engine::logicSimulation);
 	}
 
+	Lua::async::update();
+	WorldSnapshot::publish();
+
 	{
 		std::lock_guard<std::mutex> guard(Console::commandQueueMutex);
 		while (!Console::commandQueue.empty()) {
-			if (enabledKeys[EnableKeys::ConsoleInput] && run != sol::nil) {
-				auto res = run("ConsoleInput", Console::commandQueue.front());
-				noLuaCallError(&res);
+			if (enabledKeys[EnableKeys::ConsoleInput]) {
+				dispatch(EnableKeys::ConsoleInput, Pre, "ConsoleInput",
+				         Console::commandQueue.front());
 			}
 			Console::commandQueue.pop();
 		}
 	}
 
 	if (Console::isAwaitingAutoComplete()) {
-		if (enabledKeys[EnableKeys::ConsoleAutoComplete] && run != sol::nil) {
+		if (enabledKeys[EnableKeys::ConsoleAutoComplete] &&
+		    hasListeners(EnableKeys::ConsoleAutoComplete, Pre)) {
 			auto data = lua->create_table();
 			data["response"] = Console::getAutoCompleteInput();
 
-			auto res = run("ConsoleAutoComplete", data);
-			noLuaCallError(&res);
+			dispatch(EnableKeys::ConsoleAutoComplete, Pre, "ConsoleAutoComplete",
+			         data);
 
 			std::string response = data["response"];
 			Console::respondToAutoComplete(response);
@@ -406,258 +643,168 @@ void logicSimulation() {
 }
 
 void logicSimulationRace() {
+	TickTimer::ScopedSection timer(TickTimer::Gamemode);
 	if (enabledKeys[EnableKeys::LogicRace]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("LogicRace");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::LogicRace, Pre, "LogicRace");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&logicSimulationRaceHook);
-				Engine::logicSimulationRace();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostLogicRace");
-				noLuaCallError(&res);
-			}
+			callOriginal(logicSimulationRaceHook, Engine::logicSimulationRace);
+			dispatch(EnableKeys::LogicRace, Post, "PostLogicRace");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&logicSimulationRaceHook);
-		Engine::logicSimulationRace();
+		callOriginal(logicSimulationRaceHook, Engine::logicSimulationRace);
 	}
 }
 
 void logicSimulationRound() {
+	TickTimer::ScopedSection timer(TickTimer::Gamemode);
 	if (enabledKeys[EnableKeys::LogicRound]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("LogicRound");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::LogicRound, Pre, "LogicRound");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&logicSimulationRoundHook);
-				Engine::logicSimulationRound();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostLogicRound");
-				noLuaCallError(&res);
-			}
+			callOriginal(logicSimulationRoundHook, Engine::logicSimulationRound);
+			dispatch(EnableKeys::LogicRound, Post, "PostLogicRound");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&logicSimulationRoundHook);
-		Engine::logicSimulationRound();
+		callOriginal(logicSimulationRoundHook, Engine::logicSimulationRound);
 	}
 }
 
 void logicSimulationWorld() {
+	TickTimer::ScopedSection timer(TickTimer::Gamemode);
 	if (enabledKeys[EnableKeys::LogicWorld]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("LogicWorld");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::LogicWorld, Pre, "LogicWorld");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&logicSimulationWorldHook);
-				Engine::logicSimulationWorld();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostLogicWorld");
-				noLuaCallError(&res);
-			}
+			callOriginal(logicSimulationWorldHook, Engine::logicSimulationWorld);
+			dispatch(EnableKeys::LogicWorld, Post, "PostLogicWorld");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&logicSimulationWorldHook);
-		Engine::logicSimulationWorld();
+		callOriginal(logicSimulationWorldHook, Engine::logicSimulationWorld);
 	}
 }
 
 void logicSimulationTerminator() {
+	TickTimer::ScopedSection timer(TickTimer::Gamemode);
 	if (enabledKeys[EnableKeys::LogicTerminator]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("LogicTerminator");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::LogicTerminator, Pre,
+		                         "LogicTerminator");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&logicSimulationTerminatorHook);
-				Engine::logicSimulationTerminator();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostLogicTerminator");
-				noLuaCallError(&res);
-			}
+			callOriginal(logicSimulationTerminatorHook,
+			             Engine::logicSimulationTerminator);
+			dispatch(EnableKeys::LogicTerminator, Post, "PostLogicTerminator");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&logicSimulationTerminatorHook);
-		Engine::logicSimulationTerminator();
+		callOriginal(logicSimulationTerminatorHook,
+		             Engine::logicSimulationTerminator);
 	}
 }
 
 void logicSimulationCoop() {
+	TickTimer::ScopedSection timer(TickTimer::Gamemode);
 	if (enabledKeys[EnableKeys::LogicCoop]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("LogicCoop");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::LogicCoop, Pre, "LogicCoop");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&logicSimulationCoopHook);
-				Engine::logicSimulationCoop();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostLogicCoop");
-				noLuaCallError(&res);
-			}
+			callOriginal(logicSimulationCoopHook, Engine::logicSimulationCoop);
+			dispatch(EnableKeys::LogicCoop, Post, "PostLogicCoop");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&logicSimulationCoopHook);
-		Engine::logicSimulationCoop();
+		callOriginal(logicSimulationCoopHook, Engine::logicSimulationCoop);
 	}
 }
 
 void logicSimulationVersus() {
+	TickTimer::ScopedSection timer(TickTimer::Gamemode);
 	if (enabledKeys[EnableKeys::LogicVersus]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("LogicVersus");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::LogicVersus, Pre, "LogicVersus");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&logicSimulationVersusHook);
-				Engine::logicSimulationVersus();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostLogicVersus");
-				noLuaCallError(&res);
-			}
+			callOriginal(logicSimulationVersusHook, Engine::logicSimulationVersus);
+			dispatch(EnableKeys::LogicVersus, Post, "PostLogicVersus");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&logicSimulationVersusHook);
-		Engine::logicSimulationVersus();
+		callOriginal(logicSimulationVersusHook, Engine::logicSimulationVersus);
 	}
 }
 
 void logicPlayerActions(int playerID) {
 	if (enabledKeys[EnableKeys::PlayerActions]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("PlayerActions", &Engine::players[playerID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::PlayerActions, Pre, "PlayerActions",
+		                         &Engine::players[playerID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&logicPlayerActionsHook);
-				Engine::logicPlayerActions(playerID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostPlayerActions", &Engine::players[playerID]);
-				noLuaCallError(&res);
-			}
+			callOriginal(logicPlayerActionsHook, Engine::logicPlayerActions,
+			             playerID);
+			dispatch(EnableKeys::PlayerActions, Post, "PostPlayerActions",
+			         &Engine::players[playerID]);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&logicPlayerActionsHook);
-		Engine::logicPlayerActions(playerID);
+		callOriginal(logicPlayerActionsHook, Engine::logicPlayerActions, playerID);
 	}
 }
 
 void physicsSimulation() {
+	TickTimer::ScopedSection timer(TickTimer::Physics);
 	if (enabledKeys[EnableKeys::Physics]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("Physics");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::Physics, Pre, "Physics");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&physicsSimulationHook);
-				Engine::physicsSimulation();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostPhysics");
-				noLuaCallError(&res);
-			}
+			callOriginal(physicsSimulationHook, Engine::physicsSimulation);
+			Lua::physics::markSpatialIndexStale();
+			dispatch(EnableKeys::Physics, Post, "PostPhysics");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&physicsSimulationHook);
-		Engine::physicsSimulation();
+		callOriginal(physicsSimulationHook, Engine::physicsSimulation);
+		Lua::physics::markSpatialIndexStale();
 	}
 }
 
 void rigidBodySimulation() {
+	TickTimer::ScopedSection timer(TickTimer::RigidBodies);
 	if (enabledKeys[EnableKeys::PhysicsRigidBodies]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("PhysicsRigidBodies");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::PhysicsRigidBodies, Pre,
+		                         "PhysicsRigidBodies");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&rigidBodySimulationHook);
-				Engine::rigidBodySimulation();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostPhysicsRigidBodies");
-				noLuaCallError(&res);
-			}
+			callOriginal(rigidBodySimulationHook, Engine::rigidBodySimulation);
+			dispatch(EnableKeys::PhysicsRigidBodies, Post, "PostPhysicsRigidBodies");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&rigidBodySimulationHook);
-		Engine::rigidBodySimulation();
+		callOriginal(rigidBodySimulationHook, Engine::rigidBodySimulation);
 	}
 }
 
 int serverReceive() {
+	TickTimer::ScopedSection timer(TickTimer::ServerReceive);
 	if (enabledKeys[EnableKeys::ServerReceive]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("ServerReceive");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::ServerReceive, Pre, "ServerReceive");
 		if (!noParent) {
-			int ret;
-			{
-				subhook::ScopedHookRemove remove(&serverReceiveHook);
-				ret = Engine::serverReceive();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostServerReceive");
-				noLuaCallError(&res);
-			}
+			int ret = callOriginal(serverReceiveHook, Engine::serverReceive);
+			dispatch(EnableKeys::ServerReceive, Post, "PostServerReceive");
 			return ret;
 		}
 		return -1;
 	} else {
-		subhook::ScopedHookRemove remove(&serverReceiveHook);
-		return Engine::serverReceive();
+		return callOriginal(serverReceiveHook, Engine::serverReceive);
 	}
 }
 
 void serverSend() {
-	if (enabledKeys[EnableKeys::ServerSend]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("ServerSend");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
-		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&serverSendHook);
-				Engine::serverSend();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostServerSend");
-				noLuaCallError(&res);
+	flushBatches();
+	ActiveSets::rebuild();
+	ChangeFeed::update();
+
+	{
+		TickTimer::ScopedSection timer(TickTimer::ServerSend);
+		if (enabledKeys[EnableKeys::ServerSend]) {
+			bool noParent = dispatch(EnableKeys::ServerSend, Pre, "ServerSend");
+			if (!noParent) {
+				callOriginal(serverSendHook, Engine::serverSend);
+				dispatch(EnableKeys::ServerSend, Post, "PostServerSend");
 			}
+		} else {
+			callOriginal(serverSendHook, Engine::serverSend);
 		}
-	} else {
-		subhook::ScopedHookRemove remove(&serverSendHook);
-		Engine::serverSend();
+	}
+
+	// Sending is the last thing the engine does in a tick
+	float tickTime = TickTimer::endTick();
+	if (tickTime > TickTimer::budgetMicroseconds &&
+	    enabledKeys[EnableKeys::TickOverrun]) {
+		dispatch(EnableKeys::TickOverrun, Pre, "TickOverrun", tickTime);
 	}
 }
 
@@ -670,143 +817,89 @@ int packetWrite(void* source, int elementSize, int elementCount) {
 		Connection* connection =
 		    reinterpret_cast<Connection*>(connectionPlus4c - 0x4c);
 
-		if (run != sol::nil) {
-			auto res = run("PacketBuilding", connection);
-			noLuaCallError(&res);
-		}
+		dispatch(EnableKeys::PacketBuilding, Pre, "PacketBuilding", connection);
 	}
 
-	subhook::ScopedHookRemove remove(&packetWriteHook);
-	return Engine::packetWrite(source, elementSize, elementCount);
+	return callOriginal(packetWriteHook, Engine::packetWrite, source, elementSize,
+	                    elementCount);
 }
 
 void calculatePlayerVoice(int connectionID, int playerID) {
 	if (enabledKeys[EnableKeys::CalculateEarShots]) {
-		bool noParent = false;
-
 		auto connection = &Engine::connections[connectionID];
 		auto player = &Engine::players[playerID];
 
-		if (run != sol::nil) {
-			auto res = run("CalculateEarShots", connection, player);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::CalculateEarShots, Pre,
+		                         "CalculateEarShots", connection, player);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&calculatePlayerVoiceHook);
-				Engine::calculatePlayerVoice(connectionID, playerID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostCalculateEarShots", connection, player);
-				noLuaCallError(&res);
-			}
+			callOriginal(calculatePlayerVoiceHook, Engine::calculatePlayerVoice,
+			             connectionID, playerID);
+			dispatch(EnableKeys::CalculateEarShots, Post, "PostCalculateEarShots",
+			         connection, player);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&calculatePlayerVoiceHook);
-		Engine::calculatePlayerVoice(connectionID, playerID);
+		callOriginal(calculatePlayerVoiceHook, Engine::calculatePlayerVoice,
+		             connectionID, playerID);
 	}
 }
 
 int sendPacket(unsigned int address, unsigned short port) {
 	if (enabledKeys[EnableKeys::SendPacket]) {
-		bool noParent = false;
-
 		auto addressString = addressFromInteger(address);
 		int packetType = Engine::packet[4];
 		int packetSize = *Engine::packetSize;
 
-		if (run != sol::nil) {
-			auto res = run("SendPacket", addressString, port, packetType, packetSize);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::SendPacket, Pre, "SendPacket",
+		                         addressString, port, packetType, packetSize);
 		if (!noParent) {
-			int ret;
-			{
-				subhook::ScopedHookRemove remove(&sendPacketHook);
-				ret = Engine::sendPacket(address, port);
-			}
-			if (run != sol::nil) {
-				auto res =
-				    run("PostSendPacket", addressString, port, packetType, packetSize);
-				noLuaCallError(&res);
-			}
+			int ret = callOriginal(sendPacketHook, Engine::sendPacket, address, port);
+			dispatch(EnableKeys::SendPacket, Post, "PostSendPacket", addressString,
+			         port, packetType, packetSize);
 			return ret;
 		}
 		return 0;
 	} else {
-		subhook::ScopedHookRemove remove(&sendPacketHook);
-		return Engine::sendPacket(address, port);
+		return callOriginal(sendPacketHook, Engine::sendPacket, address, port);
 	}
 }
 
 void bulletSimulation() {
+	TickTimer::ScopedSection timer(TickTimer::Bullets);
 	isInBulletSimulation = true;
 	if (enabledKeys[EnableKeys::PhysicsBullets]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("PhysicsBullets");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::PhysicsBullets, Pre, "PhysicsBullets");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&bulletSimulationHook);
-				Engine::bulletSimulation();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostPhysicsBullets");
-				noLuaCallError(&res);
-			}
+			callOriginal(bulletSimulationHook, Engine::bulletSimulation);
+			dispatch(EnableKeys::PhysicsBullets, Post, "PostPhysicsBullets");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&bulletSimulationHook);
-		Engine::bulletSimulation();
+		callOriginal(bulletSimulationHook, Engine::bulletSimulation);
 	}
 	isInBulletSimulation = false;
 }
 
 void economyCarMarket() {
 	if (enabledKeys[EnableKeys::EconomyCarMarket]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("EconomyCarMarket");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::EconomyCarMarket, Pre,
+		                         "EconomyCarMarket");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&economyCarMarketHook);
-				Engine::economyCarMarket();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostEconomyCarMarket");
-				noLuaCallError(&res);
-			}
+			callOriginal(economyCarMarketHook, Engine::economyCarMarket);
+			dispatch(EnableKeys::EconomyCarMarket, Post, "PostEconomyCarMarket");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&economyCarMarketHook);
-		Engine::economyCarMarket();
+		callOriginal(economyCarMarketHook, Engine::economyCarMarket);
 	}
 }
 
 void saveAccountsServer() {
 	if (enabledKeys[EnableKeys::AccountsSave]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("AccountsSave");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::AccountsSave, Pre, "AccountsSave");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&saveAccountsServerHook);
-				Engine::saveAccountsServer();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostAccountsSave");
-				noLuaCallError(&res);
-			}
+			callOriginal(saveAccountsServerHook, Engine::saveAccountsServer);
+			dispatch(EnableKeys::AccountsSave, Post, "PostAccountsSave");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&saveAccountsServerHook);
-		Engine::saveAccountsServer();
+		callOriginal(saveAccountsServerHook, Engine::saveAccountsServer);
 	}
 }
 
@@ -814,500 +907,373 @@ int createAccountByJoinTicket(int identifier, unsigned int ticket) {
 	if (enabledKeys[EnableKeys::AccountTicketBegin] ||
 	    enabledKeys[EnableKeys::AccountTicketFound] ||
 	    enabledKeys[EnableKeys::AccountTicket]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("AccountTicketBegin", identifier, ticket);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::AccountTicketBegin, Pre,
+		                         "AccountTicketBegin", identifier, ticket);
 		if (!noParent) {
-			int id;
-			{
-				subhook::ScopedHookRemove remove(&createAccountByJoinTicketHook);
-				id = Engine::createAccountByJoinTicket(identifier, ticket);
-			}
-			if (run != sol::nil) {
-				auto res =
-				    run("AccountTicketFound", id < 0 ? nullptr : &Engine::accounts[id]);
-				noParent = false;
-				if (noLuaCallError(&res)) noParent = (bool)res;
-
-				if (!noParent) {
-					auto res = run("PostAccountTicket",
-					               id < 0 ? nullptr : &Engine::accounts[id]);
-					noLuaCallError(&res);
-					return id;
-				}
-				return -1;
+			int id = callOriginal(createAccountByJoinTicketHook,
+			                      Engine::createAccountByJoinTicket, identifier,
+			                      ticket);
+			Account* account = id < 0 ? nullptr : &Engine::accounts[id];
+
+			noParent = dispatch(EnableKeys::AccountTicketFound, Pre,
+			                    "AccountTicketFound", account);
+			if (!noParent) {
+				dispatch(EnableKeys::AccountTicket, Post, "PostAccountTicket",
+				         account);
+				return id;
 			}
-			return id;
+			return -1;
 		}
 		return -1;
 	} else {
-		subhook::ScopedHookRemove remove(&createAccountByJoinTicketHook);
-		return Engine::createAccountByJoinTicket(identifier, ticket);
+		return callOriginal(createAccountByJoinTicketHook,
+		                    Engine::createAccountByJoinTicket, identifier, ticket);
 	}
 }
 
 void serverSendConnectResponse(unsigned int address, unsigned int port, int unk,
                                const char* message) {
 	if (enabledKeys[EnableKeys::SendConnectResponse]) {
-		bool noParent = false;
-
 		auto addressString = addressFromInteger(address);
 
 		auto data = lua->create_table();
 		data["message"] = message;
 		std::string newMessage;
 
-		if (run != sol::nil) {
-			auto res = run("SendConnectResponse", addressString, port, data);
-			if (noLuaCallError(&res)) {
-				noParent = (bool)res;
-				newMessage = data["message"];
-				message = newMessage.c_str();
-			}
-		}
+		bool noParent = dispatch(EnableKeys::SendConnectResponse, Pre,
+		                         "SendConnectResponse", addressString, port, data);
+		newMessage = data["message"];
+		message = newMessage.c_str();
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&serverSendConnectResponseHook);
-				Engine::serverSendConnectResponse(address, port, unk, message);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostSendConnectResponse", addressString, port, data);
-				noLuaCallError(&res);
-			}
+			callOriginal(serverSendConnectResponseHook,
+			             Engine::serverSendConnectResponse, address, port, unk,
+			             message);
+			dispatch(EnableKeys::SendConnectResponse, Post, "PostSendConnectResponse",
+			         addressString, port, data);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&serverSendConnectResponseHook);
-		Engine::serverSendConnectResponse(address, port, unk, message);
+		callOriginal(serverSendConnectResponseHook,
+		             Engine::serverSendConnectResponse, address, port, unk,
+		             message);
+	}
+}
+
+static inline void batchBulletCreate(int id, int type, Vector* pos,
+                                     Vector* vel, int playerID) {
+	if (id != -1 && enabledKeys[EnableKeys::BulletCreateBatch]) {
+		auto p = orZero(pos);
+		auto v = orZero(vel);
+		bulletCreateBatch.add({(double)id, (double)type, (double)playerID, p.x, p.y,
+		                       p.z, v.x, v.y, v.z});
 	}
 }
 
 int createBullet(int type, Vector* pos, Vector* vel, int playerID) {
 	if (enabledKeys[EnableKeys::BulletCreate]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res =
-			    run("BulletCreate", type, pos, vel, &Engine::players[playerID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::BulletCreate, Pre, "BulletCreate",
+		                         type, pos, vel, &Engine::players[playerID]);
 		if (!noParent) {
-			int id;
-			{
-				subhook::ScopedHookRemove remove(&createBulletHook);
-				id = Engine::createBullet(type, pos, vel, playerID);
-			}
-			if (run != sol::nil && id != -1) {
-				auto res = run("PostBulletCreate", &Engine::bullets[id]);
-				noLuaCallError(&res);
+			int id = callOriginal(createBulletHook, Engine::createBullet, type, pos,
+			                      vel, playerID);
+			if (id != -1) {
+				dispatch(EnableKeys::BulletCreate, Post, "PostBulletCreate",
+				         &Engine::bullets[id]);
 			}
+			batchBulletCreate(id, type, pos, vel, playerID);
 			return id;
 		}
 		return -1;
 	} else {
-		subhook::ScopedHookRemove remove(&createBulletHook);
-		return Engine::createBullet(type, pos, vel, playerID);
+		int id = callOriginal(createBulletHook, Engine::createBullet, type, pos,
+		                      vel, playerID);
+		batchBulletCreate(id, type, pos, vel, playerID);
+		return id;
 	}
 }
 
 int createPlayer() {
 	if (enabledKeys[EnableKeys::PlayerCreate]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("PlayerCreate");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::PlayerCreate, Pre, "PlayerCreate");
 		if (!noParent) {
-			int id;
-			{
-				subhook::ScopedHookRemove remove(&createPlayerHook);
-				id = Engine::createPlayer();
-
-				if (id != -1 && playerDataTables[id]) {
-					delete playerDataTables[id];
-					playerDataTables[id] = nullptr;
-				}
-			}
-			if (run != sol::nil && id != -1) {
-				auto res = run("PostPlayerCreate", &Engine::players[id]);
-				noLuaCallError(&res);
+			int id = callOriginal(createPlayerHook, Engine::createPlayer);
+			if (id != -1) {
+				ActiveSets::players.insert(id);
+				playerDataTables.clear(id);
+				ChangeFeed::forget(ChangeFeed::Players, id);
+
+				dispatch(EnableKeys::PlayerCreate, Post, "PostPlayerCreate",
+				         &Engine::players[id]);
 			}
 			return id;
 		}
 		return -1;
 	} else {
-		subhook::ScopedHookRemove remove(&createPlayerHook);
-		int id = Engine::createPlayer();
-
-		if (id != -1 && playerDataTables[id]) {
-			delete playerDataTables[id];
-			playerDataTables[id] = nullptr;
+		int id = callOriginal(createPlayerHook, Engine::createPlayer);
+		if (id != -1) {
+			ActiveSets::players.insert(id);
+			playerDataTables.clear(id);
+			ChangeFeed::forget(ChangeFeed::Players, id);
 		}
-
 		return id;
 	}
 }
 
 void deletePlayer(int playerID) {
 	if (enabledKeys[EnableKeys::PlayerDelete]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("PlayerDelete", &Engine::players[playerID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::PlayerDelete, Pre, "PlayerDelete",
+		                         &Engine::players[playerID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&deletePlayerHook);
-				Engine::deletePlayer(playerID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostPlayerDelete", &Engine::players[playerID]);
-				noLuaCallError(&res);
-			}
-			if (playerDataTables[playerID]) {
-				delete playerDataTables[playerID];
-				playerDataTables[playerID] = nullptr;
-			}
+			callOriginal(deletePlayerHook, Engine::deletePlayer, playerID);
+			ActiveSets::players.erase(playerID);
+			dispatch(EnableKeys::PlayerDelete, Post, "PostPlayerDelete",
+			         &Engine::players[playerID]);
+			playerDataTables.clear(playerID);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&deletePlayerHook);
-		Engine::deletePlayer(playerID);
+		callOriginal(deletePlayerHook, Engine::deletePlayer, playerID);
+		ActiveSets::players.erase(playerID);
 
-		if (playerDataTables[playerID]) {
-			delete playerDataTables[playerID];
-			playerDataTables[playerID] = nullptr;
-		}
+		playerDataTables.clear(playerID);
 	}
 }
 
 int createHuman(Vector* pos, RotMatrix* rot, int playerID) {
 	if (enabledKeys[EnableKeys::HumanCreate]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("HumanCreate", pos, rot, &Engine::players[playerID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::HumanCreate, Pre, "HumanCreate", pos,
+		                         rot, &Engine::players[playerID]);
 		if (!noParent) {
-			int id;
-			{
-				subhook::ScopedHookRemove remove(&createHumanHook);
-				id = Engine::createHuman(pos, rot, playerID);
-
-				if (id != -1 && humanDataTables[id]) {
-					delete humanDataTables[id];
-					humanDataTables[id] = nullptr;
-				}
-			}
-			if (run != sol::nil && id != -1) {
-				auto res = run("PostHumanCreate", &Engine::humans[id]);
-				noLuaCallError(&res);
+			int id = callOriginal(createHumanHook, Engine::createHuman, pos, rot,
+			                      playerID);
+			if (id != -1) {
+				ActiveSets::humans.insert(id);
+				Lua::physics::markSpatialIndexStale();
+				humanDataTables.clear(id);
+				ChangeFeed::forget(ChangeFeed::Humans, id);
+
+				dispatch(EnableKeys::HumanCreate, Post, "PostHumanCreate",
+				         &Engine::humans[id]);
 			}
 			return id;
 		}
 		return -1;
 	} else {
-		subhook::ScopedHookRemove remove(&createHumanHook);
-		int id = Engine::createHuman(pos, rot, playerID);
-
-		if (id != -1 && humanDataTables[id]) {
-			delete humanDataTables[id];
-			humanDataTables[id] = nullptr;
+		int id = callOriginal(createHumanHook, Engine::createHuman, pos, rot,
+		                      playerID);
+		if (id != -1) {
+			ActiveSets::humans.insert(id);
+			Lua::physics::markSpatialIndexStale();
+			humanDataTables.clear(id);
+			ChangeFeed::forget(ChangeFeed::Humans, id);
 		}
-
 		return id;
 	}
 }
 
 void deleteHuman(int humanID) {
 	if (enabledKeys[EnableKeys::HumanDelete]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("HumanDelete", &Engine::humans[humanID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::HumanDelete, Pre, "HumanDelete",
+		                         &Engine::humans[humanID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&deleteHumanHook);
-				Engine::deleteHuman(humanID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostHumanDelete", &Engine::humans[humanID]);
-				noLuaCallError(&res);
-			}
-			if (humanDataTables[humanID]) {
-				delete humanDataTables[humanID];
-				humanDataTables[humanID] = nullptr;
-			}
+			callOriginal(deleteHumanHook, Engine::deleteHuman, humanID);
+			ActiveSets::humans.erase(humanID);
+			dispatch(EnableKeys::HumanDelete, Post, "PostHumanDelete",
+			         &Engine::humans[humanID]);
+			humanDataTables.clear(humanID);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&deleteHumanHook);
-		Engine::deleteHuman(humanID);
+		callOriginal(deleteHumanHook, Engine::deleteHuman, humanID);
+		ActiveSets::humans.erase(humanID);
 
-		if (humanDataTables[humanID]) {
-			delete humanDataTables[humanID];
-			humanDataTables[humanID] = nullptr;
-		}
+		humanDataTables.clear(humanID);
 	}
 }
 
 int createItem(int type, Vector* pos, Vector* vel, RotMatrix* rot) {
 	if (enabledKeys[EnableKeys::ItemCreate]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("ItemCreate", &Engine::itemTypes[type], pos, rot);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::ItemCreate, Pre, "ItemCreate",
+		                         &Engine::itemTypes[type], pos, rot);
 		if (!noParent) {
-			int id;
-			{
-				subhook::ScopedHookRemove remove(&createItemHook);
-				id = Engine::createItem(type, pos, vel, rot);
-			}
-			if (id != -1 && run != sol::nil) {
-				auto res = run("PostItemCreate", &Engine::items[id]);
-				noLuaCallError(&res);
-			}
-			if (id != -1 && itemDataTables[id]) {
-				delete itemDataTables[id];
-				itemDataTables[id] = nullptr;
+			int id = callOriginal(createItemHook, Engine::createItem, type, pos, vel,
+			                      rot);
+			if (id != -1) {
+				ActiveSets::items.insert(id);
+				Lua::physics::markSpatialIndexStale();
+
+				dispatch(EnableKeys::ItemCreate, Post, "PostItemCreate",
+				         &Engine::items[id]);
+
+				itemDataTables.clear(id);
+				ChangeFeed::forget(ChangeFeed::Items, id);
 			}
 			return id;
 		}
 		return -1;
 	} else {
-		subhook::ScopedHookRemove remove(&createItemHook);
-		int id = Engine::createItem(type, pos, vel, rot);
-
-		if (id != -1 && itemDataTables[id]) {
-			delete itemDataTables[id];
-			itemDataTables[id] = nullptr;
+		int id = callOriginal(createItemHook, Engine::createItem, type, pos, vel,
+		                      rot);
+		if (id != -1) {
+			ActiveSets::items.insert(id);
+			Lua::physics::markSpatialIndexStale();
+			itemDataTables.clear(id);
+			ChangeFeed::forget(ChangeFeed::Items, id);
 		}
-
 		return id;
 	}
 }
 
 void deleteItem(int itemID) {
 	if (enabledKeys[EnableKeys::ItemDelete]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("ItemDelete", &Engine::items[itemID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::ItemDelete, Pre, "ItemDelete",
+		                         &Engine::items[itemID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&deleteItemHook);
-				Engine::deleteItem(itemID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostItemDelete", &Engine::items[itemID]);
-				noLuaCallError(&res);
-			}
-			if (itemDataTables[itemID]) {
-				delete itemDataTables[itemID];
-				itemDataTables[itemID] = nullptr;
-			}
+			callOriginal(deleteItemHook, Engine::deleteItem, itemID);
+			ActiveSets::items.erase(itemID);
+			dispatch(EnableKeys::ItemDelete, Post, "PostItemDelete",
+			         &Engine::items[itemID]);
+			itemDataTables.clear(itemID);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&deleteItemHook);
-		Engine::deleteItem(itemID);
+		callOriginal(deleteItemHook, Engine::deleteItem, itemID);
+		ActiveSets::items.erase(itemID);
 
-		if (itemDataTables[itemID]) {
-			delete itemDataTables[itemID];
-			itemDataTables[itemID] = nullptr;
-		}
+		itemDataTables.clear(itemID);
 	}
 }
 
 int createVehicle(int type, Vector* pos, Vector* vel, RotMatrix* rot,
                   int color) {
 	if (enabledKeys[EnableKeys::VehicleCreate]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res =
-			    run("VehicleCreate", &Engine::vehicleTypes[type], pos, rot, color);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::VehicleCreate, Pre, "VehicleCreate",
+		                         &Engine::vehicleTypes[type], pos, rot, color);
 		if (!noParent) {
-			int id;
-			{
-				subhook::ScopedHookRemove remove(&createVehicleHook);
-				id = Engine::createVehicle(type, pos, vel, rot, color);
-
-				if (id != -1 && vehicleDataTables[id]) {
-					delete vehicleDataTables[id];
-					vehicleDataTables[id] = nullptr;
-				}
-			}
-			if (id != -1 && run != sol::nil) {
-				auto res = run("PostVehicleCreate", &Engine::vehicles[id]);
-				noLuaCallError(&res);
+			int id = callOriginal(createVehicleHook, Engine::createVehicle, type, pos,
+			                      vel, rot, color);
+			if (id != -1) {
+				ActiveSets::vehicles.insert(id);
+				Lua::physics::markSpatialIndexStale();
+				vehicleDataTables.clear(id);
+				ChangeFeed::forget(ChangeFeed::Vehicles, id);
+
+				dispatch(EnableKeys::VehicleCreate, Post, "PostVehicleCreate",
+				         &Engine::vehicles[id]);
 			}
 			return id;
 		}
 		return -1;
 	} else {
-		subhook::ScopedHookRemove remove(&createVehicleHook);
-		int id = Engine::createVehicle(type, pos, vel, rot, color);
-
-		if (id != -1 && vehicleDataTables[id]) {
-			delete vehicleDataTables[id];
-			vehicleDataTables[id] = nullptr;
+		int id = callOriginal(createVehicleHook, Engine::createVehicle, type, pos,
+		                      vel, rot, color);
+		if (id != -1) {
+			ActiveSets::vehicles.insert(id);
+			Lua::physics::markSpatialIndexStale();
+			vehicleDataTables.clear(id);
+			ChangeFeed::forget(ChangeFeed::Vehicles, id);
 		}
-
 		return id;
 	}
 }
 
 void deleteVehicle(int vehicleID) {
 	if (enabledKeys[EnableKeys::VehicleDelete]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("VehicleDelete", &Engine::vehicles[vehicleID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::VehicleDelete, Pre, "VehicleDelete",
+		                         &Engine::vehicles[vehicleID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&deleteVehicleHook);
-				Engine::deleteVehicle(vehicleID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostVehicleDelete", &Engine::vehicles[vehicleID]);
-				noLuaCallError(&res);
-			}
-			if (vehicleDataTables[vehicleID]) {
-				delete vehicleDataTables[vehicleID];
-				vehicleDataTables[vehicleID] = nullptr;
-			}
+			callOriginal(deleteVehicleHook, Engine::deleteVehicle, vehicleID);
+			ActiveSets::vehicles.erase(vehicleID);
+			dispatch(EnableKeys::VehicleDelete, Post, "PostVehicleDelete",
+			         &Engine::vehicles[vehicleID]);
+			vehicleDataTables.clear(vehicleID);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&deleteVehicleHook);
-		Engine::deleteVehicle(vehicleID);
+		callOriginal(deleteVehicleHook, Engine::deleteVehicle, vehicleID);
+		ActiveSets::vehicles.erase(vehicleID);
 
-		if (vehicleDataTables[vehicleID]) {
-			delete vehicleDataTables[vehicleID];
-			vehicleDataTables[vehicleID] = nullptr;
-		}
+		vehicleDataTables.clear(vehicleID);
 	}
 }
 
 int createRigidBody(int type, Vector* pos, RotMatrix* rot, Vector* vel,
                     Vector* scale, float mass) {
-	int id;
-	{
-		subhook::ScopedHookRemove remove(&createRigidBodyHook);
-		id = Engine::createRigidBody(type, pos, rot, vel, scale, mass);
-	}
-	if (id != -1 && bodyDataTables[id]) {
-		delete bodyDataTables[id];
-		bodyDataTables[id] = nullptr;
+	int id = callOriginal(createRigidBodyHook, Engine::createRigidBody, type, pos,
+	                      rot, vel, scale, mass);
+	if (id != -1) {
+		ActiveSets::bodies.insert(id);
+		bodyDataTables.clear(id);
 	}
 	return id;
 }
 
 int linkItem(int itemID, int childItemID, int parentHumanID, int slot) {
 	if (enabledKeys[EnableKeys::ItemLink]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run(
-			    "ItemLink", &Engine::items[itemID],
-			    childItemID == -1 ? nullptr : &Engine::items[childItemID],
-			    parentHumanID == -1 ? nullptr : &Engine::humans[parentHumanID], slot);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(
+		    EnableKeys::ItemLink, Pre, "ItemLink", &Engine::items[itemID],
+		    childItemID == -1 ? nullptr : &Engine::items[childItemID],
+		    parentHumanID == -1 ? nullptr : &Engine::humans[parentHumanID], slot);
 		if (!noParent) {
-			int worked;
-			{
-				subhook::ScopedHookRemove remove(&linkItemHook);
-				worked = Engine::linkItem(itemID, childItemID, parentHumanID, slot);
-			}
-			if (run != sol::nil) {
-				auto res =
-				    run("PostItemLink", &Engine::items[itemID],
-				        childItemID == -1 ? nullptr : &Engine::items[childItemID],
-				        parentHumanID == -1 ? nullptr : &Engine::humans[parentHumanID],
-				        slot, (bool)worked);
-				noLuaCallError(&res);
-			}
+			int worked = callOriginal(linkItemHook, Engine::linkItem, itemID,
+			                          childItemID, parentHumanID, slot);
+			dispatch(EnableKeys::ItemLink, Post, "PostItemLink",
+			         &Engine::items[itemID],
+			         childItemID == -1 ? nullptr : &Engine::items[childItemID],
+			         parentHumanID == -1 ? nullptr : &Engine::humans[parentHumanID],
+			         slot, (bool)worked);
 			return worked;
 		}
 		return 0;
 	} else {
-		subhook::ScopedHookRemove remove(&linkItemHook);
-		return Engine::linkItem(itemID, childItemID, parentHumanID, slot);
+		return callOriginal(linkItemHook, Engine::linkItem, itemID, childItemID,
+		                    parentHumanID, slot);
 	}
 }
 
 void itemComputerInput(int itemID, unsigned int character) {
 	if (enabledKeys[EnableKeys::ItemComputerInput]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("ItemComputerInput", &Engine::items[itemID], character);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::ItemComputerInput, Pre,
+		                         "ItemComputerInput", &Engine::items[itemID],
+		                         character);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&itemComputerInputHook);
-				Engine::itemComputerInput(itemID, character);
-			}
-			if (run != sol::nil) {
-				auto res =
-				    run("PostItemComputerInput", &Engine::items[itemID], character);
-				noLuaCallError(&res);
-			}
+			callOriginal(itemComputerInputHook, Engine::itemComputerInput, itemID,
+			             character);
+			dispatch(EnableKeys::ItemComputerInput, Post, "PostItemComputerInput",
+			         &Engine::items[itemID], character);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&itemComputerInputHook);
-		Engine::itemComputerInput(itemID, character);
+		callOriginal(itemComputerInputHook, Engine::itemComputerInput, itemID,
+		             character);
 	}
 }
 
 void humanApplyDamage(int humanID, int bone, int unk, int damage) {
 	if (enabledKeys[EnableKeys::HumanDamage]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("HumanDamage", &Engine::humans[humanID], bone, damage);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::HumanDamage, Pre, "HumanDamage",
+		                         &Engine::humans[humanID], bone, damage);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&humanApplyDamageHook);
-				Engine::humanApplyDamage(humanID, bone, unk, damage);
-			}
-			if (run != sol::nil) {
-				auto res =
-				    run("PostHumanDamage", &Engine::humans[humanID], bone, damage);
-				noLuaCallError(&res);
-			}
+			callOriginal(humanApplyDamageHook, Engine::humanApplyDamage, humanID,
+			             bone, unk, damage);
+			dispatch(EnableKeys::HumanDamage, Post, "PostHumanDamage",
+			         &Engine::humans[humanID], bone, damage);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&humanApplyDamageHook);
-		Engine::humanApplyDamage(humanID, bone, unk, damage);
+		callOriginal(humanApplyDamageHook, Engine::humanApplyDamage, humanID, bone,
+		             unk, damage);
 	}
 }
 
 void humanCollisionVehicle(int humanID, int vehicleID) {
 	if (enabledKeys[EnableKeys::HumanCollisionVehicle]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("HumanCollisionVehicle", &Engine::humans[humanID],
-			               &Engine::vehicles[vehicleID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::HumanCollisionVehicle, Pre,
+		                         "HumanCollisionVehicle", &Engine::humans[humanID],
+		                         &Engine::vehicles[vehicleID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&humanCollisionVehicleHook);
-				Engine::humanCollisionVehicle(humanID, vehicleID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostHumanCollisionVehicle", &Engine::humans[humanID],
-				               &Engine::vehicles[vehicleID]);
-				noLuaCallError(&res);
-			}
+			callOriginal(humanCollisionVehicleHook, Engine::humanCollisionVehicle,
+			             humanID, vehicleID);
+			dispatch(EnableKeys::HumanCollisionVehicle, Post,
+			         "PostHumanCollisionVehicle", &Engine::humans[humanID],
+			         &Engine::vehicles[vehicleID]);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&humanCollisionVehicleHook);
-		Engine::humanCollisionVehicle(humanID, vehicleID);
+		callOriginal(humanCollisionVehicleHook, Engine::humanCollisionVehicle,
+		             humanID, vehicleID);
 	}
 }
 
@@ -1318,175 +1284,142 @@ void humanLimbInverseKinematics(int humanID, int trunkBoneID, int branchBoneID,
                                 Vector* vecB, Vector* vecC, Vector* vecD,
                                 char flags) {
 	if (enabledKeys[EnableKeys::HumanLimbInverseKinematics]) {
-		bool noParent = false;
-
-		if (run != sol::nil) {
-			Float wrappedA = {a};
-			Float wrappedRot = {rot};
-			Float wrappedStrength = {strength};
-			Integer wrappedFlags = {+flags};
-
-			auto res = run("HumanLimbInverseKinematics", &Engine::humans[humanID],
-			               trunkBoneID, branchBoneID, destination, destinationAxis,
-			               vecA, &wrappedA, &wrappedRot, &wrappedStrength, vecB, vecC,
-			               vecD, &wrappedFlags);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-
-			a = wrappedA.value;
-			rot = wrappedRot.value;
-			strength = wrappedStrength.value;
-			flags = wrappedFlags.value;
-		}
+		Float wrappedA = {a};
+		Float wrappedRot = {rot};
+		Float wrappedStrength = {strength};
+		Integer wrappedFlags = {+flags};
+
+		bool noParent = dispatch(EnableKeys::HumanLimbInverseKinematics, Pre,
+		                         "HumanLimbInverseKinematics",
+		                         &Engine::humans[humanID], trunkBoneID,
+		                         branchBoneID, destination, destinationAxis, vecA,
+		                         &wrappedA, &wrappedRot, &wrappedStrength, vecB,
+		                         vecC, vecD, &wrappedFlags);
+
+		a = wrappedA.value;
+		rot = wrappedRot.value;
+		strength = wrappedStrength.value;
+		flags = wrappedFlags.value;
 		if (!noParent) {
-			subhook::ScopedHookRemove remove(&humanLimbInverseKinematicsHook);
-			Engine::humanLimbInverseKinematics(
-			    humanID, trunkBoneID, branchBoneID, destination, destinationAxis,
-			    vecA, a, rot, strength, d, vecB, vecC, vecD, flags);
+			callOriginal(humanLimbInverseKinematicsHook,
+			             Engine::humanLimbInverseKinematics, humanID, trunkBoneID,
+			             branchBoneID, destination, destinationAxis, vecA, a, rot,
+			             strength, d, vecB, vecC, vecD, flags);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&humanLimbInverseKinematicsHook);
-		Engine::humanLimbInverseKinematics(
-		    humanID, trunkBoneID, branchBoneID, destination, destinationAxis, vecA,
-		    a, rot, strength, d, vecB, vecC, vecD, flags);
+		callOriginal(humanLimbInverseKinematicsHook,
+		             Engine::humanLimbInverseKinematics, humanID, trunkBoneID,
+		             branchBoneID, destination, destinationAxis, vecA, a, rot,
+		             strength, d, vecB, vecC, vecD, flags);
 	}
 }
 
 void grenadeExplosion(int itemID) {
 	if (enabledKeys[EnableKeys::GrenadeExplode]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("GrenadeExplode", &Engine::items[itemID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::GrenadeExplode, Pre, "GrenadeExplode",
+		                         &Engine::items[itemID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&grenadeExplosionHook);
-				Engine::grenadeExplosion(itemID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostGrenadeExplode", &Engine::items[itemID]);
-				noLuaCallError(&res);
-			}
+			callOriginal(grenadeExplosionHook, Engine::grenadeExplosion, itemID);
+			dispatch(EnableKeys::GrenadeExplode, Post, "PostGrenadeExplode",
+			         &Engine::items[itemID]);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&grenadeExplosionHook);
-		Engine::grenadeExplosion(itemID);
+		callOriginal(grenadeExplosionHook, Engine::grenadeExplosion, itemID);
 	}
 }
 
 int serverPlayerMessage(int playerID, char* message) {
 	if (enabledKeys[EnableKeys::PlayerChat]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("PlayerChat", &Engine::players[playerID], message);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::PlayerChat, Pre, "PlayerChat",
+		                         &Engine::players[playerID], message);
 		if (!noParent) {
-			subhook::ScopedHookRemove remove(&serverPlayerMessageHook);
-			return Engine::serverPlayerMessage(playerID, message);
+			return callOriginal(serverPlayerMessageHook, Engine::serverPlayerMessage,
+			                    playerID, message);
 		}
 		return 1;
 	} else {
-		subhook::ScopedHookRemove remove(&serverPlayerMessageHook);
-		return Engine::serverPlayerMessage(playerID, message);
+		return callOriginal(serverPlayerMessageHook, Engine::serverPlayerMessage,
+		                    playerID, message);
 	}
 }
 
 void playerAI(int playerID) {
 	if (enabledKeys[EnableKeys::PlayerAI]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("PlayerAI", &Engine::players[playerID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::PlayerAI, Pre, "PlayerAI",
+		                         &Engine::players[playerID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&playerAIHook);
-				Engine::playerAI(playerID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostPlayerAI", &Engine::players[playerID]);
-				noLuaCallError(&res);
-			}
+			callOriginal(playerAIHook, Engine::playerAI, playerID);
+			dispatch(EnableKeys::PlayerAI, Post, "PostPlayerAI",
+			         &Engine::players[playerID]);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&playerAIHook);
-		Engine::playerAI(playerID);
+		callOriginal(playerAIHook, Engine::playerAI, playerID);
 	}
 }
 
 void playerDeathTax(int playerID) {
 	if (enabledKeys[EnableKeys::PlayerDeathTax]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("PlayerDeathTax", &Engine::players[playerID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::PlayerDeathTax, Pre, "PlayerDeathTax",
+		                         &Engine::players[playerID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&playerDeathTaxHook);
-				Engine::playerDeathTax(playerID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostPlayerDeathTax", &Engine::players[playerID]);
-				noLuaCallError(&res);
-			}
+			callOriginal(playerDeathTaxHook, Engine::playerDeathTax, playerID);
+			dispatch(EnableKeys::PlayerDeathTax, Post, "PostPlayerDeathTax",
+			         &Engine::players[playerID]);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&playerDeathTaxHook);
-		Engine::playerDeathTax(playerID);
+		callOriginal(playerDeathTaxHook, Engine::playerDeathTax, playerID);
 	}
 }
 
 void accountDeathTax(int accountID) {
 	if (enabledKeys[EnableKeys::AccountDeathTax]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("AccountDeathTax", &Engine::accounts[accountID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::AccountDeathTax, Pre,
+		                         "AccountDeathTax", &Engine::accounts[accountID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&accountDeathTaxHook);
-				Engine::accountDeathTax(accountID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostAccountDeathTax", &Engine::accounts[accountID]);
-				noLuaCallError(&res);
-			}
+			callOriginal(accountDeathTaxHook, Engine::accountDeathTax, accountID);
+			dispatch(EnableKeys::AccountDeathTax, Post, "PostAccountDeathTax",
+			         &Engine::accounts[accountID]);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&accountDeathTaxHook);
-		Engine::accountDeathTax(accountID);
+		callOriginal(accountDeathTaxHook, Engine::accountDeathTax, accountID);
 	}
 }
 
 void playerGiveWantedLevel(int playerID, int victimPlayerID, int basePoints) {
 	if (enabledKeys[EnableKeys::PlayerGiveWantedLevel]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			Integer wrappedBasePoints = {basePoints};
+		Integer wrappedBasePoints = {basePoints};
 
-			auto res = run("PlayerGiveWantedLevel", &Engine::players[playerID],
-			               &Engine::players[victimPlayerID], &wrappedBasePoints);
-			if (noLuaCallError(&res)) noParent = (bool)res;
+		bool noParent = dispatch(EnableKeys::PlayerGiveWantedLevel, Pre,
+		                         "PlayerGiveWantedLevel",
+		                         &Engine::players[playerID],
+		                         &Engine::players[victimPlayerID],
+		                         &wrappedBasePoints);
 
-			basePoints = wrappedBasePoints.value;
-		}
+		basePoints = wrappedBasePoints.value;
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&playerGiveWantedLevelHook);
-				Engine::playerGiveWantedLevel(playerID, victimPlayerID, basePoints);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostPlayerGiveWantedLevel", &Engine::players[playerID],
-				               &Engine::players[victimPlayerID], basePoints);
-				noLuaCallError(&res);
-			}
+			callOriginal(playerGiveWantedLevelHook, Engine::playerGiveWantedLevel,
+			             playerID, victimPlayerID, basePoints);
+			dispatch(EnableKeys::PlayerGiveWantedLevel, Post,
+			         "PostPlayerGiveWantedLevel", &Engine::players[playerID],
+			         &Engine::players[victimPlayerID], basePoints);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&playerGiveWantedLevelHook);
-		Engine::playerGiveWantedLevel(playerID, victimPlayerID, basePoints);
+		callOriginal(playerGiveWantedLevelHook, Engine::playerGiveWantedLevel,
+		             playerID, victimPlayerID, basePoints);
+	}
+}
+
+static inline void batchCollideBodies(int aBodyID, int bBodyID,
+                                      Vector* aLocalPos, Vector* bLocalPos,
+                                      Vector* normal, float a, float b, float c,
+                                      float d) {
+	if (enabledKeys[EnableKeys::CollideBodiesBatch]) {
+		auto aPos = orZero(aLocalPos);
+		auto bPos = orZero(bLocalPos);
+		auto n = orZero(normal);
+		collideBodiesBatch.add({(double)aBodyID, (double)bBodyID, aPos.x, aPos.y,
+		                        aPos.z, bPos.x, bPos.y, bPos.z, n.x, n.y, n.z, a, b,
+		                        c, d});
 	}
 }
 
@@ -1495,22 +1428,22 @@ void addCollisionRigidBodyOnRigidBody(int aBodyID, int bBodyID,
                                       Vector* normal, float a, float b, float c,
                                       float d) {
 	if (enabledKeys[EnableKeys::CollideBodies]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("CollideBodies", &Engine::bodies[aBodyID],
-			               &Engine::bodies[bBodyID], aLocalPos, bLocalPos, normal, a,
-			               b, c, d);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::CollideBodies, Pre, "CollideBodies",
+		                         &Engine::bodies[aBodyID], &Engine::bodies[bBodyID],
+		                         aLocalPos, bLocalPos, normal, a, b, c, d);
 		if (!noParent) {
-			subhook::ScopedHookRemove remove(&addCollisionRigidBodyOnRigidBodyHook);
-			Engine::addCollisionRigidBodyOnRigidBody(aBodyID, bBodyID, aLocalPos,
-			                                         bLocalPos, normal, a, b, c, d);
+			callOriginal(addCollisionRigidBodyOnRigidBodyHook,
+			             Engine::addCollisionRigidBodyOnRigidBody, aBodyID, bBodyID,
+			             aLocalPos, bLocalPos, normal, a, b, c, d);
+			batchCollideBodies(aBodyID, bBodyID, aLocalPos, bLocalPos, normal, a, b,
+			                   c, d);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&addCollisionRigidBodyOnRigidBodyHook);
-		Engine::addCollisionRigidBodyOnRigidBody(aBodyID, bBodyID, aLocalPos,
-		                                         bLocalPos, normal, a, b, c, d);
+		callOriginal(addCollisionRigidBodyOnRigidBodyHook,
+		             Engine::addCollisionRigidBodyOnRigidBody, aBodyID, bBodyID,
+		             aLocalPos, bLocalPos, normal, a, b, c, d);
+		batchCollideBodies(aBodyID, bBodyID, aLocalPos, bLocalPos, normal, a, b, c,
+		                   d);
 	}
 }
 
@@ -1527,76 +1460,73 @@ Type:
 void createEventMessage(int speakerType, char* message, int speakerID,
                         int distance) {
 	if (enabledKeys[EnableKeys::EventMessage]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("EventMessage", speakerType, message, speakerID, distance);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::EventMessage, Pre, "EventMessage",
+		                         speakerType, message, speakerID, distance);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&createEventMessageHook);
-				Engine::createEventMessage(speakerType, message, speakerID, distance);
-			}
-			if (run != sol::nil) {
-				auto res =
-				    run("PostEventMessage", speakerType, message, speakerID, distance);
-				noLuaCallError(&res);
-			}
+			callOriginal(createEventMessageHook, Engine::createEventMessage,
+			             speakerType, message, speakerID, distance);
+			dispatch(EnableKeys::EventMessage, Post, "PostEventMessage", speakerType,
+			         message, speakerID, distance);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&createEventMessageHook);
-		Engine::createEventMessage(speakerType, message, speakerID, distance);
+		callOriginal(createEventMessageHook, Engine::createEventMessage,
+		             speakerType, message, speakerID, distance);
 	}
 }
 
 void createEventUpdatePlayer(int id) {
 	if (enabledKeys[EnableKeys::EventUpdatePlayer]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("EventUpdatePlayer", &Engine::players[id]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::EventUpdatePlayer, Pre,
+		                         "EventUpdatePlayer", &Engine::players[id]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&createEventUpdatePlayerHook);
-				Engine::createEventUpdatePlayer(id);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostEventUpdatePlayer", &Engine::players[id]);
-				noLuaCallError(&res);
-			}
+			callOriginal(createEventUpdatePlayerHook, Engine::createEventUpdatePlayer,
+			             id);
+			dispatch(EnableKeys::EventUpdatePlayer, Post, "PostEventUpdatePlayer",
+			         &Engine::players[id]);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&createEventUpdatePlayerHook);
-		Engine::createEventUpdatePlayer(id);
+		callOriginal(createEventUpdatePlayerHook, Engine::createEventUpdatePlayer,
+		             id);
+	}
+}
+
+static inline void batchEventUpdateVehicle(int vehicleID, int updateType,
+                                           int partID, Vector* pos,
+                                           Vector* normal) {
+	if (enabledKeys[EnableKeys::EventUpdateVehicleBatch]) {
+		auto p = orZero(pos);
+		auto n = orZero(normal);
+		eventUpdateVehicleBatch.add({(double)vehicleID, (double)updateType,
+		                             (double)partID, p.x, p.y, p.z, n.x, n.y, n.z});
 	}
 }
 
 void createEventUpdateVehicle(int vehicleID, int updateType, int partID,
                               Vector* pos, Vector* normal) {
 	if (enabledKeys[EnableKeys::EventUpdateVehicle]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("EventUpdateVehicle", &Engine::vehicles[vehicleID],
-			               updateType, partID, pos, normal);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::EventUpdateVehicle, Pre,
+		                         "EventUpdateVehicle", &Engine::vehicles[vehicleID],
+		                         updateType, partID, pos, normal);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&createEventUpdateVehicleHook);
-				Engine::createEventUpdateVehicle(vehicleID, updateType, partID, pos,
-				                                 normal);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostEventUpdateVehicle", &Engine::vehicles[vehicleID],
-				               updateType, partID, pos, normal);
-				noLuaCallError(&res);
-			}
+			callOriginal(createEventUpdateVehicleHook,
+			             Engine::createEventUpdateVehicle, vehicleID, updateType,
+			             partID, pos, normal);
+			dispatch(EnableKeys::EventUpdateVehicle, Post, "PostEventUpdateVehicle",
+			         &Engine::vehicles[vehicleID], updateType, partID, pos, normal);
+			batchEventUpdateVehicle(vehicleID, updateType, partID, pos, normal);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&createEventUpdateVehicleHook);
-		Engine::createEventUpdateVehicle(vehicleID, updateType, partID, pos,
-		                                 normal);
+		callOriginal(createEventUpdateVehicleHook, Engine::createEventUpdateVehicle,
+		             vehicleID, updateType, partID, pos, normal);
+		batchEventUpdateVehicle(vehicleID, updateType, partID, pos, normal);
+	}
+}
+
+static inline void batchEventSound(int soundType, Vector* pos, float volume,
+                                   float pitch) {
+	if (enabledKeys[EnableKeys::EventSoundBatch]) {
+		auto p = orZero(pos);
+		eventSoundBatch.add({(double)soundType, p.x, p.y, p.z, volume, pitch});
 	}
 }
 
@@ -1607,122 +1537,118 @@ void createEventSound(int soundType, Vector* pos, float volume, float pitch) {
 	asm("mov %%r10, %0" : "=r"(r10) :);
 
 	if (enabledKeys[EnableKeys::EventSound]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			Float wrappedVolume = {volume};
-			Float wrappedPitch = {pitch};
+		Float wrappedVolume = {volume};
+		Float wrappedPitch = {pitch};
 
-			auto res = run("EventSound", soundType, pos, wrappedVolume, wrappedPitch);
-			if (noLuaCallError(&res)) noParent = (bool)res;
+		bool noParent = dispatch(EnableKeys::EventSound, Pre, "EventSound",
+		                         soundType, pos, wrappedVolume, wrappedPitch);
 
-			volume = wrappedVolume.value;
-			pitch = wrappedPitch.value;
-		}
+		volume = wrappedVolume.value;
+		pitch = wrappedPitch.value;
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&createEventSoundHook);
-				Engine::createEventSound(soundType, pos, volume, pitch);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostEventSound", soundType, pos, volume, pitch);
-				noLuaCallError(&res);
-			}
+			callOriginal(createEventSoundHook, Engine::createEventSound, soundType,
+			             pos, volume, pitch);
+			dispatch(EnableKeys::EventSound, Post, "PostEventSound", soundType, pos,
+			         volume, pitch);
+			batchEventSound(soundType, pos, volume, pitch);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&createEventSoundHook);
-		Engine::createEventSound(soundType, pos, volume, pitch);
+		callOriginal(createEventSoundHook, Engine::createEventSound, soundType, pos,
+		             volume, pitch);
+		batchEventSound(soundType, pos, volume, pitch);
 	}
 
 	asm("mov %0, %%r10" : : "r"(r10));
 }
 
+static inline void batchEventBullet(int bulletType, Vector* pos, Vector* vel,
+                                    int itemID) {
+	if (enabledKeys[EnableKeys::EventBulletBatch]) {
+		auto p = orZero(pos);
+		auto v = orZero(vel);
+		eventBulletBatch.add(
+		    {(double)bulletType, (double)itemID, p.x, p.y, p.z, v.x, v.y, v.z});
+	}
+}
+
 void createEventBullet(int bulletType, Vector* pos, Vector* vel, int itemID) {
 	if (enabledKeys[EnableKeys::EventBullet]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res =
-			    run("EventBullet", bulletType, pos, vel, &Engine::items[itemID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::EventBullet, Pre, "EventBullet",
+		                         bulletType, pos, vel, &Engine::items[itemID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&createEventBulletHook);
-				Engine::createEventBullet(bulletType, pos, vel, itemID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostEventBullet", bulletType, pos, vel,
-				               &Engine::items[itemID]);
-				noLuaCallError(&res);
-			}
+			callOriginal(createEventBulletHook, Engine::createEventBullet, bulletType,
+			             pos, vel, itemID);
+			dispatch(EnableKeys::EventBullet, Post, "PostEventBullet", bulletType,
+			         pos, vel, &Engine::items[itemID]);
+			batchEventBullet(bulletType, pos, vel, itemID);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&createEventBulletHook);
-		Engine::createEventBullet(bulletType, pos, vel, itemID);
+		callOriginal(createEventBulletHook, Engine::createEventBullet, bulletType,
+		             pos, vel, itemID);
+		batchEventBullet(bulletType, pos, vel, itemID);
+	}
+}
+
+static inline void batchEventBulletHit(int hitType, Vector* pos,
+                                       Vector* normal) {
+	if (enabledKeys[EnableKeys::EventBulletHitBatch]) {
+		auto p = orZero(pos);
+		auto n = orZero(normal);
+		eventBulletHitBatch.add({(double)hitType, p.x, p.y, p.z, n.x, n.y, n.z});
 	}
 }
 
 void createEventBulletHit(int unk, int hitType, Vector* pos, Vector* normal) {
 	if (enabledKeys[EnableKeys::EventBulletHit]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("EventBulletHit", hitType, pos, normal);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::EventBulletHit, Pre, "EventBulletHit",
+		                         hitType, pos, normal);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&createEventBulletHitHook);
-				Engine::createEventBulletHit(unk, hitType, pos, normal);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostEventBulletHit", hitType, pos, normal);
-				noLuaCallError(&res);
-			}
+			callOriginal(createEventBulletHitHook, Engine::createEventBulletHit, unk,
+			             hitType, pos, normal);
+			dispatch(EnableKeys::EventBulletHit, Post, "PostEventBulletHit", hitType,
+			         pos, normal);
+			batchEventBulletHit(hitType, pos, normal);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&createEventBulletHitHook);
-		Engine::createEventBulletHit(unk, hitType, pos, normal);
+		callOriginal(createEventBulletHitHook, Engine::createEventBulletHit, unk,
+		             hitType, pos, normal);
+		batchEventBulletHit(hitType, pos, normal);
 	}
 }
 
 int lineIntersectHuman(int humanID, Vector* posA, Vector* posB, float padding) {
 	if (enabledKeys[EnableKeys::LineIntersectHuman]) {
-		int didHit;
-		{
-			subhook::ScopedHookRemove remove(&lineIntersectHumanHook);
-			didHit = Engine::lineIntersectHuman(humanID, posA, posB, padding);
-		}
+		int didHit = callOriginal(lineIntersectHumanHook,
+		                          Engine::lineIntersectHuman, humanID, posA, posB,
+		                          padding);
 
 		if (!didHit) {
 			return didHit;
 		}
 
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res =
-			    run("LineIntersectHuman", &Engine::humans[humanID], posA, posB);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = dispatch(EnableKeys::LineIntersectHuman, Pre,
+		                         "LineIntersectHuman", &Engine::humans[humanID],
+		                         posA, posB);
 
 		return !noParent;
 	} else {
-		subhook::ScopedHookRemove remove(&lineIntersectHumanHook);
-		return Engine::lineIntersectHuman(humanID, posA, posB, padding);
+		return callOriginal(lineIntersectHumanHook, Engine::lineIntersectHuman,
+		                    humanID, posA, posB, padding);
 	}
 }
 
+// Installed while BulletMayHit is enabled, the engine's other level raycasts
+// only pass through
 int lineIntersectLevel(Vector* posA, Vector* posB, int unk) {
-	if (isInBulletSimulation) {
-		if (run != sol::nil) {
-			// posA is Bullet.pos in this case
-			Bullet* bullet =
-			    reinterpret_cast<Bullet*>(reinterpret_cast<uintptr_t>(posA) - 0x20);
-			auto res = run("BulletMayHit", bullet);
-			noLuaCallError(&res);
-		}
+	if (isInBulletSimulation && enabledKeys[EnableKeys::BulletMayHit]) {
+		// posA is Bullet.pos in this case
+		Bullet* bullet =
+		    reinterpret_cast<Bullet*>(reinterpret_cast<uintptr_t>(posA) - 0x20);
+		dispatch(EnableKeys::BulletMayHit, Pre, "BulletMayHit", bullet);
 	}
 
-	subhook::ScopedHookRemove remove(&lineIntersectLevelHook);
-	return Engine::lineIntersectLevel(posA, posB, unk);
+	return callOriginal(lineIntersectLevelHook, Engine::lineIntersectLevel, posA,
+	                    posB, unk);
 }
 
 bool isInBulletSimulation = false;
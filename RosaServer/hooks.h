@@ -2,11 +2,34 @@
 #include "structs.h"
 #include "subhook.h"
 
+#include <chrono>
+#include <memory>
 #include <set>
 #include <unordered_map>
+#include <utility>
+#include <vector>
+
+bool noLuaCallError(sol::protected_function_result* res);
 
 namespace Hooks {
 extern sol::protected_function run;
+// Only cleared to benchmark callOriginal against removing the hook instead
+extern bool useTrampolines;
+
+// Calls the engine function behind a hook without going through its detour.
+// subhook relocates the overwritten prologue into a trampoline when the hook
+// is installed, so the detour can stay in place; the hook is only removed for
+// the duration of the call if no trampoline could be built.
+template <typename Func, typename... Args>
+inline auto callOriginal(subhook::Hook& hook, Func original, Args&&... args) {
+	auto trampoline = reinterpret_cast<Func>(hook.GetTrampoline());
+	if (trampoline != nullptr && useTrampolines) {
+		return trampoline(std::forward<Args>(args)...);
+	}
+
+	subhook::ScopedHookRemove remove(&hook);
+	return original(std::forward<Args>(args)...);
+}
 
 enum EnableKeys {
 	ResetGame,
@@ -69,12 +92,122 @@ enum EnableKeys {
 	EventBullet,
 	EventBulletHit,
 	LineIntersectHuman,
+	BulletMayHit,
+	TickOverrun,
+	BulletCreateBatch,
+	CollideBodiesBatch,
+	EventUpdateVehicleBatch,
+	EventSoundBatch,
+	EventBulletBatch,
+	EventBulletHitBatch,
 	SIZE
 };
 
 extern const std::unordered_map<std::string, EnableKeys> enableNames;
 extern bool enabledKeys[EnableKeys::SIZE];
 
+// Enables or disables a key, installing or removing its detour to match.
+void setEnabled(EnableKeys key, bool enabled);
+// Removes the detours of every disabled key, used after installing at boot.
+void removeDisabledHooks();
+
+enum Phase { Pre, Post };
+
+struct Handler {
+	sol::protected_function function;
+	int priority;
+};
+
+// Handlers registered per key and phase, sorted by priority. A slot is
+// replaced rather than modified, so a handler adding or removing handlers
+// doesn't invalidate the list being dispatched.
+extern std::shared_ptr<const std::vector<Handler>>
+    handlers[2][EnableKeys::SIZE];
+
+void addHandler(EnableKeys key, Phase phase, sol::protected_function function,
+                int priority);
+bool removeHandler(EnableKeys key, Phase phase,
+                   const sol::protected_function& function);
+void clearHandlers();
+
+// Buckets are powers of two in microseconds: the first counts calls under
+// 1 us, bucket n counts calls from 2^(n-1) us, and the last one counts
+// everything from 2^14 us (about a whole tick) up.
+constexpr int statsHistogramSize = 16;
+
+struct Stats {
+	unsigned long long calls;
+	unsigned long long totalNanoseconds;
+	unsigned long long maxNanoseconds;
+	unsigned long long histogram[statsHistogramSize];
+};
+
+extern Stats stats[2][EnableKeys::SIZE];
+
+void recordCall(EnableKeys key, Phase phase, std::chrono::nanoseconds time);
+void resetStats();
+
+// Rows of numbers collected over a tick for one of the *Batch keys, which are
+// passed to Lua all at once as a table of columns instead of one call per
+// event.
+class EventBatch {
+	std::vector<const char*> columns;
+	std::vector<double> values;
+
+ public:
+	EventBatch(std::initializer_list<const char*> columns, size_t reservedRows)
+	    : columns(columns) {
+		values.reserve(columns.size() * reservedRows);
+	}
+	void add(std::initializer_list<double> row) {
+		values.insert(values.end(), row);
+	}
+	size_t size() const { return values.size() / columns.size(); }
+	void clear() { values.clear(); }
+	// Returns the rows as {count = n, column = {...}, ...} and clears them.
+	sol::table flush();
+};
+
+// Passes every non-empty batch to its hook, called once per tick.
+void flushBatches();
+
+inline bool hasListeners(EnableKeys key, Phase phase) {
+	return handlers[phase][key] != nullptr || run != sol::nil;
+}
+
+// Calls the handlers of a key in priority order, then hook.run with the event
+// name. Returns true as soon as one of them returns a truthy value, which
+// means the original function should not be called. The time taken is added
+// to the stats of the key.
+template <typename... Args>
+bool dispatch(EnableKeys key, Phase phase, const char* name, Args&&... args) {
+	auto list = handlers[phase][key];
+	if (!list && run == sol::nil) {
+		return false;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	bool noParent = false;
+
+	if (list) {
+		for (auto& handler : *list) {
+			auto res = handler.function(args...);
+			if (noLuaCallError(&res) && (bool)res) {
+				noParent = true;
+				break;
+			}
+		}
+	}
+
+	if (!noParent && run != sol::nil) {
+		auto res = run(name, args...);
+		if (noLuaCallError(&res)) noParent = (bool)res;
+	}
+
+	recordCall(key, phase, std::chrono::steady_clock::now() - start);
+	return noParent;
+}
+
 extern subhook::Hook subRosaPutsHook;
 int subRosaPuts(const char* str);
 extern subhook::Hook subRosa__printf_chkHook;
@@ -0,0 +1,111 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Bounded lock-free queue after Dmitry Vyukov's, where every slot carries a
+// sequence number saying whose turn it is. Any thread may push or pop, which
+// lets a producer make room by popping the oldest entry itself.
+template <typename T>
+class MessageQueue {
+	struct Slot {
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	std::unique_ptr<Slot[]> slots;
+	size_t mask;
+
+	alignas(64) std::atomic<size_t> pushPosition = 0;
+	alignas(64) std::atomic<size_t> popPosition = 0;
+	std::atomic<uint64_t> numDropped = 0;
+
+ public:
+	// capacity has to be a power of two
+	explicit MessageQueue(size_t capacity)
+	    : slots(new Slot[capacity]), mask(capacity - 1) {
+		for (size_t i = 0; i < capacity; i++) {
+			slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	size_t capacity() const { return mask + 1; }
+
+	// Only a snapshot while other threads are pushing or popping
+	size_t size() const {
+		size_t pushed = pushPosition.load(std::memory_order_acquire);
+		size_t popped = popPosition.load(std::memory_order_acquire);
+		return pushed > popped ? pushed - popped : 0;
+	}
+
+	// Messages dropped or refused because the queue was full
+	uint64_t getNumDropped() const {
+		return numDropped.load(std::memory_order_relaxed);
+	}
+	void countDropped() { numDropped.fetch_add(1, std::memory_order_relaxed); }
+
+	// value is only moved from if this returns true
+	bool tryPush(T& value) {
+		size_t position = pushPosition.load(std::memory_order_relaxed);
+		Slot* slot;
+
+		while (true) {
+			slot = &slots[position & mask];
+			size_t sequence = slot->sequence.load(std::memory_order_acquire);
+			intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+
+			if (difference == 0) {
+				if (pushPosition.compare_exchange_weak(position, position + 1,
+				                                       std::memory_order_relaxed)) {
+					break;
+				}
+			} else if (difference < 0) {
+				return false;
+			} else {
+				position = pushPosition.load(std::memory_order_relaxed);
+			}
+		}
+
+		slot->value = std::move(value);
+		slot->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool tryPop(T& value) {
+		size_t position = popPosition.load(std::memory_order_relaxed);
+		Slot* slot;
+
+		while (true) {
+			slot = &slots[position & mask];
+			size_t sequence = slot->sequence.load(std::memory_order_acquire);
+			intptr_t difference =
+			    (intptr_t)sequence - (intptr_t)(position + 1);
+
+			if (difference == 0) {
+				if (popPosition.compare_exchange_weak(position, position + 1,
+				                                      std::memory_order_relaxed)) {
+					break;
+				}
+			} else if (difference < 0) {
+				return false;
+			} else {
+				position = popPosition.load(std::memory_order_relaxed);
+			}
+		}
+
+		value = std::move(slot->value);
+		slot->sequence.store(position + mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Pops the oldest entries until value fits, counting each as dropped
+	void pushDroppingOldest(T& value) {
+		while (!tryPush(value)) {
+			T oldest;
+			if (tryPop(oldest)) {
+				countDropped();
+			}
+		}
+	}
+};
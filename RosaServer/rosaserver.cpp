@@ -1,4 +1,6 @@
 #include "rosaserver.h"
+#include "ffi.h"
+#include "ticktimer.h"
 
 #include <cxxabi.h>
 #include <execinfo.h>
@@ -42,6 +44,33 @@ static int wrapExceptions(lua_State* L, lua_CFunction f) {
 	return lua_error(L);
 }
 
+static int vectorToFloats(const sol::object& object, float* floats) {
+	if (object.is<Vector>()) {
+		std::memcpy(floats, &object.as<Vector&>(), sizeof(Vector));
+		return 3;
+	}
+	if (object.is<RotMatrix>()) {
+		std::memcpy(floats, &object.as<RotMatrix&>(), sizeof(RotMatrix));
+		return 9;
+	}
+	return 0;
+}
+
+static sol::object vectorFromFloats(sol::state_view state, const float* floats,
+                                    int count) {
+	if (count == 3) {
+		Vector vector;
+		std::memcpy(&vector, floats, sizeof(vector));
+		return sol::make_object(state, vector);
+	}
+
+	RotMatrix rot;
+	std::memcpy(&rot, floats, sizeof(rot));
+	return sol::make_object(state, rot);
+}
+
+const Serializer::Codec vectorCodec{vectorToFloats, vectorFromFloats};
+
 void defineThreadSafeAPIs(sol::state* state) {
 	lua_pushlightuserdata(*state, (void*)wrapExceptions);
 	luaJIT_setmode(*state, -1, LUAJIT_MODE_WRAPCFUNC | LUAJIT_MODE_ON);
@@ -60,6 +89,9 @@ void defineThreadSafeAPIs(sol::state* state) {
 	state->open_libraries(sol::lib::ffi);
 	state->open_libraries(sol::lib::jit);
 
+	FFI::defineTypes(state);
+	WorldSnapshot::defineAPI(state);
+
 	{
 		auto meta = state->new_usertype<Vector>("new", sol::no_constructor);
 		meta["x"] = &Vector::x;
@@ -219,53 +251,21 @@ void luaInit(bool redo) {
 	std::lock_guard<std::mutex> guard(stateResetMutex);
 
 	Hooks::run = sol::nil;
+	Hooks::clearHandlers();
 
 	if (redo) {
 		Console::log(LUA_PREFIX "Resetting state...\n");
 		delete server;
 
-		for (int i = 0; i < maxNumberOfAccounts; i++) {
-			if (accountDataTables[i]) {
-				delete accountDataTables[i];
-				accountDataTables[i] = nullptr;
-			}
-		}
-
-		for (int i = 0; i < maxNumberOfPlayers; i++) {
-			if (playerDataTables[i]) {
-				delete playerDataTables[i];
-				playerDataTables[i] = nullptr;
-			}
-		}
-
-		for (int i = 0; i < maxNumberOfHumans; i++) {
-			if (humanDataTables[i]) {
-				delete humanDataTables[i];
-				humanDataTables[i] = nullptr;
-			}
-		}
-
-		for (int i = 0; i < maxNumberOfItems; i++) {
-			if (itemDataTables[i]) {
-				delete itemDataTables[i];
-				itemDataTables[i] = nullptr;
-			}
-		}
-
-		for (int i = 0; i < maxNumberOfVehicles; i++) {
-			if (vehicleDataTables[i]) {
-				delete vehicleDataTables[i];
-				vehicleDataTables[i] = nullptr;
-			}
-		}
-
-		for (int i = 0; i < maxNumberOfRigidBodies; i++) {
-			if (bodyDataTables[i]) {
-				delete bodyDataTables[i];
-				bodyDataTables[i] = nullptr;
-			}
-		}
+		accountDataTables.reset();
+		playerDataTables.reset();
+		humanDataTables.reset();
+		itemDataTables.reset();
+		vehicleDataTables.reset();
+		bodyDataTables.reset();
 
+		Lua::clearProxyCaches();
+		Lua::async::reset();
 		delete lua;
 	} else {
 		Console::log(LUA_PREFIX "Initializing state...\n");
@@ -275,6 +275,7 @@ void luaInit(bool redo) {
 
 	Console::log(LUA_PREFIX "Defining...\n");
 	defineThreadSafeAPIs(lua);
+	FFI::exposeArrays(lua);
 
 	{
 		auto meta = lua->new_usertype<Server>("new", sol::no_constructor);
@@ -371,7 +372,8 @@ void luaInit(bool redo) {
 	{
 		auto meta = lua->new_usertype<Account>("new", sol::no_constructor);
 		meta["subRosaID"] = &Account::subRosaID;
-		meta["phoneNumber"] = &Account::phoneNumber;
+		meta["phoneNumber"] =
+		    sol::property(&Account::getPhoneNumber, &Account::setPhoneNumber);
 		meta["money"] = &Account::money;
 		meta["corporateRating"] = &Account::corporateRating;
 		meta["criminalRating"] = &Account::criminalRating;
@@ -478,7 +480,7 @@ void luaInit(bool redo) {
 		meta["movementState"] = &Human::movementState;
 		meta["zoomLevel"] = &Human::zoomLevel;
 		meta["damage"] = &Human::damage;
-		meta["pos"] = &Human::pos;
+		meta["pos"] = sol::property(&Human::getPos, &Human::setPos);
 		meta["viewYaw"] = &Human::viewYaw;
 		meta["viewPitch"] = &Human::viewPitch;
 		meta["viewYaw2"] = &Human::viewYaw2;
@@ -579,7 +581,7 @@ void luaInit(bool redo) {
 		meta["physicsSettledTimer"] = &Item::physicsSettledTimer;
 		meta["despawnTime"] = &Item::despawnTime;
 		meta["parentSlot"] = &Item::parentSlot;
-		meta["pos"] = &Item::pos;
+		meta["pos"] = sol::property(&Item::getPos, &Item::setPos);
 		meta["vel"] = &Item::vel;
 		meta["rot"] = &Item::rot;
 		meta["bullets"] = &Item::bullets;
@@ -650,7 +652,7 @@ void luaInit(bool redo) {
 		meta["controllableState"] = &Vehicle::controllableState;
 		meta["health"] = &Vehicle::health;
 		meta["color"] = &Vehicle::color;
-		meta["pos"] = &Vehicle::pos;
+		meta["pos"] = sol::property(&Vehicle::getPos, &Vehicle::setPos);
 		meta["pos2"] = &Vehicle::pos2;
 		meta["rot"] = &Vehicle::rot;
 		meta["vel"] = &Vehicle::vel;
@@ -797,16 +799,32 @@ void luaInit(bool redo) {
 		meta["stop"] = &Worker::stop;
 		meta["sendMessage"] = &Worker::sendMessage;
 		meta["receiveMessage"] = &Worker::receiveMessage;
+		meta["hasMessages"] = &Worker::hasMessages;
+		meta["getQueueStats"] = &Worker::getQueueStats;
+	}
+
+	{
+		auto meta = lua->new_usertype<WorkerPool>(
+		    "WorkerPool", sol::constructors<WorkerPool(int)>());
+		meta["stop"] = &WorkerPool::stop;
+		meta["submit"] = &WorkerPool::submit;
+		meta["receiveResult"] = &WorkerPool::receiveResult;
+		meta["getNumDroppedResults"] = &WorkerPool::getNumDroppedResults;
 	}
 
 	{
 		auto meta = lua->new_usertype<ChildProcess>(
-		    "ChildProcess", sol::constructors<ChildProcess(const char*)>());
+		    "ChildProcess", sol::constructors<ChildProcess(const char*),
+		                                      ChildProcess(const char*, size_t)>());
 		meta["isRunning"] = &ChildProcess::isRunning;
 		meta["terminate"] = &ChildProcess::terminate;
 		meta["getExitCode"] = &ChildProcess::getExitCode;
 		meta["receiveMessage"] = &ChildProcess::receiveMessage;
+		meta["receiveMessages"] = &ChildProcess::receiveMessages;
 		meta["sendMessage"] = &ChildProcess::sendMessage;
+		meta["peekString"] = &ChildProcess::peekString;
+		meta["skipMessage"] = &ChildProcess::skipMessage;
+		meta["getQueueStats"] = &ChildProcess::getQueueStats;
 		meta["setCPULimit"] = &ChildProcess::setCPULimit;
 		meta["setMemoryLimit"] = &ChildProcess::setMemoryLimit;
 		meta["setFileSizeLimit"] = &ChildProcess::setFileSizeLimit;
@@ -951,10 +969,51 @@ void luaInit(bool redo) {
 		hookTable["persistentMode"] = hookMode;
 		hookTable["enable"] = Lua::hook::enable;
 		hookTable["disable"] = Lua::hook::disable;
+		hookTable["add"] = sol::overload(Lua::hook::add, Lua::hook::addPriority);
+		hookTable["remove"] = Lua::hook::remove;
 		hookTable["clear"] = Lua::hook::clear;
+		hookTable["getStats"] = Lua::hook::getStats;
+		hookTable["resetStats"] = Lua::hook::resetStats;
+		hookTable["printStats"] = Lua::hook::printStats;
+		hookTable["setUseTrampolines"] = Lua::hook::setUseTrampolines;
 		Lua::hook::clear();
 	}
 
+	{
+		auto tickTimerTable = lua->create_table();
+		(*lua)["tickTimer"] = tickTimerTable;
+		tickTimerTable["budget"] = TickTimer::budgetMicroseconds;
+		tickTimerTable["getPercentiles"] = Lua::tickTimer::getPercentiles;
+		tickTimerTable["getTickCount"] = Lua::tickTimer::getTickCount;
+		tickTimerTable["getOverrunCount"] = Lua::tickTimer::getOverrunCount;
+	}
+
+	{
+		auto changesTable = lua->create_table();
+		(*lua)["changes"] = changesTable;
+		changesTable["watch"] = Lua::changes::watch;
+		changesTable["unwatch"] = Lua::changes::unwatch;
+		changesTable["poll"] = Lua::changes::poll;
+		changesTable["clear"] = Lua::changes::clear;
+		Lua::changes::clear();
+	}
+
+	{
+		auto meta = lua->new_usertype<Future>("new", sol::no_constructor);
+		meta["class"] = sol::property(&Future::getClass);
+		meta["isReady"] = &Future::isReady;
+		meta["get"] = &Future::get;
+		meta["resumeWhenReady"] = &Future::resumeWhenReady;
+	}
+
+	{
+		auto asyncTable = lua->create_table();
+		(*lua)["async"] = asyncTable;
+		asyncTable["run"] = Lua::async::run;
+		asyncTable["await"] =
+		    lua->script(Lua::async::awaitSource).get<sol::function>();
+	}
+
 	{
 		auto physicsTable = lua->create_table();
 		(*lua)["physics"] = physicsTable;
@@ -968,7 +1027,12 @@ void luaInit(bool redo) {
 		physicsTable["lineIntersectVehicleQuick"] =
 		    Lua::physics::lineIntersectVehicleQuick;
 		physicsTable["lineIntersectAnyQuick"] = Lua::physics::lineIntersectAnyQuick;
+		physicsTable["lineIntersectBatch"] =
+		    sol::overload(Lua::physics::lineIntersectBatch,
+		                  Lua::physics::lineIntersectBatchOptions);
 		physicsTable["lineIntersectTriangle"] = Lua::physics::lineIntersectTriangle;
+		physicsTable["markSpatialIndexStale"] =
+		    Lua::physics::markSpatialIndexStale;
 		physicsTable["garbageCollectBullets"] = Lua::physics::garbageCollectBullets;
 		physicsTable["createBlock"] = Lua::physics::createBlock;
 		physicsTable["deleteBlock"] = Lua::physics::deleteBlock;
@@ -1000,7 +1064,9 @@ void luaInit(bool redo) {
 		(*lua)["players"] = playersTable;
 		playersTable["getCount"] = Lua::players::getCount;
 		playersTable["getAll"] = Lua::players::getAll;
+		playersTable["iterActive"] = Lua::players::iterActive;
 		playersTable["getByPhone"] = Lua::players::getByPhone;
+		playersTable["gather"] = Lua::players::gather;
 		playersTable["getNonBots"] = Lua::players::getNonBots;
 		playersTable["getBots"] = Lua::players::getBots;
 		playersTable["createBot"] = Lua::players::createBot;
@@ -1016,6 +1082,12 @@ void luaInit(bool redo) {
 		(*lua)["humans"] = humansTable;
 		humansTable["getCount"] = Lua::humans::getCount;
 		humansTable["getAll"] = Lua::humans::getAll;
+		humansTable["iterActive"] = Lua::humans::iterActive;
+		humansTable["getInRadius"] = Lua::humans::getInRadius;
+		humansTable["getInBox"] = Lua::humans::getInBox;
+		humansTable["getNearest"] = Lua::humans::getNearest;
+		humansTable["gather"] = Lua::humans::gather;
+		humansTable["gatherBones"] = Lua::humans::gatherBones;
 		humansTable["create"] = Lua::humans::create;
 
 		sol::table _meta = lua->create_table();
@@ -1042,6 +1114,11 @@ void luaInit(bool redo) {
 		(*lua)["items"] = itemsTable;
 		itemsTable["getCount"] = Lua::items::getCount;
 		itemsTable["getAll"] = Lua::items::getAll;
+		itemsTable["iterActive"] = Lua::items::iterActive;
+		itemsTable["getInRadius"] = Lua::items::getInRadius;
+		itemsTable["getInBox"] = Lua::items::getInBox;
+		itemsTable["getNearest"] = Lua::items::getNearest;
+		itemsTable["gather"] = Lua::items::gather;
 		itemsTable["create"] =
 		    sol::overload(Lua::items::create, Lua::items::createVel);
 		itemsTable["createRope"] = Lua::items::createRope;
@@ -1070,6 +1147,11 @@ void luaInit(bool redo) {
 		(*lua)["vehicles"] = vehiclesTable;
 		vehiclesTable["getCount"] = Lua::vehicles::getCount;
 		vehiclesTable["getAll"] = Lua::vehicles::getAll;
+		vehiclesTable["iterActive"] = Lua::vehicles::iterActive;
+		vehiclesTable["getInRadius"] = Lua::vehicles::getInRadius;
+		vehiclesTable["getInBox"] = Lua::vehicles::getInBox;
+		vehiclesTable["getNearest"] = Lua::vehicles::getNearest;
+		vehiclesTable["gather"] = Lua::vehicles::gather;
 		vehiclesTable["create"] =
 		    sol::overload(Lua::vehicles::create, Lua::vehicles::createVel);
 
@@ -1084,6 +1166,7 @@ void luaInit(bool redo) {
 		(*lua)["bullets"] = bulletsTable;
 		bulletsTable["getCount"] = Lua::bullets::getCount;
 		bulletsTable["getAll"] = Lua::bullets::getAll;
+		bulletsTable["gather"] = Lua::bullets::gather;
 		bulletsTable["create"] = Lua::bullets::create;
 	}
 
@@ -1092,6 +1175,7 @@ void luaInit(bool redo) {
 		(*lua)["rigidBodies"] = rigidBodiesTable;
 		rigidBodiesTable["getCount"] = Lua::rigidBodies::getCount;
 		rigidBodiesTable["getAll"] = Lua::rigidBodies::getAll;
+		rigidBodiesTable["iterActive"] = Lua::rigidBodies::iterActive;
 
 		sol::table _meta = lua->create_table();
 		rigidBodiesTable[sol::metatable_key] = _meta;
@@ -1244,7 +1328,8 @@ void luaInit(bool redo) {
 			Hooks::run = (*lua)["hook"]["run"];
 			Console::log(LUA_PREFIX "No problems!\n");
 			if (Hooks::run == sol::nil) {
-				Console::log(LUA_PREFIX "To use hooks, define hook.run!\n");
+				Console::log(LUA_PREFIX
+				             "To use hooks, define hook.run or call hook.add!\n");
 			}
 		}
 	}
@@ -1531,6 +1616,10 @@ static inline void installHooks() {
 	INSTALL(createEventBulletHit);
 	INSTALL(lineIntersectHuman);
 	INSTALL(lineIntersectLevel);
+
+	// Every hook is installed once above so failures show up at boot, but most
+	// only stay in place while a script has their key enabled
+	Hooks::removeDisabledHooks();
 }
 
 static inline void attachInterruptSignalHandler() {
@@ -20,4 +20,6 @@
 #include "server.h"
 #include "sqlite.h"
 #include "worker.h"
+#include "workerpool.h"
+#include "worldsnapshot.h"
 #include "zlib.h"
\ No newline at end of file
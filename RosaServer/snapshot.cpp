@@ -0,0 +1,146 @@
+#include "snapshot.h"
+
+#include <cstring>
+#include "activeset.h"
+#include "engine.h"
+
+namespace Snapshot {
+using ChangeFeed::Field;
+
+#define FIELD(type, name, fieldType) \
+	{ #name, offsetof(type, name), ChangeFeed::fieldType }
+
+static const Field bulletFields[] = {
+    FIELD(Bullet, type, UnsignedInt),
+    FIELD(Bullet, time, Int),
+    FIELD(Bullet, playerID, Int),
+    FIELD(Bullet, lastPos, VectorValue),
+    FIELD(Bullet, pos, VectorValue),
+    FIELD(Bullet, vel, VectorValue),
+};
+
+static const Field boneFields[] = {
+    FIELD(Bone, bodyID, Int),
+    FIELD(Bone, pos, VectorValue),
+    FIELD(Bone, pos2, VectorValue),
+    FIELD(Bone, vel, VectorValue),
+};
+
+#undef FIELD
+
+template <size_t size>
+static const Field* findIn(const Field (&fields)[size], const char* name) {
+	for (const Field& field : fields) {
+		if (!std::strcmp(field.name, name)) {
+			return &field;
+		}
+	}
+	return nullptr;
+}
+
+const Field* findBulletField(const char* name) {
+	return findIn(bulletFields, name);
+}
+
+const Field* findBoneField(const char* name) {
+	return findIn(boneFields, name);
+}
+
+static size_t getSize(const Field* field) {
+	return field->type == ChangeFeed::VectorValue ? sizeof(Vector) : sizeof(int);
+}
+
+static size_t getFieldsSize(const Layout& layout) {
+	size_t size = 0;
+	for (const Field* field : layout) {
+		size += getSize(field);
+	}
+	return size;
+}
+
+// Engine values are all 32 bits wide, so fields are copied as they are
+static char* writeFields(char* out, const void* object, const Layout& layout) {
+	const char* base = static_cast<const char*>(object);
+	for (const Field* field : layout) {
+		std::memcpy(out, base + field->offset, getSize(field));
+		out += getSize(field);
+	}
+	return out;
+}
+
+static char* writeIndex(char* out, int index) {
+	std::memcpy(out, &index, sizeof(index));
+	return out + sizeof(index);
+}
+
+template <typename T, int capacity, typename Write>
+static int gatherActive(const ActiveSet<capacity>& set, T* array,
+                        size_t recordSize, std::string& buffer,
+                        Write&& write) {
+	buffer.resize(set.size() * recordSize);
+	char* out = &buffer[0];
+	int count = 0;
+
+	set.forEach([&](int index) {
+		if (!array[index].active) {
+			return;
+		}
+		out = write(writeIndex(out, index), array[index]);
+		count++;
+	});
+
+	buffer.resize(count * recordSize);
+	return count;
+}
+
+template <typename T, int capacity>
+static int gatherFields(const ActiveSet<capacity>& set, T* array,
+                        const Layout& layout, std::string& buffer) {
+	auto write = [&](char* out, const T& object) {
+		return writeFields(out, &object, layout);
+	};
+	return gatherActive(set, array, sizeof(int) + getFieldsSize(layout), buffer,
+	                    write);
+}
+
+int gather(ChangeFeed::Kind kind, const Layout& layout, std::string& buffer) {
+	switch (kind) {
+		case ChangeFeed::Players:
+			return gatherFields(ActiveSets::players, Engine::players, layout,
+			                    buffer);
+		case ChangeFeed::Humans:
+			return gatherFields(ActiveSets::humans, Engine::humans, layout, buffer);
+		case ChangeFeed::Items:
+			return gatherFields(ActiveSets::items, Engine::items, layout, buffer);
+		default:
+			return gatherFields(ActiveSets::vehicles, Engine::vehicles, layout,
+			                    buffer);
+	}
+}
+
+int gatherBullets(const Layout& layout, std::string& buffer) {
+	int count = *Engine::numBullets;
+	size_t recordSize = sizeof(int) + getFieldsSize(layout);
+
+	buffer.resize(count * recordSize);
+	char* out = &buffer[0];
+	for (int i = 0; i < count; i++) {
+		out = writeFields(writeIndex(out, i), &Engine::bullets[i], layout);
+	}
+	return count;
+}
+
+int gatherBones(const Layout& layout, std::string& buffer) {
+	constexpr int numBones = sizeof(Human::bones) / sizeof(Bone);
+	size_t recordSize = sizeof(int) + getFieldsSize(layout) * numBones;
+
+	auto write = [&](char* out, const Human& man) {
+		for (const Bone& bone : man.bones) {
+			out = writeFields(out, &bone, layout);
+		}
+		return out;
+	};
+	return gatherActive(ActiveSets::humans, Engine::humans, recordSize, buffer,
+	                    write);
+}
+};  // namespace Snapshot
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "changefeed.h"
+
+// Packs chosen fields of many objects into one buffer of 32-bit values, so a
+// whole tick can be read or sent on in one go. Each record is the object's
+// index followed by its fields in the order asked for, vectors taking three
+// floats.
+namespace Snapshot {
+using Layout = std::vector<const ChangeFeed::Field*>;
+
+// nullptr if there is no field by that name
+const ChangeFeed::Field* findBulletField(const char* name);
+const ChangeFeed::Field* findBoneField(const char* name);
+
+// Each overwrites buffer and returns the number of records in it.
+int gather(ChangeFeed::Kind kind, const Layout& layout, std::string& buffer);
+int gatherBullets(const Layout& layout, std::string& buffer);
+// One record per active human, holding the fields of all 16 bones in order.
+int gatherBones(const Layout& layout, std::string& buffer);
+};  // namespace Snapshot
@@ -0,0 +1,80 @@
+#include "spatialgrid.h"
+#include <algorithm>
+
+SpatialGrid::SpatialGrid(float cellSize, int maxObjects)
+    : cellSize(cellSize), bounds(maxObjects), visitedStamps(maxObjects, 0) {
+	clear();
+}
+
+unsigned int SpatialGrid::nextStamp() {
+	if (++currentStamp == 0) {
+		std::fill(visitedStamps.begin(), visitedStamps.end(), 0);
+		currentStamp = 1;
+	}
+	return currentStamp;
+}
+
+void SpatialGrid::clear() {
+	// Keeps the allocations of cells used by the last build around for the
+	// next one, and drops the rest so cells don't pile up as objects move
+	for (auto it = cells.begin(); it != cells.end();) {
+		if (it->second.empty()) {
+			it = cells.erase(it);
+		} else {
+			it->second.clear();
+			++it;
+		}
+	}
+
+	minCellX = minCellZ = INT_MAX;
+	maxCellX = maxCellZ = INT_MIN;
+}
+
+bool SpatialGrid::toCellRange(float min, float max, int occupiedMin,
+                              int occupiedMax, int& first, int& last) const {
+	if (!(min <= max) || occupiedMin > occupiedMax) {
+		return false;
+	}
+
+	// Clamped like toCell, so positions past maxWalkCell still find each other
+	auto clampCell = [](float cell) {
+		return std::min(std::max(cell, -maxWalkCell), maxWalkCell);
+	};
+	float low = std::max(clampCell(min / cellSize),
+	                     static_cast<float>(occupiedMin));
+	// The last cell reaches up to the start of the one after it
+	float high = std::min(clampCell(max / cellSize),
+	                      static_cast<float>(occupiedMax) + 1.f);
+	if (!(low <= high)) {
+		return false;
+	}
+
+	first = std::max(static_cast<int>(std::floor(low)), occupiedMin);
+	last = std::min(static_cast<int>(std::floor(high)), occupiedMax);
+	return first <= last;
+}
+
+void SpatialGrid::insert(int id, const Vector& center, float radius) {
+	if (!std::isfinite(center.x) || !std::isfinite(center.y) ||
+	    !std::isfinite(center.z) || !std::isfinite(radius)) {
+		return;
+	}
+
+	bounds[id] = {center, radius};
+
+	int minX = toCell(center.x - radius);
+	int maxX = toCell(center.x + radius);
+	int minZ = toCell(center.z - radius);
+	int maxZ = toCell(center.z + radius);
+
+	minCellX = std::min(minCellX, minX);
+	maxCellX = std::max(maxCellX, maxX);
+	minCellZ = std::min(minCellZ, minZ);
+	maxCellZ = std::max(maxCellZ, maxZ);
+
+	for (int cellX = minX; cellX <= maxX; cellX++) {
+		for (int cellZ = minZ; cellZ <= maxZ; cellZ++) {
+			cells[cellKey(cellX, cellZ)].push_back(id);
+		}
+	}
+}
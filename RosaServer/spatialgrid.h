@@ -0,0 +1,259 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <climits>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "structs.h"
+
+// Uniform grid over the horizontal plane holding objects by their bounding
+// sphere. Each object is added to every cell its sphere overlaps, so queries
+// only have to look at the cells they touch.
+class SpatialGrid {
+	struct Bounds {
+		Vector center;
+		float radius;
+	};
+
+	// Cells farther out than this aren't walked, and positions past it share
+	// the outermost cells, so toCell can't overflow
+	static constexpr float maxWalkCell = 1e8f;
+
+	float cellSize;
+	std::unordered_map<int64_t, std::vector<int>> cells;
+	std::vector<Bounds> bounds;
+	// Stops an object spanning several cells being visited more than once
+	std::vector<unsigned int> visitedStamps;
+	unsigned int currentStamp = 0;
+	// Cells holding anything since the last clear
+	int minCellX, maxCellX, minCellZ, maxCellZ;
+
+	// Coordinate must not be NaN
+	int toCell(float coordinate) const {
+		return static_cast<int>(std::min(
+		    std::max(std::floor(coordinate / cellSize), -maxWalkCell),
+		    maxWalkCell));
+	}
+	static int64_t cellKey(int cellX, int cellZ) {
+		return static_cast<int64_t>(static_cast<uint64_t>(cellX) << 32) ^
+		       static_cast<uint32_t>(cellZ);
+	}
+	unsigned int nextStamp();
+	// Narrows min to max down to the occupied cells along one axis. Returns
+	// false if nothing is left, which includes NaN bounds, so infinite or huge
+	// bounds never reach toCell.
+	bool toCellRange(float min, float max, int occupiedMin, int occupiedMax,
+	                 int& first, int& last) const;
+	template <typename Callback>
+	void visitCell(int cellX, int cellZ, Callback& callback);
+	// Visits every cell between the corners, or every occupied cell when that
+	// is fewer lookups
+	template <typename Callback>
+	void visitRange(int firstX, int lastX, int firstZ, int lastZ,
+	                Callback& callback);
+
+ public:
+	SpatialGrid(float cellSize, int maxObjects);
+	void clear();
+	// Objects with a NaN or infinite center or radius aren't added
+	void insert(int id, const Vector& center, float radius);
+	// Calls callback(id) for each object whose sphere, grown by padding, may
+	// touch the segment from a to b.
+	template <typename Callback>
+	void forEachAlongSegment(const Vector& a, const Vector& b, float padding,
+	                         Callback&& callback);
+	// Calls callback(id) for each object whose sphere may be within radius of
+	// center.
+	template <typename Callback>
+	void forEachNear(const Vector& center, float radius, Callback&& callback);
+	// Calls callback(id) for each object whose sphere may overlap the box
+	// between min and max.
+	template <typename Callback>
+	void forEachInBox(const Vector& min, const Vector& max, Callback&& callback);
+};
+
+template <typename Callback>
+void SpatialGrid::visitCell(int cellX, int cellZ, Callback& callback) {
+	auto search = cells.find(cellKey(cellX, cellZ));
+	if (search == cells.end()) {
+		return;
+	}
+
+	for (int id : search->second) {
+		if (visitedStamps[id] != currentStamp) {
+			visitedStamps[id] = currentStamp;
+			callback(id);
+		}
+	}
+}
+
+template <typename Callback>
+void SpatialGrid::visitRange(int firstX, int lastX, int firstZ, int lastZ,
+                             Callback& callback) {
+	int64_t numCells = (static_cast<int64_t>(lastX) - firstX + 1) *
+	                   (static_cast<int64_t>(lastZ) - firstZ + 1);
+	if (numCells > static_cast<int64_t>(cells.size())) {
+		for (auto& cell : cells) {
+			int cellX = static_cast<int>(cell.first >> 32);
+			int cellZ = static_cast<int32_t>(cell.first);
+			if (cellX >= firstX && cellX <= lastX && cellZ >= firstZ &&
+			    cellZ <= lastZ) {
+				visitCell(cellX, cellZ, callback);
+			}
+		}
+		return;
+	}
+
+	for (int cellX = firstX; cellX <= lastX; cellX++) {
+		for (int cellZ = firstZ; cellZ <= lastZ; cellZ++) {
+			visitCell(cellX, cellZ, callback);
+		}
+	}
+}
+
+template <typename Callback>
+void SpatialGrid::forEachAlongSegment(const Vector& a, const Vector& b,
+                                      float padding, Callback&& callback) {
+	nextStamp();
+
+	float dx = b.x - a.x;
+	float dz = b.z - a.z;
+	float lengthSquare = dx * dx + dz * dz;
+
+	auto test = [&](int id) {
+		// Distance from the sphere to the segment, in 3D
+		const Bounds& object = bounds[id];
+		float ex = b.x - a.x, ey = b.y - a.y, ez = b.z - a.z;
+		float ox = object.center.x - a.x, oy = object.center.y - a.y,
+		      oz = object.center.z - a.z;
+		float segmentSquare = ex * ex + ey * ey + ez * ez;
+		float t = segmentSquare > 0.f
+		              ? (ox * ex + oy * ey + oz * ez) / segmentSquare
+		              : 0.f;
+		t = t < 0.f ? 0.f : (t > 1.f ? 1.f : t);
+		float px = ox - ex * t, py = oy - ey * t, pz = oz - ez * t;
+		float reach = object.radius + padding;
+		if (px * px + py * py + pz * pz <= reach * reach) {
+			callback(id);
+		}
+	};
+
+	int firstX, lastX, firstZ, lastZ;
+	if (!toCellRange(std::min(a.x, b.x) - padding, std::max(a.x, b.x) + padding,
+	                 minCellX, maxCellX, firstX, lastX) ||
+	    !toCellRange(std::min(a.z, b.z) - padding, std::max(a.z, b.z) + padding,
+	                 minCellZ, maxCellZ, firstZ, lastZ)) {
+		return;
+	}
+
+	// Walking costs a lookup per crossed cell and its neighbours. Segments
+	// where that is more than there are occupied cells, or too far out for
+	// toCell, check the occupied cells within their bounds instead.
+	float ringCells = std::ceil(padding / cellSize);
+	float walkCells = ((std::abs(dx) + std::abs(dz)) / cellSize + 1.f) *
+	                  (2.f * ringCells + 1.f) * (2.f * ringCells + 1.f);
+	float farthest = std::max(std::max(std::abs(a.x), std::abs(a.z)),
+	                          std::max(std::abs(b.x), std::abs(b.z)));
+	if (!(walkCells <= static_cast<float>(cells.size())) ||
+	    !(farthest / cellSize < maxWalkCell)) {
+		visitRange(firstX, lastX, firstZ, lastZ, test);
+		return;
+	}
+
+	// Cells next to the ones crossed are visited too when the padding reaches
+	// into them
+	int ring = static_cast<int>(ringCells);
+	auto visit = [&](int cellX, int cellZ) {
+		for (int offsetX = -ring; offsetX <= ring; offsetX++) {
+			for (int offsetZ = -ring; offsetZ <= ring; offsetZ++) {
+				visitCell(cellX + offsetX, cellZ + offsetZ, test);
+			}
+		}
+	};
+
+	int cellX = toCell(a.x);
+	int cellZ = toCell(a.z);
+	int endX = toCell(b.x);
+	int endZ = toCell(b.z);
+
+	if (lengthSquare == 0.f) {
+		visit(cellX, cellZ);
+		return;
+	}
+
+	// Walk the crossed cells in order (Amanatides & Woo)
+	int stepX = dx > 0.f ? 1 : -1;
+	int stepZ = dz > 0.f ? 1 : -1;
+	float tDeltaX = dx != 0.f ? cellSize / std::abs(dx) : INFINITY;
+	float tDeltaZ = dz != 0.f ? cellSize / std::abs(dz) : INFINITY;
+	float tMaxX = dx != 0.f
+	                  ? ((cellX + (stepX > 0)) * cellSize - a.x) / dx
+	                  : INFINITY;
+	float tMaxZ = dz != 0.f
+	                  ? ((cellZ + (stepZ > 0)) * cellSize - a.z) / dz
+	                  : INFINITY;
+
+	int steps = std::abs(endX - cellX) + std::abs(endZ - cellZ);
+	visit(cellX, cellZ);
+	for (int i = 0; i < steps; i++) {
+		if (tMaxX < tMaxZ) {
+			cellX += stepX;
+			tMaxX += tDeltaX;
+		} else {
+			cellZ += stepZ;
+			tMaxZ += tDeltaZ;
+		}
+		visit(cellX, cellZ);
+	}
+}
+
+template <typename Callback>
+void SpatialGrid::forEachNear(const Vector& center, float radius,
+                              Callback&& callback) {
+	nextStamp();
+
+	auto test = [&](int id) {
+		const Bounds& object = bounds[id];
+		float dx = object.center.x - center.x;
+		float dy = object.center.y - center.y;
+		float dz = object.center.z - center.z;
+		float reach = object.radius + radius;
+		if (dx * dx + dy * dy + dz * dz <= reach * reach) {
+			callback(id);
+		}
+	};
+
+	int firstX, lastX, firstZ, lastZ;
+	if (toCellRange(center.x - radius, center.x + radius, minCellX, maxCellX,
+	                firstX, lastX) &&
+	    toCellRange(center.z - radius, center.z + radius, minCellZ, maxCellZ,
+	                firstZ, lastZ)) {
+		visitRange(firstX, lastX, firstZ, lastZ, test);
+	}
+}
+
+template <typename Callback>
+void SpatialGrid::forEachInBox(const Vector& min, const Vector& max,
+                               Callback&& callback) {
+	nextStamp();
+
+	auto test = [&](int id) {
+		const Bounds& object = bounds[id];
+		float dx = std::max(min.x - object.center.x,
+		                    std::max(0.f, object.center.x - max.x));
+		float dy = std::max(min.y - object.center.y,
+		                    std::max(0.f, object.center.y - max.y));
+		float dz = std::max(min.z - object.center.z,
+		                    std::max(0.f, object.center.z - max.z));
+		if (dx * dx + dy * dy + dz * dz <= object.radius * object.radius) {
+			callback(id);
+		}
+	};
+
+	int firstX, lastX, firstZ, lastZ;
+	if (toCellRange(min.x, max.x, minCellX, maxCellX, firstX, lastX) &&
+	    toCellRange(min.z, max.z, minCellZ, maxCellZ, firstZ, lastZ)) {
+		visitRange(firstX, lastX, firstZ, lastZ, test);
+	}
+}
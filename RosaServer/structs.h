@@ -104,9 +104,11 @@ struct Account {
 	const char* getClass() const { return "Account"; }
 	std::string __tostring() const;
 	int getIndex() const;
-	sol::table getDataTable() const;
+	sol::stack_table getDataTable(sol::this_state s) const;
 	char* getName() { return name; }
 	std::string getSteamID() { return std::to_string(steamID); }
+	int getPhoneNumber() const { return phoneNumber; }
+	void setPhoneNumber(int phone);
 };
 
 struct RotMatrix;
@@ -150,6 +152,75 @@ struct RotMatrix {
 	Vector getRight() const;
 };
 
+namespace FFI {
+// LuaJIT's type tag for cdata, which lua.h doesn't define
+static constexpr int luaTypeCData = 10;
+
+// Address of a Vector or RotMatrix cdata (or a reference or pointer to one),
+// nullptr if the value is something else.
+void* toPointer(lua_State* L, int index, const char* type);
+
+template <typename T, typename Handler>
+inline bool checkPointer(lua_State* L, int index, const char* type,
+                         Handler&& handler, sol::stack::record& tracking) {
+	if (lua_type(L, index) == luaTypeCData) {
+		tracking.use(1);
+		if (toPointer(L, index, type)) {
+			return true;
+		}
+		handler(L, index, sol::type::userdata, sol::type_of(L, index),
+		        "cdata of the wrong type");
+		return false;
+	}
+	if (lua_isnil(L, index)) {
+		tracking.use(1);
+		return true;
+	}
+	return sol::stack::check_usertype<T*>(
+	    L, index, std::forward<Handler>(handler), tracking);
+}
+
+template <typename T>
+inline T* getPointer(lua_State* L, int index, const char* type,
+                     sol::stack::record& tracking) {
+	if (lua_type(L, index) == luaTypeCData) {
+		tracking.use(1);
+		return static_cast<T*>(toPointer(L, index, type));
+	}
+	if (lua_isnil(L, index)) {
+		tracking.use(1);
+		return nullptr;
+	}
+	return sol::stack::get_usertype<T*>(L, index, tracking);
+}
+};  // namespace FFI
+
+// Let APIs taking a Vector* or RotMatrix* be passed FFI cdata as well as
+// usertypes
+template <typename Handler>
+inline bool sol_lua_check(sol::types<Vector*>, lua_State* L, int index,
+                          Handler&& handler, sol::stack::record& tracking) {
+	return FFI::checkPointer<Vector>(L, index, "Vector",
+	                                 std::forward<Handler>(handler), tracking);
+}
+
+inline Vector* sol_lua_get(sol::types<Vector*>, lua_State* L, int index,
+                           sol::stack::record& tracking) {
+	return FFI::getPointer<Vector>(L, index, "Vector", tracking);
+}
+
+template <typename Handler>
+inline bool sol_lua_check(sol::types<RotMatrix*>, lua_State* L, int index,
+                          Handler&& handler, sol::stack::record& tracking) {
+	return FFI::checkPointer<RotMatrix>(L, index, "RotMatrix",
+	                                    std::forward<Handler>(handler), tracking);
+}
+
+inline RotMatrix* sol_lua_get(sol::types<RotMatrix*>, lua_State* L, int index,
+                              sol::stack::record& tracking) {
+	return FFI::getPointer<RotMatrix>(L, index, "RotMatrix", tracking);
+}
+
 struct LineIntersectResult {
 	Vector pos;
 	Vector normal;    // 0c
@@ -311,7 +382,7 @@ struct Player {
 	int getIndex() const;
 	bool getIsActive() const { return active; }
 	void setIsActive(bool b) { active = b; }
-	sol::table getDataTable() const;
+	sol::stack_table getDataTable(sol::this_state s) const;
 	char* getName() { return name; }
 	void setName(const char* newName) {
 		std::strncpy(name, newName, sizeof(name) - 1);
@@ -489,7 +560,9 @@ struct Human {
 	int getIndex() const;
 	bool getIsActive() const { return active; }
 	void setIsActive(bool b) { active = b; }
-	sol::table getDataTable() const;
+	Vector* getPos() { return &pos; }
+	void setPos(Vector* vec);
+	sol::stack_table getDataTable(sol::this_state s) const;
 	bool getIsAlive() const { return oldHealth > 0; }
 	void setIsAlive(bool b) { oldHealth = b ? 100 : 0; }
 	bool getIsImmortal() const { return isImmortal; }
@@ -631,7 +704,9 @@ struct Item {
 	int getIndex() const;
 	bool getIsActive() const { return active; }
 	void setIsActive(bool b) { active = b; }
-	sol::table getDataTable() const;
+	Vector* getPos() { return &pos; }
+	void setPos(Vector* vec);
+	sol::stack_table getDataTable(sol::this_state s) const;
 	bool getHasPhysics() const { return physicsSim; }
 	void setHasPhysics(bool b) { physicsSim = b; }
 	bool getPhysicsSettled() const { return physicsSettled; }
@@ -731,11 +806,13 @@ struct Vehicle {
 	int getIndex() const;
 	bool getIsActive() const { return active; }
 	void setIsActive(bool b) { active = b; }
+	Vector* getPos() { return &pos; }
+	void setPos(Vector* vec);
 	VehicleType* getType();
 	void setType(VehicleType* vehicleType);
 	bool getIsLocked() const { return isLocked; }
 	void setIsLocked(bool b) { isLocked = b; }
-	sol::table getDataTable() const;
+	sol::stack_table getDataTable(sol::this_state s) const;
 	Player* getLastDriver() const;
 	RigidBody* getRigidBody() const;
 	TrafficCar* getTrafficCar() const;
@@ -791,7 +868,7 @@ struct RigidBody {
 	int getIndex() const;
 	bool getIsActive() const { return active; }
 	void setIsActive(bool b) { active = b; }
-	sol::table getDataTable() const;
+	sol::stack_table getDataTable(sol::this_state s) const;
 	bool getIsSettled() const { return settled; }
 	void setIsSettled(bool b) { settled = b; }
 	Bond* bondTo(RigidBody* other, Vector* thisLocalPos,
@@ -981,4 +1058,32 @@ struct Event {
 	void setMessage(const char* newMessage) {
 		std::strncpy(message, newMessage, sizeof(message) - 1);
 	}
-};
\ No newline at end of file
+};
+
+// Checked against the sizes in the comments above, which the FFI definitions
+// in ffi.cpp are in turn checked against at runtime
+static_assert(sizeof(EarShot) == 40, "EarShot is the wrong size");
+static_assert(sizeof(Connection) == 188896, "Connection is the wrong size");
+static_assert(sizeof(Account) == 112, "Account is the wrong size");
+static_assert(sizeof(Action) == 84, "Action is the wrong size");
+static_assert(sizeof(MenuButton) == 72, "MenuButton is the wrong size");
+static_assert(sizeof(Voice) == 131604, "Voice is the wrong size");
+static_assert(sizeof(Player) == 14388, "Player is the wrong size");
+static_assert(sizeof(Bone) == 312, "Bone is the wrong size");
+static_assert(sizeof(InventorySlot) == 40, "InventorySlot is the wrong size");
+static_assert(sizeof(Human) == 28664, "Human is the wrong size");
+static_assert(sizeof(ItemType) == 5072, "ItemType is the wrong size");
+static_assert(sizeof(Item) == 7040, "Item is the wrong size");
+static_assert(sizeof(VehicleType) == 99776, "VehicleType is the wrong size");
+static_assert(sizeof(Vehicle) == 20840, "Vehicle is the wrong size");
+static_assert(sizeof(Bullet) == 92, "Bullet is the wrong size");
+static_assert(sizeof(RigidBody) == 188, "RigidBody is the wrong size");
+static_assert(sizeof(Bond) == 244, "Bond is the wrong size");
+static_assert(sizeof(StreetLane) == 28, "StreetLane is the wrong size");
+static_assert(sizeof(Street) == 1584, "Street is the wrong size");
+static_assert(sizeof(StreetIntersection) == 136,
+              "StreetIntersection is the wrong size");
+static_assert(sizeof(TrafficCar) == 1532, "TrafficCar is the wrong size");
+static_assert(sizeof(ShopCar) == 12, "ShopCar is the wrong size");
+static_assert(sizeof(Building) == 56076, "Building is the wrong size");
+static_assert(sizeof(Event) == 128, "Event is the wrong size");
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "ticktimer.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace TickTimer {
+const char* const sectionNames[Section::SIZE] = {
+    "ServerReceive", "Logic",       "Gamemode", "Traffic",
+    "Physics",       "RigidBodies", "Bullets",  "ServerSend"};
+
+std::atomic<unsigned long long> tickCount = 0;
+std::atomic<unsigned long long> overrunCount = 0;
+
+// Only written by the main thread; readers copy it out and throw away
+// whatever was overwritten while they were copying.
+static Tick history[historySize];
+
+static Tick current;
+static bool inTick = false;
+static std::chrono::steady_clock::time_point tickStart;
+
+void beginSection(std::chrono::steady_clock::time_point start) {
+	if (!inTick) {
+		inTick = true;
+		tickStart = start;
+	}
+}
+
+void endSection(Section section, std::chrono::steady_clock::duration time) {
+	current.sections[section] +=
+	    std::chrono::duration<float, std::micro>(time).count();
+}
+
+float endTick() {
+	if (!inTick) {
+		return 0.f;
+	}
+
+	current.total = std::chrono::duration<float, std::micro>(
+	                    std::chrono::steady_clock::now() - tickStart)
+	                    .count();
+
+	auto index = tickCount.load(std::memory_order_relaxed);
+	history[index % historySize] = current;
+	tickCount.store(index + 1, std::memory_order_release);
+
+	if (current.total > budgetMicroseconds) {
+		overrunCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	float total = current.total;
+	current = {};
+	inTick = false;
+	return total;
+}
+
+size_t getHistory(Tick* out) {
+	auto end = tickCount.load(std::memory_order_acquire);
+	auto begin = end > historySize ? end - historySize : 0;
+
+	for (auto i = begin; i < end; i++) {
+		out[i - begin] = history[i % historySize];
+	}
+
+	// The tick being written as we finished reading may have replaced the
+	// oldest ones
+	auto endAfter = tickCount.load(std::memory_order_acquire);
+	auto firstValid = endAfter + 1 > historySize ? endAfter + 1 - historySize : 0;
+	if (firstValid > begin) {
+		auto stale = std::min(firstValid, end) - begin;
+		std::copy(out + stale, out + (end - begin), out);
+		begin += stale;
+	}
+
+	return end - begin;
+}
+
+static Percentiles percentilesOf(std::vector<float>& values) {
+	if (values.empty()) {
+		return {0.f, 0.f, 0.f};
+	}
+
+	auto at = [&values](float fraction) {
+		auto nth = values.begin() + std::min(values.size() - 1,
+		                                     (size_t)(fraction * values.size()));
+		std::nth_element(values.begin(), nth, values.end());
+		return *nth;
+	};
+
+	return {at(0.5f), at(0.95f), at(0.99f)};
+}
+
+void getPercentiles(Percentiles (&sections)[Section::SIZE],
+                    Percentiles& total) {
+	static Tick ticks[historySize];
+	size_t count = getHistory(ticks);
+
+	std::vector<float> values(count);
+
+	for (int section = 0; section < Section::SIZE; section++) {
+		for (size_t i = 0; i < count; i++) {
+			values[i] = ticks[i].sections[section];
+		}
+		sections[section] = percentilesOf(values);
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		values[i] = ticks[i].total;
+	}
+	total = percentilesOf(values);
+}
+};  // namespace TickTimer
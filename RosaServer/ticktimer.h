@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+namespace TickTimer {
+// Engine phases which are timed every tick. Times are inclusive, so Logic
+// also contains Gamemode and Traffic, and Physics contains RigidBodies and
+// Bullets.
+enum Section {
+	ServerReceive,
+	Logic,
+	Gamemode,
+	Traffic,
+	Physics,
+	RigidBodies,
+	Bullets,
+	ServerSend,
+	SIZE
+};
+
+extern const char* const sectionNames[Section::SIZE];
+
+// One tick at Server.TPS = 60
+constexpr float budgetMicroseconds = 1'000'000.f / 60.f;
+constexpr size_t historySize = 512;
+
+struct Tick {
+	float sections[Section::SIZE];
+	float total;
+};
+
+struct Percentiles {
+	float p50, p95, p99;
+};
+
+// Total ticks recorded, which is also the write position of the history, and
+// how many of them went over budget
+extern std::atomic<unsigned long long> tickCount;
+extern std::atomic<unsigned long long> overrunCount;
+
+void beginSection(std::chrono::steady_clock::time_point start);
+void endSection(Section section, std::chrono::steady_clock::duration time);
+// Closes the current tick, returns its total time in microseconds.
+float endTick();
+
+// Copies up to historySize of the most recent ticks, newest last.
+size_t getHistory(Tick* out);
+void getPercentiles(Percentiles (&sections)[Section::SIZE],
+                    Percentiles& total);
+
+class ScopedSection {
+	Section section;
+	std::chrono::steady_clock::time_point start;
+
+ public:
+	ScopedSection(Section section)
+	    : section(section), start(std::chrono::steady_clock::now()) {
+		beginSection(start);
+	}
+	~ScopedSection() {
+		endSection(section, std::chrono::steady_clock::now() - start);
+	}
+};
+};  // namespace TickTimer
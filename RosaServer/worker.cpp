@@ -4,46 +4,150 @@
 #include <iostream>
 #include <thread>
 
-Worker::Worker(std::string fileName) {
-	stopped = new std::atomic_bool(false);
+static constexpr size_t queueCapacity = 2048;
+// How long the main thread waits in block mode unless told otherwise
+static constexpr unsigned int blockTimeoutMs = 100;
+
+// What to do with a message when the queue it goes into is full
+enum class OverflowMode { DropOldest, Fail, Block };
+
+static OverflowMode toOverflowMode(sol::optional<std::string> mode) {
+	if (!mode || *mode == "dropOldest") return OverflowMode::DropOldest;
+	if (*mode == "fail") return OverflowMode::Fail;
+	if (*mode == "block") return OverflowMode::Block;
+	throw std::invalid_argument("Unknown overflow mode");
+}
+
+// In block mode, wait() is called until the message fits or it returns true to
+// give up, after which the queue must not be touched again
+template <typename Wait>
+static bool pushMessage(MessageQueue<std::string>& queue,
+                        const sol::object& value,
+                        sol::optional<std::string> mode, Wait&& wait) {
+	OverflowMode overflowMode = toOverflowMode(mode);
+
+	std::string message;
+	Serializer::serialize(value, message, &vectorCodec);
+
+	switch (overflowMode) {
+		case OverflowMode::DropOldest:
+			queue.pushDroppingOldest(message);
+			return true;
+		case OverflowMode::Fail:
+			if (queue.tryPush(message)) return true;
+			queue.countDropped();
+			return false;
+		default:
+			while (!queue.tryPush(message)) {
+				if (wait()) return false;
+			}
+			return true;
+	}
+}
+
+static sol::object popMessage(MessageQueue<std::string>& queue,
+                              sol::this_state s) {
+	sol::state_view state(s);
+
+	std::string message;
+	if (!queue.tryPop(message)) {
+		return sol::make_object(state, sol::nil);
+	}
 
-	std::thread thread(&Worker::runThread, this, fileName);
+	return Serializer::deserialize(state, message, &vectorCodec);
+}
+
+Worker::Worker(std::string fileName)
+    : sendMessageQueue(queueCapacity), receiveMessageQueue(queueCapacity) {
+	std::thread thread(&Worker::runThread, this, fileName, signal);
 	thread.detach();
 }
 
 Worker::~Worker() {
-	std::lock_guard<std::mutex> guard(destructionMutex);
+	std::lock_guard<std::mutex> guard(signal->destructionMutex);
 	stop();
 }
 
-void Worker::runThread(std::string fileName) {
-	std::atomic_bool* _stopped = stopped;
+void Worker::runThread(std::string fileName,
+                       std::shared_ptr<Signal> _signal) {
+	std::atomic_bool& _stopped = _signal->stopped;
+	// Once this is false the Worker may be gone, and nothing may touch it
+	bool holdsLock = false;
+
+	// Takes the lock, after letting the Worker be destroyed meanwhile. Returns
+	// false if it was stopped, leaving the lock released for good.
+	auto relock = [&_stopped, &_signal, &holdsLock] {
+		_signal->destructionMutex.lock();
+		holdsLock = !_stopped;
+		if (!holdsLock) {
+			_signal->destructionMutex.unlock();
+		}
+		return holdsLock;
+	};
 
 	sol::state state;
 	defineThreadSafeAPIs(&state);
 
-	state["sendMessage"] = [this](std::string message) {
-		this->l_sendMessage(message);
+	state["sendMessage"] = [this, &_signal, &holdsLock, &relock](
+	                           sol::object message,
+	                           sol::optional<std::string> mode) {
+		if (!holdsLock) return false;
+
+		auto wait = [&_signal, &relock] {
+			// Allow this to be deconstructed while waiting
+			_signal->destructionMutex.unlock();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			return !relock();
+		};
+		return pushMessage(this->receiveMessageQueue, message, mode, wait);
 	};
 
-	state["receiveMessage"] = [this](sol::this_state s) {
-		return this->l_receiveMessage(s);
+	// Returns the message, and true as well once the worker is stopped
+	state["receiveMessage"] = [this, &_stopped, &_signal, &holdsLock, &relock](
+	                              sol::optional<unsigned int> timeoutMs,
+	                              sol::this_state s) {
+		if (!holdsLock) {
+			return std::make_tuple(sol::make_object(s, sol::nil), true);
+		}
+
+		if (timeoutMs) {
+			// Read before checking the queue so a message sent in between is seen
+			unsigned long long numSent;
+			{
+				std::lock_guard<std::mutex> guard(_signal->mutex);
+				numSent = _signal->numSent;
+			}
+
+			if (!this->sendMessageQueue.size()) {
+				// Allow this to be deconstructed while waiting
+				_signal->destructionMutex.unlock();
+				{
+					std::unique_lock<std::mutex> lock(_signal->mutex);
+					_signal->condition.wait_for(
+					    lock, std::chrono::milliseconds(*timeoutMs), [&] {
+						    return _stopped || _signal->numSent != numSent;
+					    });
+				}
+
+				if (!relock()) {
+					return std::make_tuple(sol::make_object(s, sol::nil), true);
+				}
+			}
+		}
+
+		return std::make_tuple(this->l_receiveMessage(s), false);
 	};
 
-	destructionMutex.lock();
+	state["sleep"] = [&_signal, &holdsLock, &relock](unsigned int ms) -> bool {
+		if (!holdsLock) return true;
 
-	state["sleep"] = [this, &_stopped](unsigned int ms) -> bool {
 		// Allow this to be deconstructed while sleeping
-		this->destructionMutex.unlock();
+		_signal->destructionMutex.unlock();
 		std::this_thread::sleep_for(std::chrono::milliseconds(ms));
-
-		if (*_stopped) return true;
-
-		this->destructionMutex.lock();
-		return false;
+		return !relock();
 	};
 
-	{
+	if (relock()) {
 		sol::load_result load = state.load_file(fileName);
 		if (noLuaCallError(&load)) {
 			sol::protected_function_result res = load();
@@ -51,63 +155,65 @@ void Worker::runThread(std::string fileName) {
 		}
 	}
 
-	if (!*_stopped) {
-		destructionMutex.unlock();
-	}
-
-	while (!*_stopped) {
-		std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+	if (holdsLock) {
+		_signal->destructionMutex.unlock();
 	}
 
-	delete _stopped;
-}
-
-void Worker::l_sendMessage(std::string message) {
-	std::lock_guard<std::mutex> guard(receiveMessageQueueMutex);
-	receiveMessageQueue.push(message);
-	if (receiveMessageQueue.size() > 2047) receiveMessageQueue.pop();
+	std::unique_lock<std::mutex> lock(_signal->mutex);
+	_signal->condition.wait(lock, [&_stopped] { return _stopped.load(); });
 }
 
 sol::object Worker::l_receiveMessage(sol::this_state s) {
-	sol::state_view state(s);
-
-	sendMessageQueueMutex.lock();
-	if (sendMessageQueue.empty()) {
-		sendMessageQueueMutex.unlock();
-		return sol::make_object(state, sol::nil);
-	}
-
-	auto message = sendMessageQueue.front();
-	sendMessageQueue.pop();
-	sendMessageQueueMutex.unlock();
-	return sol::make_object(state, message);
+	return popMessage(sendMessageQueue, s);
 }
 
 void Worker::stop() {
-	if (stopped && !*stopped) {
-		*stopped = true;
+	if (!signal->stopped) {
+		std::lock_guard<std::mutex> guard(signal->mutex);
+		signal->stopped = true;
+		signal->condition.notify_all();
 	}
 }
 
-void Worker::sendMessage(std::string message) {
-	if (stopped && *stopped) return;
-
-	std::lock_guard<std::mutex> guard(sendMessageQueueMutex);
-	sendMessageQueue.push(message);
-	if (sendMessageQueue.size() > 2047) sendMessageQueue.pop();
+bool Worker::sendMessage(sol::object message, sol::optional<std::string> mode,
+                         sol::optional<unsigned int> timeoutMs) {
+	if (signal->stopped) return false;
+
+	// Waits for the worker to catch up, but never holds up the game for longer
+	// than the timeout
+	auto deadline = std::chrono::steady_clock::now() +
+	                std::chrono::milliseconds(timeoutMs.value_or(blockTimeoutMs));
+	bool pushed = pushMessage(sendMessageQueue, message, mode, [this, deadline] {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		if (signal->stopped) return true;
+		if (std::chrono::steady_clock::now() < deadline) return false;
+
+		sendMessageQueue.countDropped();
+		return true;
+	});
+
+	if (pushed) {
+		std::lock_guard<std::mutex> guard(signal->mutex);
+		signal->numSent++;
+		signal->condition.notify_one();
+	}
+	return pushed;
 }
 
 sol::object Worker::receiveMessage(sol::this_state s) {
-	sol::state_view state(s);
+	return popMessage(receiveMessageQueue, s);
+}
 
-	receiveMessageQueueMutex.lock();
-	if (receiveMessageQueue.empty()) {
-		receiveMessageQueueMutex.unlock();
-		return sol::make_object(state, sol::nil);
-	}
+bool Worker::hasMessages() const { return receiveMessageQueue.size() > 0; }
+
+sol::table Worker::getQueueStats(sol::this_state s) {
+	sol::state_view state(s);
 
-	auto message = receiveMessageQueue.front();
-	receiveMessageQueue.pop();
-	receiveMessageQueueMutex.unlock();
-	return sol::make_object(state, message);
+	auto stats = state.create_table();
+	stats["sendDepth"] = sendMessageQueue.size();
+	stats["sendDropped"] = sendMessageQueue.getNumDropped();
+	stats["receiveDepth"] = receiveMessageQueue.size();
+	stats["receiveDropped"] = receiveMessageQueue.getNumDropped();
+	stats["capacity"] = queueCapacity;
+	return stats;
 }
\ No newline at end of file
@@ -2,28 +2,40 @@
 #include "sol/sol.hpp"
 
 #include <atomic>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
+#include "messagequeue.h"
 
 class Worker {
-	std::atomic_bool* stopped = nullptr;
-	std::mutex destructionMutex;
+	// Wakes the worker thread when a message is sent to it or it is stopped.
+	// Shared with the thread, which can still be waiting after this is gone.
+	struct Signal {
+		std::mutex mutex;
+		std::condition_variable condition;
+		unsigned long long numSent = 0;
+		std::atomic_bool stopped = false;
+		// Held by the thread whenever it may touch the Worker, so it isn't
+		// destroyed underneath it
+		std::mutex destructionMutex;
+	};
 
-	std::queue<std::string> sendMessageQueue;
-	std::mutex sendMessageQueueMutex;
+	std::shared_ptr<Signal> signal = std::make_shared<Signal>();
 
-	std::queue<std::string> receiveMessageQueue;
-	std::mutex receiveMessageQueueMutex;
+	MessageQueue<std::string> sendMessageQueue;
+	MessageQueue<std::string> receiveMessageQueue;
 
-	void runThread(std::string fileName);
-	void l_sendMessage(std::string message);
+	void runThread(std::string fileName, std::shared_ptr<Signal> _signal);
 	sol::object l_receiveMessage(sol::this_state s);
 
  public:
 	Worker(std::string fileName);
 	~Worker();
 	void stop();
-	void sendMessage(std::string message);
+	bool sendMessage(sol::object message, sol::optional<std::string> mode,
+	                 sol::optional<unsigned int> timeoutMs);
 	sol::object receiveMessage(sol::this_state s);
+	bool hasMessages() const;
+	sol::table getQueueStats(sol::this_state s);
 };
\ No newline at end of file
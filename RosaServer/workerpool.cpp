@@ -0,0 +1,229 @@
+#include "workerpool.h"
+#include "api.h"
+
+#include <thread>
+
+// Past this many results waiting to be received, the values of new ones are
+// thrown away and the job reported as failed
+static constexpr size_t maxWaitingResults = 2047;
+
+WorkerPool::WorkerPool(int numThreads) {
+	if (numThreads < 1) {
+		throw std::invalid_argument("Pool needs at least one thread");
+	}
+
+	shared = std::make_shared<Shared>(numThreads);
+
+	for (int i = 0; i < numThreads; i++) {
+		std::thread thread(&WorkerPool::runThread, shared, i);
+		thread.detach();
+	}
+}
+
+WorkerPool::~WorkerPool() { stop(); }
+
+void WorkerPool::setError(sol::state_view state, Result& result,
+                          const char* message) {
+	result.success = false;
+	result.values.assign(1, std::string());
+	Serializer::serialize(sol::make_object(state, message), result.values[0]);
+}
+
+bool WorkerPool::takeJob(Shared& shared, int index, Job& job) {
+	int numQueues = shared.queues.size();
+
+	// Oldest job from our own queue first, otherwise the newest from another
+	for (int offset = 0; offset < numQueues; offset++) {
+		auto& queue = shared.queues[(index + offset) % numQueues];
+		std::lock_guard<std::mutex> guard(queue.mutex);
+		if (queue.jobs.empty()) {
+			continue;
+		}
+
+		if (offset == 0) {
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+		} else {
+			job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+		}
+
+		std::lock_guard<std::mutex> pendingGuard(shared.pendingMutex);
+		shared.pendingJobs--;
+		return true;
+	}
+
+	return false;
+}
+
+WorkerPool::Result WorkerPool::runJob(sol::state& state, Job& job) {
+	Result result{job.id, false};
+
+	try {
+		sol::protected_function require = state["require"];
+		sol::protected_function_result loaded = require(job.moduleName);
+		if (!loaded.valid()) {
+			sol::error err = loaded;
+			throw std::runtime_error(err.what());
+		}
+
+		sol::object module = loaded;
+		if (module.get_type() != sol::type::table) {
+			throw std::runtime_error("Module did not return a table");
+		}
+
+		sol::object function = module.as<sol::table>()[job.functionName];
+		if (function.get_type() != sol::type::function) {
+			throw std::runtime_error("Function not found");
+		}
+
+		std::vector<sol::object> arguments;
+		arguments.reserve(job.arguments.size());
+		for (const auto& argument : job.arguments) {
+			arguments.push_back(
+			    Serializer::deserialize(state, argument, &vectorCodec));
+		}
+
+		sol::protected_function_result res =
+		    function.as<sol::protected_function>()(sol::as_args(arguments));
+		if (!res.valid()) {
+			sol::error err = res;
+			throw std::runtime_error(err.what());
+		}
+
+		result.values.resize(res.return_count());
+		for (int i = 0; i < res.return_count(); i++) {
+			Serializer::serialize(res.get<sol::object>(i), result.values[i],
+			                      &vectorCodec);
+		}
+		result.success = true;
+	} catch (std::exception& e) {
+		setError(state, result, e.what());
+	}
+
+	return result;
+}
+
+void WorkerPool::runThread(std::shared_ptr<Shared> shared, int index) {
+	sol::state state;
+	defineThreadSafeAPIs(&state);
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(shared->pendingMutex);
+			shared->pendingCondition.wait(lock, [&shared] {
+				return shared->stopped || shared->pendingJobs > 0;
+			});
+		}
+
+		if (shared->stopped) {
+			break;
+		}
+
+		Job job;
+		if (!takeJob(*shared, index, job)) {
+			continue;
+		}
+
+		Result result = runJob(state, job);
+		if (shared->stopped) {
+			break;
+		}
+
+		std::lock_guard<std::mutex> guard(shared->resultsMutex);
+		if (shared->results.size() >= maxWaitingResults) {
+			// Still delivered, so whatever waits on the job hears about it
+			setError(state, result,
+			         "Result dropped, too many waiting to be received");
+			shared->numDroppedResults++;
+		}
+		shared->results.push(std::move(result));
+	}
+}
+
+void WorkerPool::stop() {
+	if (shared->stopped) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> guard(shared->pendingMutex);
+	shared->stopped = true;
+	shared->pendingCondition.notify_all();
+}
+
+unsigned int WorkerPool::submit(std::string moduleName,
+                                std::string functionName,
+                                sol::variadic_args args) {
+	if (shared->stopped) {
+		throw std::runtime_error("Pool is stopped");
+	}
+
+	std::vector<std::string> arguments(args.size());
+	for (size_t i = 0; i < args.size(); i++) {
+		Serializer::serialize(args.get<sol::object>(i), arguments[i],
+		                      &vectorCodec);
+	}
+
+	unsigned int id = nextJobID++;
+	Job job{id, std::move(moduleName), std::move(functionName),
+	        std::move(arguments)};
+
+	auto& queue = shared->queues[nextQueue++ % shared->queues.size()];
+	{
+		std::lock_guard<std::mutex> guard(queue.mutex);
+		queue.jobs.push_back(std::move(job));
+	}
+
+	std::lock_guard<std::mutex> guard(shared->pendingMutex);
+	shared->pendingJobs++;
+	shared->pendingCondition.notify_one();
+
+	return id;
+}
+
+bool WorkerPool::takeResult(sol::state_view state, unsigned int& id,
+                            bool& success, std::vector<sol::object>& values) {
+	Result result;
+	{
+		std::lock_guard<std::mutex> guard(shared->resultsMutex);
+		if (shared->results.empty()) {
+			return false;
+		}
+
+		result = std::move(shared->results.front());
+		shared->results.pop();
+	}
+
+	id = result.id;
+	success = result.success;
+	values.clear();
+	for (const auto& value : result.values) {
+		values.push_back(Serializer::deserialize(state, value, &vectorCodec));
+	}
+	return true;
+}
+
+uint64_t WorkerPool::getNumDroppedResults() const {
+	std::lock_guard<std::mutex> guard(shared->resultsMutex);
+	return shared->numDroppedResults;
+}
+
+sol::variadic_results WorkerPool::receiveResult(sol::this_state s) {
+	sol::state_view state(s);
+	sol::variadic_results results;
+
+	unsigned int id;
+	bool success;
+	std::vector<sol::object> values;
+	if (!takeResult(state, id, success, values)) {
+		results.push_back(sol::make_object(state, sol::lua_nil));
+		return results;
+	}
+
+	results.push_back(sol::make_object(state, id));
+	results.push_back(sol::make_object(state, success));
+	for (auto& value : values) {
+		results.push_back(std::move(value));
+	}
+	return results;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "sol/sol.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <vector>
+
+// Fixed set of threads, each keeping one Lua state for its whole life. Jobs
+// name a module, a function in it and arguments, which can be anything a
+// Worker message can be; they are handed out round robin, and a thread with
+// nothing left to do takes jobs queued on the others.
+class WorkerPool {
+	struct Job {
+		unsigned int id;
+		std::string moduleName;
+		std::string functionName;
+		// Each serialized on its own
+		std::vector<std::string> arguments;
+	};
+
+	struct Result {
+		unsigned int id;
+		bool success;
+		// The serialized returned values, or the error message
+		std::vector<std::string> values;
+	};
+
+	struct JobQueue {
+		std::deque<Job> jobs;
+		std::mutex mutex;
+	};
+
+	// Kept alive by the threads until they exit, so the pool can be collected
+	// while a job is running
+	struct Shared {
+		std::vector<JobQueue> queues;
+		std::atomic_bool stopped = false;
+
+		int pendingJobs = 0;
+		std::mutex pendingMutex;
+		std::condition_variable pendingCondition;
+
+		std::queue<Result> results;
+		std::mutex resultsMutex;
+		uint64_t numDroppedResults = 0;
+
+		Shared(int numThreads) : queues(numThreads) {}
+	};
+
+	std::shared_ptr<Shared> shared;
+	unsigned int nextJobID = 0;
+	unsigned int nextQueue = 0;
+
+	static void setError(sol::state_view state, Result& result,
+	                     const char* message);
+	static bool takeJob(Shared& shared, int index, Job& job);
+	static Result runJob(sol::state& state, Job& job);
+	static void runThread(std::shared_ptr<Shared> shared, int index);
+
+ public:
+	WorkerPool(int numThreads);
+	~WorkerPool();
+	void stop();
+	unsigned int submit(std::string moduleName, std::string functionName,
+	                    sol::variadic_args args);
+	sol::variadic_results receiveResult(sol::this_state s);
+	uint64_t getNumDroppedResults() const;
+	// Same as receiveResult, for use from C++. values holds the error message
+	// if the job failed.
+	bool takeResult(sol::state_view state, unsigned int& id, bool& success,
+	                std::vector<sol::object>& values);
+};
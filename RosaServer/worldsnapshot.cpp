@@ -0,0 +1,235 @@
+#include "worldsnapshot.h"
+
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include "activeset.h"
+#include "api.h"
+#include "console.h"
+#include "engine.h"
+
+namespace WorldSnapshot {
+static const char* const definitions = R"(
+typedef struct {
+	int index;
+	int playerID;
+	int accountID;
+	int vehicleID;
+	int health;
+	Vector pos;
+	Vector vel;
+} SnapshotHuman;
+
+typedef struct {
+	int index;
+	int type;
+	int parentHumanID;
+	int vehicleID;
+	Vector pos;
+	Vector vel;
+} SnapshotItem;
+
+typedef struct {
+	int index;
+	unsigned int type;
+	int health;
+	int lastDriverPlayerID;
+	Vector pos;
+	Vector vel;
+} SnapshotVehicle;
+
+typedef struct {
+	int index;
+	unsigned int type;
+	int playerID;
+	int time;
+	Vector pos;
+	Vector vel;
+} SnapshotBullet;
+
+typedef struct {
+	unsigned int sequence;
+	int numHumans;
+	int numItems;
+	int numVehicles;
+	int numBullets;
+	SnapshotHuman humans[maxNumberOfHumans];
+	SnapshotItem items[maxNumberOfItems];
+	SnapshotVehicle vehicles[maxNumberOfVehicles];
+	SnapshotBullet bullets[4096];
+} WorldSnapshot;
+)";
+
+static const char* const wrappers = R"(
+local ffi, acquireAddress, releaseAddress = ...
+
+local worldSnapshot = {}
+
+-- Frames handed out and not released yet
+local pinned = setmetatable({}, { __mode = 'k' })
+
+local function unpin (frame)
+	releaseAddress(tonumber(ffi.cast('uintptr_t', frame)))
+end
+
+function worldSnapshot.acquire ()
+	local address = acquireAddress()
+	if address == 0 then
+		return nil
+	end
+
+	-- A frame dropped without being released is let go when it is collected
+	local frame = ffi.gc(ffi.cast('const WorldSnapshot*', address), unpin)
+	pinned[frame] = true
+	return frame
+end
+
+function worldSnapshot.release (frame)
+	if not pinned[frame] then
+		error('Frame is not acquired', 2)
+	end
+
+	pinned[frame] = nil
+	ffi.gc(frame, nil)
+	unpin(frame)
+end
+
+return worldSnapshot
+)";
+
+static Frame frames[2];
+static std::atomic_int readers[2];
+// Index of the frame readers are given, or -1 before the first publish
+static std::atomic_int current = -1;
+static unsigned int sequence = 0;
+
+static void fill(Frame& frame) {
+	frame.sequence = sequence;
+
+	frame.numHumans = 0;
+	ActiveSets::humans.forEach([&frame](int index) {
+		const Human& man = Engine::humans[index];
+		if (man.active) {
+			frame.humans[frame.numHumans++] = {
+			    index,      man.playerID, man.accountID,   man.vehicleID,
+			    man.health, man.pos,      man.bones[0].vel};
+		}
+	});
+
+	frame.numItems = 0;
+	ActiveSets::items.forEach([&frame](int index) {
+		const Item& item = Engine::items[index];
+		if (item.active) {
+			frame.items[frame.numItems++] = {
+			    index,          item.type, item.parentHumanID,
+			    item.vehicleID, item.pos,  item.vel};
+		}
+	});
+
+	frame.numVehicles = 0;
+	ActiveSets::vehicles.forEach([&frame](int index) {
+		const Vehicle& vcl = Engine::vehicles[index];
+		if (vcl.active) {
+			frame.vehicles[frame.numVehicles++] = {
+			    index,   vcl.type, vcl.health, vcl.lastDriverPlayerID,
+			    vcl.pos, vcl.vel};
+		}
+	});
+
+	frame.numBullets =
+	    std::min(static_cast<int>(*Engine::numBullets), maxBullets);
+	for (int i = 0; i < frame.numBullets; i++) {
+		const Bullet& bul = Engine::bullets[i];
+		frame.bullets[i] = {i, bul.type, bul.playerID, bul.time, bul.pos, bul.vel};
+	}
+}
+
+void publish() {
+	sequence++;
+
+	int next = current == 0 ? 1 : 0;
+	// A reader which pins the frame after this sees that it is not current
+	// and lets go again
+	if (readers[next]) {
+		return;
+	}
+
+	fill(frames[next]);
+	current = next;
+}
+
+const Frame* acquire() {
+	while (true) {
+		int index = current;
+		if (index == -1) {
+			return nullptr;
+		}
+
+		readers[index]++;
+		if (current == index) {
+			return &frames[index];
+		}
+		readers[index]--;
+	}
+}
+
+void release(const Frame* frame) {
+	for (int i = 0; i < 2; i++) {
+		if (frame == &frames[i]) {
+			int count = readers[i];
+			do {
+				if (count <= 0) {
+					throw std::invalid_argument("Snapshot frame is not acquired");
+				}
+			} while (!readers[i].compare_exchange_weak(count, count - 1));
+			return;
+		}
+	}
+	throw std::invalid_argument("Not a snapshot frame");
+}
+
+static uintptr_t acquireAddress() {
+	return reinterpret_cast<uintptr_t>(acquire());
+}
+
+static void releaseAddress(uintptr_t address) {
+	release(reinterpret_cast<const Frame*>(address));
+}
+
+void defineAPI(sol::state* state) {
+	sol::table ffi = (*state)["ffi"];
+
+	sol::protected_function cdef = ffi["cdef"];
+	auto res = cdef(definitions);
+	if (!noLuaCallError(&res)) {
+		return;
+	}
+
+	sol::protected_function sizeOf = ffi["sizeof"];
+	auto size = sizeOf("WorldSnapshot");
+	if (!noLuaCallError(&size)) {
+		return;
+	}
+	if (size.get<size_t>() != sizeof(Frame)) {
+		std::ostringstream stream;
+		stream << LUA_PREFIX "FFI definition of WorldSnapshot is "
+		       << size.get<size_t>() << " bytes instead of " << sizeof(Frame)
+		       << "\n";
+		Console::log(stream.str());
+		return;
+	}
+
+	sol::load_result load = state->load(wrappers, "=worldSnapshot");
+	if (!noLuaCallError(&load)) {
+		return;
+	}
+
+	sol::protected_function_result api =
+	    load(ffi, acquireAddress, releaseAddress);
+	if (!noLuaCallError(&api)) {
+		return;
+	}
+
+	(*state)["worldSnapshot"] = api.get<sol::table>();
+}
+};  // namespace WorldSnapshot
@@ -0,0 +1,73 @@
+#pragma once
+#include "sol/sol.hpp"
+#include "structs.h"
+
+// Copy of where everything is, taken by the main thread once per tick and
+// readable from any Lua state without touching engine memory. Two frames are
+// kept: readers pin the latest one while the next is written to the other.
+namespace WorldSnapshot {
+// Bullets beyond this are left out
+static constexpr int maxBullets = 4096;
+
+// These and Frame are mirrored in definitions for the FFI
+struct HumanState {
+	int index;
+	int playerID;
+	int accountID;
+	int vehicleID;
+	int health;
+	Vector pos;
+	Vector vel;
+};
+
+struct ItemState {
+	int index;
+	int type;
+	int parentHumanID;
+	int vehicleID;
+	Vector pos;
+	Vector vel;
+};
+
+struct VehicleState {
+	int index;
+	unsigned int type;
+	int health;
+	int lastDriverPlayerID;
+	Vector pos;
+	Vector vel;
+};
+
+struct BulletState {
+	int index;
+	unsigned int type;
+	int playerID;
+	int time;
+	Vector pos;
+	Vector vel;
+};
+
+struct Frame {
+	// Counts every tick, including ones that could not be published
+	unsigned int sequence;
+	int numHumans;
+	int numItems;
+	int numVehicles;
+	int numBullets;
+	HumanState humans[maxNumberOfHumans];
+	ItemState items[maxNumberOfItems];
+	VehicleState vehicles[maxNumberOfVehicles];
+	BulletState bullets[maxBullets];
+};
+
+// Called by the main thread after each logic tick. Skipped if a reader still
+// holds the frame it would overwrite.
+void publish();
+// The latest frame, which stays unchanged until released, or nullptr if
+// nothing has been published yet
+const Frame* acquire();
+void release(const Frame* frame);
+
+// Adds worldSnapshot.acquire and release, handing out FFI views of frames.
+void defineAPI(sol::state* state);
+};  // namespace WorldSnapshot
@@ -1,5 +1,10 @@
+#include "pipeframes.h"
+#include "serializer.h"
+#include "sharedring.h"
 #include "sol/sol.hpp"
 
+#include <poll.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include <chrono>
 #include <thread>
@@ -7,12 +12,19 @@
 static constexpr int CODE_INVALID_USAGE = 1;
 static constexpr int CODE_FILE_INVALID = 2;
 static constexpr int CODE_FILE_RUNTIME_ERROR = 3;
+static constexpr int CODE_PARENT_EXITED = 4;
 
-static constexpr const char* ERR_WRITING_MESSAGE =
-    "Couldn't write full message to pipe";
+// How often a satellite waiting on shared memory checks its parent is alive
+static constexpr int parentCheckMs = 100;
 
-static int fdFromParent;
-static int fdToParent;
+static pid_t parentPID;
+
+static int fromParentFD;
+static FrameReader* fromParent;
+static FrameWriter* toParent;
+// Set when the parent gave us shared memory, which then carries every message
+static SharedRing* ringFromParent;
+static SharedRing* ringToParent;
 
 static double l_os_realClock() {
 	auto now = std::chrono::steady_clock::now();
@@ -22,46 +34,101 @@ static double l_os_realClock() {
 	return value.count() / 1000.;
 }
 
+// Nothing else tells a satellite waiting on shared memory that its parent is
+// gone, it would be left waiting forever
+static void exitIfOrphaned() {
+	if (getppid() != parentPID) {
+		exit(CODE_PARENT_EXITED);
+	}
+}
+
+static bool readMessage(std::string& message) {
+	if (ringFromParent) {
+		return ringFromParent->read(message);
+	}
+
+	return fromParent->read(message);
+}
+
 static sol::object l_receiveMessage(sol::this_state s) {
 	sol::state_view lua(s);
 
-	unsigned int length;
-
-	auto bytesRead = read(fdFromParent, &length, sizeof(length));
-	if (bytesRead == -1) {
-		if (errno != EAGAIN) {
-			throw std::runtime_error(strerror(errno));
-		}
-	} else if (bytesRead == sizeof(length)) {
-		std::string message(length, ' ');
-		bytesRead = read(fdFromParent, message.data(), length);
-		if (bytesRead == -1) {
-			if (errno != EAGAIN) {
-				throw std::runtime_error(strerror(errno));
-			}
-		} else if (bytesRead == length) {
-			return sol::make_object(lua, message);
-		}
+	std::string message;
+	if (readMessage(message)) {
+		return Serializer::deserialize(lua, message);
 	}
 
 	return sol::make_object(lua, sol::nil);
 }
 
-static void l_sendMessage(std::string message) {
-	unsigned int length = static_cast<unsigned int>(message.length());
+static sol::table l_receiveMessages(unsigned int max, sol::this_state s) {
+	sol::state_view lua(s);
 
-	auto bytesWritten = write(fdToParent, &length, sizeof(length));
-	if (bytesWritten == -1) {
-		throw std::runtime_error(strerror(errno));
-	} else if (bytesWritten != sizeof(length)) {
-		throw std::runtime_error(ERR_WRITING_MESSAGE);
-	} else {
-		bytesWritten = write(fdToParent, message.data(), length);
-		if (bytesWritten == -1) {
-			throw std::runtime_error(strerror(errno));
-		} else if (bytesWritten != length) {
-			throw std::runtime_error(ERR_WRITING_MESSAGE);
+	auto messages = lua.create_table();
+	std::string message;
+	for (unsigned int i = 0; i < max && readMessage(message); i++) {
+		messages.add(Serializer::deserialize(lua, message));
+	}
+
+	return messages;
+}
+
+static void l_sendMessage(sol::object value) {
+	std::string message;
+	Serializer::serialize(value, message);
+
+	if (ringToParent) {
+		// Nothing waits on us here, so wait for the parent to make room
+		while (!ringToParent->write(message)) {
+			exitIfOrphaned();
+			ringToParent->waitForSpace(parentCheckMs);
 		}
+		return;
+	}
+
+	// The pipe to the parent blocks, so this returns once it is all written
+	toParent->queue(std::move(message));
+	toParent->flush();
+}
+
+static std::tuple<sol::object, sol::object> l_peekString(sol::this_state s) {
+	sol::state_view lua(s);
+
+	if (!ringFromParent) {
+		throw std::runtime_error("No shared memory with the parent");
+	}
+
+	std::string_view message;
+	std::string_view string;
+	if (ringFromParent->peek(message) &&
+	    Serializer::viewString(message, string)) {
+		return std::make_tuple(
+		    sol::make_object(lua, reinterpret_cast<uintptr_t>(string.data())),
+		    sol::make_object(lua, string.size()));
+	}
+
+	return std::make_tuple(sol::make_object(lua, sol::nil),
+	                       sol::make_object(lua, sol::nil));
+}
+
+static void l_skipMessage() {
+	if (!ringFromParent) {
+		throw std::runtime_error("No shared memory with the parent");
+	}
+
+	ringFromParent->skip();
+}
+
+static void l_waitForMessage(int timeoutMs) {
+	if (ringFromParent) {
+		exitIfOrphaned();
+		ringFromParent->wait(timeoutMs);
+		return;
+	}
+
+	if (!fromParent->hasFrame()) {
+		pollfd pollFD{fromParentFD, POLLIN, 0};
+		poll(&pollFD, 1, timeoutMs);
 	}
 }
 
@@ -82,10 +149,38 @@ static int wrapExceptions(lua_State* L, lua_CFunction f) {
 int main(int argc, const char* argv[]) {
 	if (argc < 4) return CODE_INVALID_USAGE;
 
-	fdFromParent = atoi(argv[1]);
-	fdToParent = atoi(argv[2]);
+	parentPID = getppid();
+
+	fromParentFD = atoi(argv[1]);
+	FrameReader reader(fromParentFD);
+	FrameWriter writer(atoi(argv[2]));
+	fromParent = &reader;
+	toParent = &writer;
 	const char* fileName = argv[3];
 
+	std::unique_ptr<SharedRing> sharedFromParent;
+	std::unique_ptr<SharedRing> sharedToParent;
+	if (argc >= 8) {
+		int memoryFD = atoi(argv[4]);
+		size_t ringCapacity = strtoull(argv[5], nullptr, 10);
+		size_t ringSize = SharedRing::getMappingSize(ringCapacity);
+
+		void* memory = mmap(nullptr, ringSize * 2, PROT_READ | PROT_WRITE,
+		                    MAP_SHARED, memoryFD, 0);
+		if (memory == MAP_FAILED) return CODE_INVALID_USAGE;
+		close(memoryFD);
+
+		int eventToChild = atoi(argv[6]);
+		int eventToParent = atoi(argv[7]);
+		sharedFromParent = std::make_unique<SharedRing>(
+		    memory, ringCapacity, eventToChild, eventToParent);
+		sharedToParent = std::make_unique<SharedRing>(
+		    static_cast<char*>(memory) + ringSize, ringCapacity, eventToParent,
+		    eventToChild);
+		ringFromParent = sharedFromParent.get();
+		ringToParent = sharedToParent.get();
+	}
+
 	sol::state lua;
 	
 	lua_pushlightuserdata(lua, (void*)wrapExceptions);
@@ -108,7 +203,11 @@ int main(int argc, const char* argv[]) {
 	lua["os"]["realClock"] = l_os_realClock;
 
 	lua["receiveMessage"] = l_receiveMessage;
+	lua["receiveMessages"] = l_receiveMessages;
 	lua["sendMessage"] = l_sendMessage;
+	lua["peekString"] = l_peekString;
+	lua["skipMessage"] = l_skipMessage;
+	lua["waitForMessage"] = l_waitForMessage;
 
 	lua["sleep"] = [](unsigned int ms) {
 		std::this_thread::sleep_for(std::chrono::milliseconds(ms));
@@ -0,0 +1,138 @@
+#include "pipeframes.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <stdexcept>
+
+static constexpr size_t readChunkSize = 64 * 1024;
+// Most fill() reads in one go, so a fast writer can't keep the reader in it
+static constexpr size_t maxReadPerFill = 1024 * 1024;
+// Frames handed to a single writev, two iovecs each
+static constexpr int maxFramesPerWrite = 64;
+
+bool FrameReader::hasFrame() const {
+	size_t available = buffer.size() - position;
+
+	uint32_t length;
+	if (available < sizeof(length)) {
+		return false;
+	}
+	memcpy(&length, buffer.data() + position, sizeof(length));
+	if (length > maxFrameSize) {
+		throw std::runtime_error("Frame is too large");
+	}
+	return available - sizeof(length) >= length;
+}
+
+bool FrameReader::takeFrame(std::string& message) {
+	if (!hasFrame()) {
+		return false;
+	}
+
+	uint32_t length;
+	memcpy(&length, buffer.data() + position, sizeof(length));
+	message.assign(buffer, position + sizeof(length), length);
+	position += sizeof(length) + length;
+	return true;
+}
+
+void FrameReader::fill() {
+	// Drop what has been handed out already
+	buffer.erase(0, position);
+	position = 0;
+
+	for (size_t total = 0; total < maxReadPerFill; total += readChunkSize) {
+		size_t size = buffer.size();
+		buffer.resize(size + readChunkSize);
+		auto bytesRead = ::read(fd, buffer.data() + size, readChunkSize);
+		buffer.resize(size + (bytesRead > 0 ? bytesRead : 0));
+
+		if (bytesRead == -1) {
+			if (errno == EINTR) continue;
+			if (errno == EAGAIN) break;
+			throw std::runtime_error(strerror(errno));
+		}
+
+		// Stop at the end of what is there now, or when the other end closed
+		if (static_cast<size_t>(bytesRead) < readChunkSize) {
+			break;
+		}
+	}
+}
+
+bool FrameReader::read(std::string& message) {
+	if (takeFrame(message)) {
+		return true;
+	}
+
+	fill();
+	return takeFrame(message);
+}
+
+bool FrameWriter::queue(std::string message) {
+	if (message.size() > maxFrameSize) {
+		throw std::length_error("Message is too large");
+	}
+
+	if (numQueuedBytes + message.size() > maxQueuedBytes) {
+		return false;
+	}
+
+	uint32_t length = static_cast<uint32_t>(message.size());
+	numQueuedBytes += message.size();
+	frames.push_back({length, std::move(message)});
+	return true;
+}
+
+bool FrameWriter::flush() {
+	while (!frames.empty()) {
+		iovec vectors[maxFramesPerWrite * 2];
+		int numVectors = 0;
+		auto add = [&](const char* data, size_t size) {
+			vectors[numVectors++] = {const_cast<char*>(data), size};
+		};
+
+		size_t skip = offset;
+		for (const auto& frame : frames) {
+			if (numVectors + 2 > maxFramesPerWrite * 2) {
+				break;
+			}
+
+			// Only the first frame can have been partly written
+			if (skip < sizeof(frame.length)) {
+				auto length = reinterpret_cast<const char*>(&frame.length);
+				add(length + skip, sizeof(frame.length) - skip);
+				skip = 0;
+			} else {
+				skip -= sizeof(frame.length);
+			}
+			add(frame.body.data() + skip, frame.body.size() - skip);
+			skip = 0;
+		}
+
+		auto bytesWritten = writev(fd, vectors, numVectors);
+		if (bytesWritten == -1) {
+			if (errno == EINTR) continue;
+			if (errno == EAGAIN) return false;
+			throw std::runtime_error(strerror(errno));
+		}
+
+		size_t remaining = bytesWritten;
+		while (remaining) {
+			size_t left = sizeof(uint32_t) + frames.front().body.size() - offset;
+			if (remaining < left) {
+				offset += remaining;
+				break;
+			}
+
+			remaining -= left;
+			numQueuedBytes -= frames.front().body.size();
+			frames.pop_front();
+			offset = 0;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <string>
+
+// Messages on the pipes between RosaServer and its satellite processes are
+// framed as a 4-byte length followed by that many bytes.
+
+// Frames declaring more than this are taken to be corrupt
+static constexpr uint32_t maxFrameSize = 64 * 1024 * 1024;
+
+// Takes frames off a non-blocking pipe, keeping a partly arrived frame until
+// the rest of it comes in.
+class FrameReader {
+	int fd;
+	std::string buffer;
+	// Start of the first frame not yet handed out
+	size_t position = 0;
+
+	bool takeFrame(std::string& message);
+	void fill();
+
+ public:
+	explicit FrameReader(int fd) : fd(fd) {}
+	// Moves the next whole frame into message, reading the pipe only when
+	// none is buffered. Returns false if there is none yet. A frame longer
+	// than maxFrameSize throws std::runtime_error.
+	bool read(std::string& message);
+	// Whether a whole frame is buffered already, without reading the pipe
+	bool hasFrame() const;
+};
+
+// Queues frames and hands as many of them to the pipe as it will take in one
+// writev call.
+class FrameWriter {
+	struct Frame {
+		uint32_t length;
+		std::string body;
+	};
+
+	int fd;
+	std::deque<Frame> frames;
+	// Bytes of the first frame, counting its length, already written
+	size_t offset = 0;
+	size_t numQueuedBytes = 0;
+	size_t maxQueuedBytes;
+
+ public:
+	// Past maxQueuedBytes waiting to be written, further frames are dropped
+	explicit FrameWriter(int fd, size_t maxQueuedBytes = SIZE_MAX)
+	    : fd(fd), maxQueuedBytes(maxQueuedBytes) {}
+	// Returns false, leaving the frame out, if the queue is full
+	bool queue(std::string message);
+	// Writes queued frames until the pipe is full or they are all written.
+	// Returns true if nothing is left queued.
+	bool flush();
+	size_t getNumQueued() const { return frames.size(); }
+};
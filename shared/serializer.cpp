@@ -0,0 +1,258 @@
+#include "serializer.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace Serializer {
+enum Tag : uint8_t {
+	Nil,
+	False,
+	True,
+	Integer,
+	Number,
+	String,
+	Table,
+	TableEnd,
+	VectorValue,
+	RotMatrixValue,
+};
+
+static constexpr int maxDepth = 64;
+
+static const char* const vectorFields[] = {"x", "y", "z"};
+static const char* const rotMatrixFields[] = {"x1", "y1", "z1", "x2", "y2",
+                                              "z2", "x3", "y3", "z3"};
+
+static void writeVarint(std::string& buffer, uint64_t value) {
+	while (value >= 0x80) {
+		buffer.push_back(static_cast<char>(value | 0x80));
+		value >>= 7;
+	}
+	buffer.push_back(static_cast<char>(value));
+}
+
+template <typename T>
+static void writeRaw(std::string& buffer, const T& value) {
+	buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void write(const sol::object& value, std::string& buffer,
+                  const Codec* codec, int depth) {
+	switch (value.get_type()) {
+		case sol::type::none:
+		case sol::type::lua_nil:
+			buffer.push_back(Nil);
+			break;
+		case sol::type::boolean:
+			buffer.push_back(value.as<bool>() ? True : False);
+			break;
+		case sol::type::number: {
+			double number = value.as<double>();
+			// Whole numbers are common and mostly small
+			if (std::trunc(number) == number && std::abs(number) < 9.0e15) {
+				int64_t integer = static_cast<int64_t>(number);
+				buffer.push_back(Integer);
+				writeVarint(buffer, (static_cast<uint64_t>(integer) << 1) ^
+				                        static_cast<uint64_t>(integer >> 63));
+			} else {
+				buffer.push_back(Number);
+				writeRaw(buffer, number);
+			}
+			break;
+		}
+		case sol::type::string: {
+			auto string = value.as<std::string_view>();
+			buffer.push_back(String);
+			writeVarint(buffer, string.size());
+			buffer.append(string.data(), string.size());
+			break;
+		}
+		case sol::type::table: {
+			if (depth >= maxDepth) {
+				throw std::invalid_argument("Table is nested too deeply");
+			}
+
+			// The array part goes first by position, everything else as pairs
+			auto table = value.as<sol::table>();
+			size_t length = table.size();
+			buffer.push_back(Table);
+			writeVarint(buffer, length);
+			for (size_t i = 1; i <= length; i++) {
+				write(table.raw_get<sol::object>(i), buffer, codec, depth + 1);
+			}
+
+			for (const auto& pair : table) {
+				const sol::object& key = pair.first;
+				if (key.get_type() == sol::type::number) {
+					double number = key.as<double>();
+					if (number >= 1 && number <= length &&
+					    std::trunc(number) == number) {
+						continue;
+					}
+				}
+				write(key, buffer, codec, depth + 1);
+				write(pair.second, buffer, codec, depth + 1);
+			}
+			buffer.push_back(TableEnd);
+			break;
+		}
+		case sol::type::userdata: {
+			float floats[9];
+			int count = codec ? codec->toFloats(value, floats) : 0;
+			if (count != 3 && count != 9) {
+				throw std::invalid_argument("Value cannot be serialized");
+			}
+
+			buffer.push_back(count == 3 ? VectorValue : RotMatrixValue);
+			buffer.append(reinterpret_cast<const char*>(floats),
+			              count * sizeof(float));
+			break;
+		}
+		default:
+			throw std::invalid_argument("Value cannot be serialized");
+	}
+}
+
+void serialize(const sol::object& value, std::string& buffer,
+               const Codec* codec) {
+	buffer.clear();
+	write(value, buffer, codec, 0);
+}
+
+struct Reader {
+	const char* position;
+	const char* end;
+
+	void need(size_t size) {
+		if (static_cast<size_t>(end - position) < size) {
+			throw std::runtime_error("Serialized data is truncated");
+		}
+	}
+
+	uint8_t readByte() {
+		need(1);
+		return static_cast<uint8_t>(*position++);
+	}
+
+	uint64_t readVarint() {
+		uint64_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			uint8_t byte = readByte();
+			value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+			if (!(byte & 0x80)) {
+				return value;
+			}
+		}
+		throw std::runtime_error("Serialized data is corrupt");
+	}
+
+	template <typename T>
+	T readRaw() {
+		T value;
+		need(sizeof(value));
+		std::memcpy(&value, position, sizeof(value));
+		position += sizeof(value);
+		return value;
+	}
+};
+
+static sol::object read(sol::state_view state, Reader& reader, uint8_t tag,
+                        const Codec* codec, int depth) {
+	switch (tag) {
+		case Nil:
+			return sol::make_object(state, sol::lua_nil);
+		case False:
+			return sol::make_object(state, false);
+		case True:
+			return sol::make_object(state, true);
+		case Integer: {
+			uint64_t encoded = reader.readVarint();
+			int64_t integer = static_cast<int64_t>(encoded >> 1) ^
+			                  -static_cast<int64_t>(encoded & 1);
+			return sol::make_object(state, static_cast<double>(integer));
+		}
+		case Number:
+			return sol::make_object(state, reader.readRaw<double>());
+		case String: {
+			uint64_t length = reader.readVarint();
+			reader.need(length);
+			std::string_view string(reader.position, length);
+			reader.position += length;
+			return sol::make_object(state, string);
+		}
+		case Table: {
+			if (depth >= maxDepth) {
+				throw std::runtime_error("Serialized data is corrupt");
+			}
+
+			uint64_t length = reader.readVarint();
+			// Every value takes at least a byte, so this bounds the allocation
+			reader.need(length);
+			auto table = state.create_table(static_cast<int>(length), 0);
+			for (uint64_t i = 1; i <= length; i++) {
+				table.raw_set(i, read(state, reader, reader.readByte(), codec,
+				                      depth + 1));
+			}
+
+			uint8_t keyTag;
+			while ((keyTag = reader.readByte()) != TableEnd) {
+				auto key = read(state, reader, keyTag, codec, depth + 1);
+				if (key.get_type() == sol::type::lua_nil) {
+					throw std::runtime_error("Serialized data is corrupt");
+				}
+				table.raw_set(key,
+				              read(state, reader, reader.readByte(), codec, depth + 1));
+			}
+			return table;
+		}
+		case VectorValue:
+		case RotMatrixValue: {
+			int count = tag == VectorValue ? 3 : 9;
+			float floats[9];
+			for (int i = 0; i < count; i++) {
+				floats[i] = reader.readRaw<float>();
+			}
+
+			if (codec) {
+				return codec->fromFloats(state, floats, count);
+			}
+
+			auto fields = tag == VectorValue ? vectorFields : rotMatrixFields;
+			auto table = state.create_table(0, count);
+			for (int i = 0; i < count; i++) {
+				table.raw_set(fields[i], floats[i]);
+			}
+			return table;
+		}
+		default:
+			throw std::runtime_error("Serialized data is corrupt");
+	}
+}
+
+sol::object deserialize(sol::state_view state, std::string_view data,
+                        const Codec* codec) {
+	Reader reader{data.data(), data.data() + data.size()};
+	auto value = read(state, reader, reader.readByte(), codec, 0);
+	if (reader.position != reader.end) {
+		throw std::runtime_error("Serialized data is corrupt");
+	}
+	return value;
+}
+
+bool viewString(std::string_view data, std::string_view& string) {
+	Reader reader{data.data(), data.data() + data.size()};
+	if (data.empty() || reader.readByte() != String) {
+		return false;
+	}
+
+	uint64_t length = reader.readVarint();
+	if (static_cast<uint64_t>(reader.end - reader.position) != length) {
+		throw std::runtime_error("Serialized data is corrupt");
+	}
+
+	string = std::string_view(reader.position, length);
+	return true;
+}
+};  // namespace Serializer
@@ -0,0 +1,28 @@
+#pragma once
+#include "sol/sol.hpp"
+
+#include <string>
+#include <string_view>
+
+// Compact binary encoding of Lua values for passing them between states and
+// processes: nil, booleans, numbers, strings and tables of these. A state
+// which has Vector and RotMatrix gives a Codec so they travel as raw floats;
+// without one they are read back as tables with the same fields.
+namespace Serializer {
+struct Codec {
+	// Copies the components of a Vector (3) or RotMatrix (9) into floats and
+	// returns how many there are, or 0 if object is neither
+	int (*toFloats)(const sol::object& object, float* floats);
+	// Makes a Vector or RotMatrix out of count floats
+	sol::object (*fromFloats)(sol::state_view state, const float* floats,
+	                          int count);
+};
+
+void serialize(const sol::object& value, std::string& buffer,
+               const Codec* codec = nullptr);
+sol::object deserialize(sol::state_view state, std::string_view data,
+                        const Codec* codec = nullptr);
+// If data holds a single string, points string at its bytes inside data
+// without copying them
+bool viewString(std::string_view data, std::string_view& string);
+};  // namespace Serializer
@@ -0,0 +1,186 @@
+#include "sharedring.h"
+
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <stdexcept>
+
+// Written in place of a frame where the next one doesn't fit before the end
+static constexpr uint32_t wrapMarker = 0xffffffff;
+
+static uint64_t alignFrame(uint64_t size) { return (size + 7) & ~uint64_t(7); }
+
+static void sleepOn(int eventFD, int timeoutMs) {
+	pollfd pollFD{eventFD, POLLIN, 0};
+	if (poll(&pollFD, 1, timeoutMs) > 0) {
+		eventfd_t value;
+		eventfd_read(eventFD, &value);
+	}
+}
+
+size_t SharedRing::getMappingSize(size_t capacity) {
+	return sizeof(Header) + alignFrame(capacity);
+}
+
+SharedRing::SharedRing(void* memory, size_t capacity, int dataEventFD,
+                       int spaceEventFD)
+    : header(static_cast<Header*>(memory)),
+      data(static_cast<char*>(memory) + sizeof(Header)),
+      capacity(alignFrame(capacity)),
+      dataEventFD(dataEventFD),
+      spaceEventFD(spaceEventFD) {
+	if (!capacity) {
+		throw std::invalid_argument("Shared ring capacity has to be positive");
+	}
+
+	writePosition = header->writePosition.load(std::memory_order_acquire);
+	readPosition = header->readPosition.load(std::memory_order_acquire);
+}
+
+size_t SharedRing::getMaxMessageSize() const {
+	uint64_t size = capacity - sizeof(uint32_t);
+	return size < wrapMarker ? size : wrapMarker - 1;
+}
+
+uint64_t SharedRing::getFreeSpace() {
+	seenReadPosition = header->readPosition.load(std::memory_order_acquire);
+	uint64_t used = writePosition - seenReadPosition;
+	if (used > capacity) {
+		throw std::runtime_error("Shared ring is corrupt");
+	}
+	return capacity - used;
+}
+
+// The position and the other side's waiting flag are sequentially consistent
+// on both sides, so either the sleeper sees the new position before it sleeps
+// or we see its flag and wake it
+void SharedRing::publish(uint64_t position) {
+	writePosition = position;
+	header->writePosition.store(position);
+	if (header->readerWaiting.load()) {
+		eventfd_write(dataEventFD, 1);
+	}
+}
+
+void SharedRing::consume(uint64_t size) {
+	readPosition += size;
+	header->readPosition.store(readPosition);
+	if (header->writerWaiting.load()) {
+		eventfd_write(spaceEventFD, 1);
+	}
+}
+
+bool SharedRing::write(std::string_view message) {
+	if (message.size() > getMaxMessageSize()) {
+		throw std::length_error("Message is larger than the shared ring");
+	}
+
+	uint32_t length = static_cast<uint32_t>(message.size());
+	uint64_t frameSize = alignFrame(sizeof(length) + uint64_t(length));
+
+	uint64_t offset = writePosition % capacity;
+	uint64_t untilEnd = capacity - offset;
+	if (untilEnd < frameSize) {
+		// The marker goes in on its own, so once the reader has passed it the
+		// frame can start at the beginning whatever its size
+		if (getFreeSpace() < untilEnd) {
+			return false;
+		}
+
+		memcpy(data + offset, &wrapMarker, sizeof(wrapMarker));
+		publish(writePosition + untilEnd);
+		offset = 0;
+	}
+
+	if (getFreeSpace() < frameSize) {
+		return false;
+	}
+
+	memcpy(data + offset, &length, sizeof(length));
+	memcpy(data + offset + sizeof(length), message.data(), length);
+	publish(writePosition + frameSize);
+	return true;
+}
+
+bool SharedRing::peek(std::string_view& message) {
+	uint64_t available =
+	    header->writePosition.load(std::memory_order_acquire) - readPosition;
+	if (available > capacity) {
+		throw std::runtime_error("Shared ring is corrupt");
+	}
+	if (!available) {
+		return false;
+	}
+
+	uint64_t offset = readPosition % capacity;
+	uint32_t length;
+	memcpy(&length, data + offset, sizeof(length));
+
+	if (length == wrapMarker) {
+		uint64_t padding = capacity - offset;
+		if (padding > available) {
+			throw std::runtime_error("Shared ring is corrupt");
+		}
+
+		consume(padding);
+		available -= padding;
+		if (!available) {
+			return false;
+		}
+
+		offset = 0;
+		memcpy(&length, data, sizeof(length));
+	}
+
+	// The length comes from the other process, so the frame has to be checked
+	// to lie inside both the ring and what has been written
+	uint64_t frameSize = alignFrame(sizeof(length) + uint64_t(length));
+	if (offset + frameSize > capacity || frameSize > available) {
+		throw std::runtime_error("Shared ring is corrupt");
+	}
+
+	message = std::string_view(data + offset + sizeof(length), length);
+	peekedSize = frameSize;
+	return true;
+}
+
+void SharedRing::skip() {
+	if (!peekedSize) {
+		return;
+	}
+
+	consume(peekedSize);
+	peekedSize = 0;
+}
+
+bool SharedRing::read(std::string& message) {
+	std::string_view view;
+	if (!peek(view)) {
+		return false;
+	}
+
+	message.assign(view);
+	skip();
+	return true;
+}
+
+void SharedRing::wait(int timeoutMs) {
+	std::string_view view;
+	if (peek(view)) {
+		return;
+	}
+
+	header->readerWaiting.store(1);
+	if (header->writePosition.load() == readPosition) {
+		sleepOn(dataEventFD, timeoutMs);
+	}
+	header->readerWaiting.store(0);
+}
+
+void SharedRing::waitForSpace(int timeoutMs) {
+	header->writerWaiting.store(1);
+	if (header->readPosition.load() == seenReadPosition) {
+		sleepOn(spaceEventFD, timeoutMs);
+	}
+	header->writerWaiting.store(0);
+}
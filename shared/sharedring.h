@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Single-producer, single-consumer ring of frames in memory mapped by two
+// processes. Frames never wrap around the end of the ring, so a frame's body
+// can be read where it lies. Each side can sleep on an eventfd, the consumer
+// until something is written and the producer until something is read, which
+// the other side bumps only while it is flagged as sleeping.
+class SharedRing {
+	struct Header {
+		alignas(64) std::atomic<uint64_t> writePosition;
+		alignas(64) std::atomic<uint64_t> readPosition;
+		alignas(64) std::atomic<uint32_t> readerWaiting;
+		std::atomic<uint32_t> writerWaiting;
+	};
+
+	static_assert(std::atomic<uint64_t>::is_always_lock_free,
+	              "Shared positions have to be lock-free");
+
+	Header* header;
+	char* data;
+	uint64_t capacity;
+	int dataEventFD;
+	int spaceEventFD;
+	// Each process keeps its own copy of the position only it moves, so the
+	// other side can't move it from under us
+	uint64_t writePosition;
+	uint64_t readPosition;
+	// Read position the last write found, to tell if anything was read since
+	uint64_t seenReadPosition = 0;
+	// Size of the frame last returned by peek
+	uint64_t peekedSize = 0;
+
+	uint64_t getFreeSpace();
+	void publish(uint64_t position);
+	void consume(uint64_t size);
+
+ public:
+	// Bytes to map for a ring of capacity bytes, which is rounded up to a
+	// multiple of 8
+	static size_t getMappingSize(size_t capacity);
+	// memory has to be getMappingSize(capacity) bytes, zeroed before either
+	// side first uses it. Both sides pass the same two eventfds, dataEventFD
+	// for the consumer to wait on and spaceEventFD for the producer.
+	SharedRing(void* memory, size_t capacity, int dataEventFD, int spaceEventFD);
+
+	size_t getMaxMessageSize() const;
+
+	// Returns false if there is no room for message right now. Positions
+	// the other side left out of range throw std::runtime_error.
+	bool write(std::string_view message);
+	// Points message at the next frame's body without taking it off the ring.
+	// It stays valid until skip() is called. A frame reaching outside the ring
+	// throws std::runtime_error.
+	bool peek(std::string_view& message);
+	void skip();
+	bool read(std::string& message);
+	// Returns once something was written, or after timeoutMs. It can return
+	// early if the eventfd is shared with another ring.
+	void wait(int timeoutMs);
+	// Returns once something was read since write last returned false, or
+	// after timeoutMs. It can return early like wait.
+	void waitForSpace(int timeoutMs);
+};
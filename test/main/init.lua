@@ -5,12 +5,18 @@ end
 
 local function runTests ()
 	require('tests.accounts')
+	require('tests.async')
+	require('tests.benchmark')
 	require('tests.bonds')
 	require('tests.bullets')
+	require('tests.changes')
 	require('tests.chat')
+	require('tests.childProcess')
 	require('tests.crypto')
 	require('tests.events')
+	require('tests.ffi')
 	require('tests.fileWatcher')
+	require('tests.hook')
 	require('tests.http')
 	require('tests.humans')
 	require('tests.image')
@@ -25,9 +31,12 @@ local function runTests ()
 	require('tests.server')
 	require('tests.sqlite')
 	require('tests.streets')
+	require('tests.tickTimer')
 	require('tests.vector')
 	require('tests.vehicles')
 	require('tests.worker')
+	require('tests.workerPool')
+	require('tests.worldSnapshot')
 	require('tests.zlib')
 end
 
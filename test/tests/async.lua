@@ -0,0 +1,35 @@
+local jobs = 'tests.workerPoolJobs'
+
+local future = assert(async.run(jobs, 'add', 2, 3))
+assert(future.class == 'Future')
+assert(not future:isReady())
+assert(not pcall(future.get, future))
+assert(not pcall(async.await, future))
+
+local failing = async.run(jobs, 'fail')
+
+local awaited
+local co = coroutine.wrap(function ()
+	local upper, len = async.await(async.run(jobs, 'hash', 'abc'))
+	awaited = upper .. len
+end)
+co()
+assert(not awaited)
+
+local maxTicks = 20
+local ticks = 0
+
+local function try ()
+	ticks = ticks + 1
+
+	if future:isReady() and failing:isReady() and awaited then
+		assert(future:get() == 5)
+		assert(not pcall(failing.get, failing))
+		assert(awaited == 'ABC3')
+	else
+		assert(ticks < maxTicks)
+		nextTick(try)
+	end
+end
+
+nextTick(try)
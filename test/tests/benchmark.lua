@@ -0,0 +1,65 @@
+local function log (...)
+	local prefix = '\27[34;1m[Benchmark]\27[0m '
+	print(prefix .. string.format(...))
+end
+
+local function measure (iterations, func)
+	local startTime = os.realClock()
+	for _ = 1, iterations do
+		func()
+	end
+	local elapsed = os.realClock() - startTime
+
+	return elapsed / iterations * 1000000
+end
+
+-- Compares reaching a hooked engine function through its trampoline with
+-- removing and reinstalling the detour around the call, as was done before.
+local function compare (name, iterations, func)
+	hook.setUseTrampolines(false)
+	local removing = measure(iterations, func)
+	hook.setUseTrampolines(true)
+	local trampoline = measure(iterations, func)
+
+	log('%s: %.3f µs/call removing the hook, %.3f µs/call through the ' ..
+		'trampoline (%.1fx)', name, removing, trampoline, removing / trampoline)
+end
+
+do
+	local posA = Vector(0, 23.5, 0)
+	local posB = Vector(0, 0, 0)
+
+	local bot = assert(players.createBot())
+	local man = assert(humans.create(
+		posB,
+		RotMatrix(
+			1, 0, 0,
+			0, 1, 0,
+			0, 0, 1
+		),
+		bot
+	))
+
+	-- Detours are only in place while their keys are enabled, without them
+	-- there would be nothing to get past
+	assert(hook.enable('BulletMayHit'))
+	assert(hook.enable('LineIntersectHuman'))
+
+	compare('physics.lineIntersectLevelQuick', 10000, function ()
+		physics.lineIntersectLevelQuick(posA, posB, false)
+	end)
+
+	compare('physics.lineIntersectHumanQuick', 10000, function ()
+		physics.lineIntersectHumanQuick(man, posA, posB, 0.0)
+	end)
+
+	compare('physics.lineIntersectAnyQuick', 10000, function ()
+		physics.lineIntersectAnyQuick(posA, posB, nil, 0.0, false)
+	end)
+
+	assert(hook.disable('BulletMayHit'))
+	assert(hook.disable('LineIntersectHuman'))
+
+	man:remove()
+	bot:remove()
+end
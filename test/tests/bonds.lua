@@ -26,4 +26,25 @@ assert(bond.isActive)
 man:remove()
 bot:remove()
 
-assert(not bond.isActive)
\ No newline at end of file
+assert(not bond.isActive)
+-- Bonds the engine makes itself are picked up by the next tick
+local laterBot = assert(players.createBot())
+local laterMan = assert(humans.create(
+	Vector(30, 30, 30),
+	RotMatrix(
+		1, 0, 0,
+		0, 1, 0,
+		0, 0, 1
+	),
+	laterBot
+))
+
+nextTick(function ()
+	local count = bonds.getCount()
+	assert(count > 0)
+	assert(#bonds.getAll() == count)
+	assert(bonds.getAll()[1].isActive)
+
+	laterMan:remove()
+	laterBot:remove()
+end)
@@ -0,0 +1,54 @@
+assert(not pcall(changes.watch, 'Human', 'notAField'))
+assert(not pcall(changes.watch, 'NotAKind', 'health'))
+assert(#changes.poll() == 0)
+
+local bot = assert(players.createBot())
+local man = assert(humans.create(
+	Vector(),
+	RotMatrix(
+		1, 0, 0,
+		0, 1, 0,
+		0, 0, 1
+	),
+	bot
+))
+
+changes.watch('Human', 'health')
+
+nextTick(function ()
+	local oldHealth = man.health
+	man.health = oldHealth - 10
+
+	nextTick(function ()
+		local found = false
+		for _, change in ipairs(changes.poll()) do
+			if change.entity == man and change.field == 'health' then
+				assert(change.old == oldHealth)
+				assert(change.new == oldHealth - 10)
+				found = true
+			end
+		end
+		assert(found)
+		assert(#changes.poll() == 0)
+
+		-- A new human in the same slot isn't diffed against the last one
+		local index = man.index
+		man:remove()
+		local newMan = assert(humans.create(Vector(), RotMatrix(
+			1, 0, 0,
+			0, 1, 0,
+			0, 0, 1
+		), bot))
+		assert(newMan.index == index)
+
+		nextTick(function ()
+			for _, change in ipairs(changes.poll()) do
+				assert(change.entity ~= newMan)
+			end
+
+			changes.clear()
+			newMan:remove()
+			bot:remove()
+		end)
+	end)
+end)
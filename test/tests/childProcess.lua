@@ -0,0 +1,82 @@
+local ffi = require('ffi')
+
+local script = 'tests/childProcess.satellite.lua'
+
+local piped = assert(ChildProcess.new(script))
+assert(not pcall(piped.peekString, piped))
+for i = 1, 3 do
+	assert(piped:sendMessage(i))
+end
+assert(piped:getQueueStats().sendDropped == 0)
+
+-- The second message doesn't fit before the end of the ring, so it has to
+-- wait for the first to be read and then start over at the beginning
+local shared = assert(ChildProcess.new(script, 1024))
+assert(not pcall(shared.sendMessage, shared, string.rep('x', 2000)))
+shared:sendMessage(string.rep('a', 300))
+shared:sendMessage(string.rep('b', 796))
+shared:sendMessage({ pos = Vector(1, 2, 3) })
+
+local maxTicks = 300
+local ticks = 0
+local pipedReceived = {}
+local sharedStep = 1
+-- Several times the ring, so the satellite has to sleep until we read some
+local burstLength = 50
+local burstReceived = 0
+
+local function try ()
+	ticks = ticks + 1
+
+	for _, message in ipairs(piped:receiveMessages(10)) do
+		table.insert(pipedReceived, message)
+	end
+
+	if sharedStep == 1 then
+		local address, length = shared:peekString()
+		if address then
+			assert(length == 300)
+			local bytes = ffi.cast('const char*', address)
+			assert(ffi.string(bytes, length) == string.rep('a', 300))
+			shared:skipMessage()
+			sharedStep = 2
+		end
+	elseif sharedStep == 2 then
+		local message = shared:receiveMessage()
+		if message then
+			assert(message == string.rep('b', 796))
+			sharedStep = 3
+		end
+	elseif sharedStep == 3 then
+		local message = shared:receiveMessage()
+		if message then
+			-- The satellite has no Vector, so it comes back as a table
+			assert(message.pos.x == 1 and message.pos.z == 3)
+			shared:sendMessage({ burst = burstLength })
+			sharedStep = 4
+		end
+	elseif sharedStep == 4 then
+		for _, message in ipairs(shared:receiveMessages(10)) do
+			burstReceived = burstReceived + 1
+			assert(message == string.rep('c', 100) .. burstReceived)
+		end
+		if burstReceived == burstLength then
+			sharedStep = 5
+		end
+	end
+
+	if #pipedReceived == 3 and sharedStep == 5 then
+		for i = 1, 3 do
+			assert(pipedReceived[i] == i)
+		end
+
+		piped:sendMessage('stop')
+		shared:sendMessage('stop')
+		return
+	end
+
+	assert(ticks < maxTicks)
+	nextTick(try)
+end
+
+nextTick(try)
@@ -0,0 +1,13 @@
+while true do
+	waitForMessage(1000)
+	local message = receiveMessage()
+	if message == 'stop' then
+		break
+	elseif type(message) == 'table' and message.burst then
+		for i = 1, message.burst do
+			sendMessage(string.rep('c', 100) .. i)
+		end
+	elseif message ~= nil then
+		sendMessage(message)
+	end
+end
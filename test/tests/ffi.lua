@@ -0,0 +1,60 @@
+local ffi = require('ffi')
+
+assert(ffi.sizeof('Human') == 28664)
+assert(ffi.sizeof('Item') == 7040)
+assert(ffi.C.maxNumberOfHumans == 256)
+
+local bot = assert(players.createBot())
+local cBot = ffi.players[bot.index]
+
+assert(cBot.active == 1)
+assert(cBot.isBot == 1)
+assert(ffi.string(cBot.name) == 'Bot')
+
+cBot.phoneNumber = 2565678
+assert(bot.phoneNumber == 2565678)
+
+bot.money = 1234
+assert(cBot.money == 1234)
+
+bot:remove()
+assert(cBot.active == 0)
+
+do
+	local a = ffi.Vector(1, 2, 3)
+	local b = Vector(4, 5, 6)
+
+	assert(a.class == 'Vector')
+	assert(tostring(a) == tostring(Vector(1, 2, 3)))
+
+	local sum = a + b
+	assert(sum.x == 5 and sum.y == 7 and sum.z == 9)
+
+	local scaled = a * 2
+	assert(scaled.x == 2 and scaled.y == 4 and scaled.z == 6)
+
+	assert(a:dot(b) == b:dot(a))
+	assert(a:dist(b) == b:dist(a))
+	assert(a:lengthSquare() == 14)
+
+	local x, y, z = ffi.Vector(-5, 9, 4):getBlockPos()
+	assert(x == -1 and y == 2 and z == 1)
+
+	local usertypeSum = b + a
+	assert(usertypeSum.x == 5 and usertypeSum.y == 7 and usertypeSum.z == 9)
+
+	b:set(a)
+	assert(b.x == 1 and b.y == 2 and b.z == 3)
+end
+
+do
+	local rot = ffi.RotMatrix(1, 0, 0, 0, 1, 0, 0, 0, 1)
+	local forward = rot:getForward()
+	assert(forward.x == 1 and forward.y == 0 and forward.z == 0)
+
+	local rotated = ffi.Vector(1, 2, 3) * rot
+	assert(rotated.x == 1 and rotated.y == 2 and rotated.z == 3)
+
+	local product = rot * RotMatrix(0, 1, 0, 1, 0, 0, 0, 0, 1)
+	assert(product.y1 == 1 and product.x2 == 1)
+end
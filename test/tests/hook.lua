@@ -0,0 +1,146 @@
+assert(not hook.enable('NotARealHook'))
+assert(not hook.disable('NotARealHook'))
+
+-- Toggling installs and removes the detours, so do it a few times over
+for _ = 1, 3 do
+	assert(hook.enable('PlayerAI'))
+	assert(hook.enable('PostPacketBuilding'))
+	assert(hook.enable('AccountTicketBegin'))
+	assert(hook.enable('AccountTicket'))
+
+	assert(hook.disable('PlayerAI'))
+	assert(hook.disable('PacketBuilding'))
+	assert(hook.disable('AccountTicketBegin'))
+	assert(hook.disable('AccountTicket'))
+end
+
+do
+	local bot = players.createBot()
+
+	assert(hook.enable('PlayerAI'))
+	nextTick(function ()
+		assert(hook.disable('PlayerAI'))
+		bot:remove()
+	end)
+end
+
+for _, name in ipairs({
+	'BulletCreateBatch',
+	'CollideBodiesBatch',
+	'EventUpdateVehicleBatch',
+	'EventSoundBatch',
+	'EventBulletBatch',
+	'EventBulletHitBatch'
+}) do
+	assert(hook.enable(name))
+	assert(hook.disable(name))
+end
+
+do
+	local groundLevel = 11.75
+	local hits
+	local function onBulletHitBatch (batch)
+		hits = batch
+	end
+
+	-- Fired straight down, so the engine's own bullet simulation makes the hit
+	assert(hook.add('EventBulletHitBatch', onBulletHitBatch))
+	assert(bullets.create(0, Vector(0, groundLevel + 1, 0), Vector(0, -2, 0)))
+
+	local maxTicks = 30
+	local ticks = 0
+
+	local function try ()
+		ticks = ticks + 1
+
+		if not hits then
+			assert(ticks < maxTicks)
+			nextTick(try)
+			return
+		end
+
+		assert(hook.remove('EventBulletHitBatch', onBulletHitBatch))
+
+		assert(hits.count >= 1)
+		for _, column in ipairs({
+			'hitType', 'posX', 'posY', 'posZ', 'normalX', 'normalY', 'normalZ'
+		}) do
+			assert(#hits[column] == hits.count)
+		end
+
+		assert(math.abs(hits.posX[1]) < 0.1)
+		assert(math.abs(hits.posY[1] - groundLevel) < 0.1)
+		assert(math.abs(hits.posZ[1]) < 0.1)
+		assert(hits.normalY[1] > 0.99)
+	end
+
+	nextTick(try)
+end
+
+do
+	local bot = players.createBot()
+	local calls = 0
+	local function onPlayerAI () calls = calls + 1 end
+
+	-- Waits for the block above to have disabled PlayerAI
+	nextTick(function ()
+		assert(hook.add('PlayerAI', onPlayerAI))
+
+		nextTick(function ()
+			assert(calls >= 1)
+			assert(hook.remove('PlayerAI', onPlayerAI))
+			hook.resetStats()
+
+			nextTick(function ()
+				-- Removing the last handler took the detour out again
+				assert(not hook.getStats().PlayerAI)
+				bot:remove()
+			end)
+		end)
+	end, 2)
+end
+
+assert(not hook.add('NotARealHook', function () end))
+assert(not hook.remove('Logic', function () end))
+
+do
+	local order = {}
+	local function late () table.insert(order, 'late') end
+	local function early () table.insert(order, 'early') end
+	local function first () table.insert(order, 'first') end
+
+	assert(hook.add('Logic', late, 10))
+	assert(hook.add('Logic', early))
+	assert(hook.add('Logic', first, -10))
+
+	nextTick(function ()
+		assert(order[1] == 'first')
+		assert(order[2] == 'early')
+		assert(order[3] == 'late')
+
+		assert(hook.remove('Logic', late))
+		assert(hook.remove('Logic', early))
+		assert(hook.remove('Logic', first))
+		assert(not hook.remove('Logic', first))
+	end)
+end
+
+do
+	hook.resetStats()
+
+	nextTick(function ()
+		local logic = hook.getStats().Logic
+		assert(logic)
+		assert(logic.calls >= 1)
+		assert(logic.maxMicroseconds <= logic.totalMicroseconds)
+		assert(#logic.histogram == 16)
+
+		local bucketed = 0
+		for _, count in ipairs(logic.histogram) do
+			bucketed = bucketed + count
+		end
+		assert(bucketed == logic.calls)
+
+		hook.printStats()
+	end)
+end
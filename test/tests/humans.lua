@@ -21,6 +21,52 @@ assert(humans[0] == man)
 assert(humans.getCount() == 1)
 assert(#humans == 1)
 
+assert(humans.getInRadius(Vector(), 5)[1] == man)
+assert(#humans.getInRadius(Vector(100, 0, 100), 5) == 0)
+assert(humans.getInBox(Vector(-5, -5, -5), Vector(5, 5, 5))[1] == man)
+assert(#humans.getInBox(Vector(10, -5, 10), Vector(20, 5, 20)) == 0)
+assert(humans.getInRadius(Vector(), 1e6)[1] == man)
+assert(humans.getInRadius(Vector(), math.huge)[1] == man)
+assert(#humans.getInRadius(Vector(0 / 0, 0, 0), 5) == 0)
+assert(humans.getInBox(Vector(-math.huge, -5, -math.huge),
+	Vector(math.huge, 5, math.huge))[1] == man)
+assert(humans.getNearest(Vector(100, 0, 100), 1)[1] == man)
+assert(#humans.getNearest(Vector(), 0) == 0)
+
+man.pos = Vector(100, 0, 100)
+assert(humans.getInRadius(Vector(100, 0, 100), 5)[1] == man)
+assert(#humans.getInRadius(Vector(), 5) == 0)
+
+do
+	local ffi = require('ffi')
+	ffi.humans[man.index].pos.x = 0
+	ffi.humans[man.index].pos.z = 0
+	physics.markSpatialIndexStale()
+end
+
+assert(humans.getInRadius(Vector(), 5)[1] == man)
+
+do
+	local ffi = require('ffi')
+
+	local data, count = humans.gather({ 'leftArmHP', 'pos' })
+	assert(count == 1)
+	assert(#data == 4 * 5)
+
+	local ints = ffi.cast('const int32_t*', data)
+	local floats = ffi.cast('const float*', data)
+	assert(ints[0] == man.index)
+	assert(ints[1] == 24)
+	assert(floats[2] == man.pos.x)
+
+	local bones, boneCount = humans.gatherBones({ 'pos' })
+	assert(boneCount == 1)
+	assert(#bones == 4 + 16 * 4 * 3)
+	assert(ffi.cast('const float*', bones)[1] == man:getBone(0).pos.x)
+
+	assert(not pcall(humans.gather, { 'notAField' }))
+end
+
 man:teleport(Vector(0, 30, 0))
 
 assertAddsEvent(function ()
@@ -6,4 +6,17 @@ assert(#itemTypes == expectedNum)
 assert(itemTypes[0])
 
 itemTypes[0].price = 420
-assert(itemTypes[0].price == 420)
\ No newline at end of file
+assert(itemTypes[0].price == 420)
+do
+	local type = itemTypes[1]
+	local name = type.name
+	assert(itemTypes.getByName(name) == type)
+
+	type.name = 'Renamed'
+	assert(not itemTypes.getByName(name))
+	assert(itemTypes.getByName('Renamed') == type)
+
+	type.name = name
+	assert(itemTypes.getByName(name) == type)
+	assert(not itemTypes.getByName('Renamed'))
+end
@@ -13,7 +13,36 @@ local item = assert(items.create(
 	)
 ))
 assert(item.isActive)
+assert(items.getCount() == 1)
+assert(items.getAll()[1] == item)
+
+do
+	local count = 0
+	for index, other in items.iterActive() do
+		assert(index == item.index)
+		assert(other == item)
+		count = count + 1
+	end
+	assert(count == 1)
+
+	local first = select(2, items.iterActive()(nil, -1))
+	local second = select(2, items.iterActive()(nil, -1))
+	assert(rawequal(first, second))
+
+	local iterate = items.iterActive()
+	assert(not pcall(iterate, nil, -2))
+	assert(not pcall(iterate, nil, 1024))
+	assert(not iterate(nil, 1023))
+end
+
+item.data.test = 1
+assert(item.data.test == 1)
+assert(rawequal(item.data, item.data))
+
 item:remove()
+assert(items.getCount() == 0)
+assert(#items.getAll() == 0)
+assert(not items.iterActive()(nil, -1))
 
 item = assert(items.create(
 	itemTypes[1],
@@ -27,6 +56,7 @@ item = assert(items.create(
 ))
 assert(item.isActive)
 assert(item.rigidBody.vel:dist(Vector(1, 0, 0)) == 0)
+assert(item.data.test == nil)
 
 item.despawnTime = 420
 assert(item.despawnTime == 420)
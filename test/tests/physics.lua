@@ -22,6 +22,27 @@ do
 	assert(fraction == 0.5)
 end
 
+do
+	local results = physics.lineIntersectBatch({
+		0, airLevel, 0, 0, 0, 0,
+		0, airLevel, 0, 0, airLevel + 10, 0
+	}, { humans = false, vehicles = false })
+
+	assert(results.count == 2)
+
+	assert(results.type[1] == 1)
+	assert(results.index[1] == -1)
+	assert(results.fraction[1] == 0.5)
+	assert(results.normal[1] == 0)
+	assert(results.normal[2] == 1)
+	assert(results.normal[3] == 0)
+
+	assert(results.type[2] == 0)
+	assert(results.fraction[2] == 1)
+
+	assert(not pcall(physics.lineIntersectBatch, { 0, 0, 0 }))
+end
+
 nextTick(function ()
 	do
 		local bot = players.createBot()
@@ -99,6 +120,64 @@ nextTick(function ()
 			vehicle:remove()
 		end)
 	end
+
+	do
+		local bot = players.createBot()
+		local man = assert(humans.create(
+			Vector(64, airLevel, 64),
+			RotMatrix(
+				1, 0, 0,
+				0, 1, 0,
+				0, 0, 1
+			),
+			bot
+		))
+
+		nextTick(function ()
+			local object, fraction = physics.lineIntersectAnyQuick(
+				Vector(-100, airLevel, 64),
+				Vector(100, airLevel, 64),
+				nil,
+				0.0,
+				false
+			)
+
+			assert(object == man)
+			assert(fraction > 0.5)
+
+			object = physics.lineIntersectAnyQuick(
+				Vector(-100, airLevel, 64),
+				Vector(100, airLevel, 64),
+				man,
+				0.0,
+				false
+			)
+
+			assert(object ~= man)
+
+			object = physics.lineIntersectAnyQuick(
+				Vector(-100, airLevel, 74),
+				Vector(100, airLevel, 74),
+				nil,
+				0.0,
+				false
+			)
+
+			assert(object ~= man)
+
+			local results = physics.lineIntersectBatch({
+				-100, airLevel, 64, 100, airLevel, 64,
+				-100, airLevel, 74, 100, airLevel, 74
+			})
+
+			assert(results.type[1] == 2)
+			assert(results.index[1] == man.index)
+			assert(results.index[2] ~= man.index)
+
+			man:remove()
+			bot:remove()
+		end)
+	end
 end)
 
 local outPosition = Vector()
@@ -13,6 +13,12 @@ assert(bot.phoneNumber == testPhone)
 
 assert(players[0] == bot)
 assert(players.getByPhone(testPhone) == bot)
+
+bot.phoneNumber = testPhone + 1
+assert(not players.getByPhone(testPhone))
+assert(players.getByPhone(testPhone + 1) == bot)
+bot.phoneNumber = testPhone
+assert(players.getByPhone(testPhone) == bot)
 assert(#players.getNonBots() == 0)
 assert(players.getCount() == 1)
 assert(#players == 1)
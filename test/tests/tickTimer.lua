@@ -0,0 +1,28 @@
+local startCount = tickTimer.getTickCount()
+
+assert(tickTimer.budget > 16000 and tickTimer.budget < 17000)
+assert(tickTimer.getOverrunCount() <= startCount)
+
+nextTick(function ()
+	assert(tickTimer.getTickCount() > startCount)
+
+	local percentiles = tickTimer.getPercentiles()
+	for _, name in ipairs({
+		'ServerReceive',
+		'Logic',
+		'Gamemode',
+		'Traffic',
+		'Physics',
+		'RigidBodies',
+		'Bullets',
+		'ServerSend',
+		'Total'
+	}) do
+		local section = assert(percentiles[name])
+		assert(section.p50 >= 0)
+		assert(section.p50 <= section.p95)
+		assert(section.p95 <= section.p99)
+	end
+
+	assert(percentiles.Logic.p99 <= percentiles.Total.p99)
+end, 3)
@@ -0,0 +1 @@
+while not sleep(1000) do end
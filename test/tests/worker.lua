@@ -1,21 +1,67 @@
 local worker = assert(Worker.new('tests/worker.worker.lua'))
 
 assert(not worker:receiveMessage())
-worker:sendMessage('hi')
+assert(worker:sendMessage('hi'))
+assert(not pcall(worker.sendMessage, worker, 'hi', 'notAMode'))
+assert(not pcall(worker.sendMessage, worker, { print }))
+assert(worker:sendMessage({
+	1.5,
+	'two',
+	nested = { pos = Vector(1, 2, 3), flag = true },
+	[-7] = RotMatrix(1, 0, 0, 0, 1, 0, 0, 0, 1)
+}))
+
+do
+	local stats = worker:getQueueStats()
+	assert(stats.sendDropped == 0)
+	assert(stats.receiveDropped == 0)
+	assert(stats.capacity == 2048)
+end
+
+do
+	-- Nothing reads from this one, so its queue fills up
+	local idle = assert(Worker.new('tests/worker.idle.lua'))
+	local capacity = idle:getQueueStats().capacity
+	for i = 1, capacity do
+		assert(idle:sendMessage(i, 'fail'))
+	end
+
+	assert(not idle:sendMessage(0, 'fail'))
+	assert(not idle:sendMessage(0, 'block', 5))
+	assert(idle:sendMessage(0))
+
+	local stats = idle:getQueueStats()
+	assert(stats.sendDepth == capacity)
+	assert(stats.sendDropped == 3)
+
+	idle:stop()
+	assert(not idle:sendMessage(0, 'block'))
+end
 
 local maxTicks = 10
 local ticks = 0
+local gotHello = false
 
 local function try ()
 	ticks = ticks + 1
 
-	local message = worker:receiveMessage()
-	if message then
-		assert(message == 'hello')
-	else
-		assert(ticks < maxTicks)
-		nextTick(try)
+	while worker:hasMessages() do
+		local message = worker:receiveMessage()
+		if not gotHello then
+			assert(message == 'hello')
+			gotHello = true
+		else
+			assert(message[1] == 1.5)
+			assert(message[2] == 'two')
+			assert(message.nested.pos:dist(Vector(1, 2, 3)) == 0)
+			assert(message.nested.flag == true)
+			assert(message[-7].y2 == 1)
+			return
+		end
 	end
+
+	assert(ticks < maxTicks)
+	nextTick(try)
 end
 
 nextTick(try)
\ No newline at end of file
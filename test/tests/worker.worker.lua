@@ -1,7 +1,11 @@
 while true do
-	if receiveMessage() == 'hi' then
+	local message, stopped = receiveMessage(1000)
+	if stopped then
+		break
+	elseif message == 'hi' then
 		sendMessage('hello')
+	elseif type(message) == 'table' then
+		sendMessage(message)
 		break
 	end
-	sleep(8)
-end
\ No newline at end of file
+end
@@ -0,0 +1,100 @@
+assert(not pcall(WorkerPool.new, 0))
+
+local pool = assert(WorkerPool.new(2))
+local jobs = 'tests.workerPoolJobs'
+
+assert(not pool:receiveResult())
+assert(not pcall(pool.submit, pool, jobs, 'add', print))
+
+local expected = {
+	[pool:submit(jobs, 'add', 2, 3)] = function (ok, sum)
+		assert(ok)
+		assert(sum == 5)
+	end,
+	[pool:submit(jobs, 'hash', 'abc')] = function (ok, upper, len)
+		assert(ok)
+		assert(upper == 'ABC')
+		assert(len == 3)
+	end,
+	[pool:submit(jobs, 'offset', { 1, 2, name = 'points' }, Vector(1, 2, 3))] =
+		function (ok, offsets)
+			assert(ok)
+			assert(offsets.name == 'points')
+			assert(offsets[1].class == 'Vector')
+			assert(offsets[1]:dist(Vector(2, 3, 4)) == 0)
+			assert(offsets[2]:dist(Vector(3, 4, 5)) == 0)
+		end,
+	[pool:submit(jobs, 'fail')] = function (ok, message)
+		assert(not ok)
+		assert(message:find('failed on purpose'))
+	end,
+	[pool:submit(jobs, 'missing')] = function (ok)
+		assert(not ok)
+	end,
+}
+
+local remaining = 5
+local maxTicks = 20
+local ticks = 0
+
+local function try ()
+	ticks = ticks + 1
+
+	while true do
+		local id, ok, a, b = pool:receiveResult()
+		if not id then break end
+
+		expected[id](ok, a, b)
+		expected[id] = nil
+		remaining = remaining - 1
+	end
+
+	if remaining == 0 then
+		assert(pool:getNumDroppedResults() == 0)
+		pool:stop()
+	else
+		assert(ticks < maxTicks)
+		nextTick(try)
+	end
+end
+
+nextTick(try)
+
+do
+	-- More results than are kept waiting: every job is still reported, and
+	-- the ones past the limit fail
+	local flooded = assert(WorkerPool.new(1))
+	local numJobs = 2100
+	for i = 1, numJobs do
+		flooded:submit(jobs, 'add', i, i)
+	end
+
+	local received = 0
+	local failed = 0
+	local floodTicks = 0
+
+	local function drain ()
+		floodTicks = floodTicks + 1
+
+		while true do
+			local id, ok, value = flooded:receiveResult()
+			if not id then break end
+
+			received = received + 1
+			if not ok then
+				assert(value:find('dropped'))
+				failed = failed + 1
+			end
+		end
+
+		if received == numJobs then
+			assert(failed == flooded:getNumDroppedResults())
+			flooded:stop()
+		else
+			assert(floodTicks < maxTicks)
+			nextTick(drain)
+		end
+	end
+
+	nextTick(drain)
+end
@@ -0,0 +1,23 @@
+local jobs = {}
+
+function jobs.add(a, b)
+	return a + b
+end
+
+function jobs.hash(text)
+	return text:upper(), #text
+end
+
+function jobs.offset(points, by)
+	local offsets = { name = points.name }
+	for i, point in ipairs(points) do
+		offsets[i] = Vector(point, point, point) + by
+	end
+	return offsets
+end
+
+function jobs.fail()
+	error('failed on purpose')
+end
+
+return jobs
@@ -0,0 +1,54 @@
+local bot = assert(players.createBot())
+local man = assert(humans.create(
+	Vector(10, 20, 30),
+	RotMatrix(
+		1, 0, 0,
+		0, 1, 0,
+		0, 0, 1
+	),
+	bot
+))
+
+nextTick(function ()
+	local frame = assert(worldSnapshot.acquire())
+	local sequence = frame.sequence
+
+	local found = false
+	for i = 0, frame.numHumans - 1 do
+		local state = frame.humans[i]
+		if state.index == man.index then
+			assert(state.playerID == bot.index)
+			assert(state.health == man.health)
+			found = true
+		end
+	end
+	assert(found)
+
+	nextTick(function ()
+		-- The pinned frame is not overwritten
+		assert(frame.sequence == sequence)
+		worldSnapshot.release(frame)
+
+		nextTick(function ()
+			local latest = assert(worldSnapshot.acquire())
+			assert(latest.sequence > sequence)
+			worldSnapshot.release(latest)
+			assert(not pcall(worldSnapshot.release, latest))
+
+			-- Dropped without a release, so only collection lets go of it
+			local leakedSequence = assert(worldSnapshot.acquire()).sequence
+			collectgarbage()
+
+			nextTick(function ()
+				nextTick(function ()
+					local frame = assert(worldSnapshot.acquire())
+					assert(frame.sequence >= leakedSequence + 2)
+					worldSnapshot.release(frame)
+
+					man:remove()
+					bot:remove()
+				end)
+			end)
+		end)
+	end)
+end)